@@ -0,0 +1,666 @@
+// Host benchmark for the NFC path: the unmodified MFRC522 library and src/NfcStorage.cpp
+// against the register-level emulator in lib/MFRC522Emulator.
+//
+//   pio run -e native_emu -t exec                         blank MIFARE Classic 1K
+//   .pio/build/native_emu/program card.bin [out.bin]      card image (raw 320/1024/4096 byte dump)
+//
+// Every phase prints simulated time, SPI traffic and RF time and checks what it read back. The first phase that
+// fails is named and the program exits with 1.
+#include <Arduino.h>
+#include <SPI.h>
+#include <EEPROM.h>
+#include <stdio.h>
+#include <MFRC522.h>
+#include <MFRC522Extended.h>
+#include <MFRC522Pool.h>
+#include <MFRC522Emulator.h>
+#include <VirtualMifareClassic.h>
+#include <VirtualNtag21x.h>
+#include <VirtualIsoDepCard.h>
+#include "NfcStorage.h"
+
+#define RST_PIN 5
+#define SS_PIN 53
+
+MFRC522 mfrc522(SS_PIN, RST_PIN);
+MFRC522::MIFARE_Key key;
+MFRC522::MIFARE_Key keyDictionary[KEY_DICTIONARY_SIZE] = {
+    {{0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}},
+    {{0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5}},
+    {{0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7}},
+    {{0x00, 0x00, 0x00, 0x00, 0x00, 0x00}}
+};
+byte ntag_password[4] = {0x12, 0x34, 0x56, 0x78};
+byte aes_key[16] = {0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37,
+                    0x38, 0x39, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46};
+
+static MFRC522Emulator reader(SS_PIN, RST_PIN);
+
+struct Sample {
+    uint64_t nanos;
+    host::SpiStats spi;
+    MFRC522Emulator::Stats pcd;
+};
+
+static Sample sample(const MFRC522Emulator &pcd = reader) {
+    Sample s;
+    s.nanos = host::nanos();
+    s.spi = host::spiStats();
+    s.pcd = pcd.stats();
+    return s;
+}
+
+static void reportSession(const char *phase) {
+    printf("%-22s %5u authentications %5u block reads %5u block writes %6u B/s\n",
+           phase,
+           classicSession.stats().authentications,
+           classicSession.stats().blockReads,
+           classicSession.stats().blockWrites,
+           classicSession.bytesPerSecond());
+}
+
+static void reportNtagSession(const char *phase) {
+    printf("%-22s %5u PWD_AUTH        %5u FAST_READ   %5u page writes  %6u B/s\n",
+           phase,
+           ntagSession.stats().authentications,
+           ntagSession.stats().fastReads,
+           ntagSession.stats().pageWrites,
+           ntagSession.bytesPerSecond());
+}
+
+static void reportKeys(const char *phase, const MifareKeyResolver &resolver) {
+    printf("%-22s %5u cache hits    %5u walks       %5u attempts     %5u failed\n",
+           phase,
+           resolver.stats().hits,
+           resolver.stats().walks,
+           resolver.stats().attempts,
+           resolver.stats().failures);
+}
+
+static void report(const char *phase, const Sample &from, const MFRC522Emulator &pcd = reader) {
+    const Sample to = sample(pcd);
+    printf("%-22s %9.3f ms  spi: %5u transactions %5u frames %6u bytes  rf: %8.3f ms %4u frames %3u timeouts\n",
+           phase,
+           (to.nanos - from.nanos) / 1e6,
+           to.spi.transactions - from.spi.transactions,
+           to.pcd.spiFrames - from.pcd.spiFrames,
+           to.spi.bytes - from.spi.bytes,
+           (to.pcd.rfNanos - from.pcd.rfNanos) / 1e6,
+           to.pcd.rfFrames - from.pcd.rfFrames,
+           to.pcd.rfTimeouts - from.pcd.rfTimeouts);
+}
+
+// Same polling as STATE_WAITING_READ/WRITE in main.cpp.
+static bool waitForCard() {
+    for (int i = 0; i < 1000; i++) {
+        if (pollCardInteraction()) {
+            return true;
+        }
+        delay(1);
+    }
+    return false;
+}
+
+// Batch process step: writes the password passed as context.
+static bool provisionCard(void *context) {
+    const char *password = (const char *)context;
+    return writeUserDataToNfc(DATA_TYPE_PASSWORD_ENC, (byte *)password, strlen(password));
+}
+
+// Enrollment station: every reader detects its card, reads blocks 4 and 5 and halts it.
+static const byte STATION_READERS = 3;
+static const byte STATION_ROUNDS = 10;
+static MFRC522Pool pool;
+static byte stationBuffer[STATION_READERS][18];
+static uint16_t stationCards;
+static bool stationOk = true;
+
+static void stationStep(byte index, MFRC522Pool::Operation operation, MFRC522::StatusCode status, void *context) {
+    stationOk = stationOk && status == MFRC522::STATUS_OK;
+    if (context) {
+        pool.halt(index, stationStep);  // Five steps, the queue holds four
+    }
+    if (operation == MFRC522Pool::OP_HALT) {
+        stationCards++;
+    }
+}
+
+static bool stationCardBlocking(MFRC522 &station, byte buffer[18]) {
+    byte size = 18;
+    bool ok = station.PICC_IsNewCardPresent() && station.PICC_ReadCardSerial() &&
+              station.PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, 7, &key, &station.uid) == MFRC522::STATUS_OK &&
+              station.MIFARE_Read(4, buffer, &size) == MFRC522::STATUS_OK;
+    size = 18;
+    ok = ok && station.MIFARE_Read(5, buffer, &size) == MFRC522::STATUS_OK;
+    station.PICC_HaltA();
+    station.PCD_StopCrypto1();
+    return ok;
+}
+
+// A field reset stands in for the next card on the reader.
+static void stationNextCard(MFRC522 &station) {
+    station.PCD_AntennaOff();
+    station.PCD_AntennaOn();
+}
+
+// Shared by the phases: the card that stays with the main reader, the password written to it and the vault
+// entry the later vault phases update.
+static VirtualMifareClassic *card;
+static const char password[] = "correct horse battery staple 0123456789";
+static const uint16_t passwordLength = sizeof(password) - 1;
+static int vaultIndex = -1;
+
+// The card is taken away and presented again, for example after it was halted.
+static void presentAgain(VirtualPicc *picc) {
+    reader.removePicc(picc);
+    reader.addPicc(picc);
+}
+
+// The password on the blank card, then the card is halted.
+static bool blankCardWrite() {
+    Sample start = sample();
+    bool ok = waitForCard();
+    report("detect + select", start);
+
+    start = sample();
+    ok = ok && writeUserDataToNfc(DATA_TYPE_PASSWORD_ENC, (byte *)password, passwordLength);
+    report("writeUserDataToNfc", start);
+    reportSession("  session");
+
+    start = sample();
+    finalizeCardInteraction();
+    report("halt", start);
+    return ok;
+}
+
+// The password read back, written again in the same session and the halted card selected again.
+static bool readBackAndRewrite() {
+    // A halted card only answers WUPA, the sketch expects it to be taken away and presented again.
+    reader.removePicc(card);
+    delay(500);
+    reader.addPicc(card);
+
+    Sample start = sample();
+    bool ok = waitForCard();
+    report("detect + select", start);
+
+    byte dataType;
+    uint16_t dataLength;
+    byte buffer[MAX_PAYLOAD_SIZE];
+    start = sample();
+    const int bytesRead = ok ? readUserDataFromNfc(&dataType, &dataLength, buffer, sizeof(buffer)) : -1;
+    report("readUserDataFromNfc", start);
+    ok = ok && bytesRead == passwordLength && dataType == DATA_TYPE_PASSWORD_ENC && memcmp(buffer, password, passwordLength) == 0;
+
+    // Read-then-write on the same card: the session still has the last sector of the read open.
+    start = sample();
+    ok = ok && writeUserDataToNfc(DATA_TYPE_PASSWORD_ENC, (byte *)password, passwordLength);
+    report("rewrite, same card", start);
+    reportSession("  session (read+write)");
+    finalizeCardInteraction();
+
+    // The halted card is still in the field, as after the "Overwrite?" prompt in main.cpp.
+    start = sample();
+    ok = ok && reconnectCardInteraction();
+    report("reselect (WUPA + SELECT)", start);
+    finalizeCardInteraction();
+    return ok;
+}
+
+// A marginal card: answers get lost in the middle of the payload read and of the write, twice in a row on the write.
+// The session selects the card again, authenticates the sector of the failed block and resumes with it.
+// The write is a new password of the same length, the same one again would only be read back and compared.
+static bool lostAnswers() {
+    const char changedPassword[] = "Correct Horse Battery Staple 0123456789";
+    byte dataType;
+    uint16_t dataLength;
+    byte retryBuffer[MAX_PAYLOAD_SIZE];
+    const Sample start = sample();
+    bool ok = reconnectCardInteraction();
+    card->dropAnswers(1, 3);
+    const int retryBytesRead = ok ? readUserDataFromNfc(&dataType, &dataLength, retryBuffer, sizeof(retryBuffer)) : -1;
+    ok = ok && retryBytesRead == passwordLength && memcmp(retryBuffer, password, passwordLength) == 0;
+    card->dropAnswers(2, 8);
+    ok = ok && writeUserDataToNfc(DATA_TYPE_PASSWORD_ENC, (byte *)changedPassword, passwordLength);
+    report("read + write, 3 lost", start);
+    printf("  retries  %9u retried %5u reselects %5u failed\n",
+           classicSession.retryStats().retries,
+           classicSession.retryStats().reselects,
+           classicSession.retryStats().failures);
+    ok = ok && classicSession.retryStats().retries == 3 && classicSession.retryStats().failures == 0;
+    finalizeCardInteraction();
+    return ok;
+}
+
+// Waiting with no card in the field, then one arrives: the field is only on for the REQA bursts.
+static bool waitWithoutCard() {
+    reader.removePicc(card);
+    cardDetector.resetStats();
+    const Sample start = sample();
+    const uint64_t fieldFrom = reader.fieldNanos();
+    bool ok = true;
+    for (int i = 0; i < 700; i++) {
+        if (pollCardInteraction()) {
+            ok = false;
+        }
+        delay(1);
+    }
+    reader.addPicc(card);
+    ok = ok && waitForCard();
+    report("wait 700 ms + detect", start);
+    printf("  detector %9u bursts %5u REQA  field on %8.3f ms  duty %3u permille  detect %.3f ms\n",
+           cardDetector.stats().bursts,
+           cardDetector.stats().requests,
+           (reader.fieldNanos() - fieldFrom) / 1e6,
+           cardDetector.rfDutyPermille(),
+           cardDetector.stats().lastDetectMicros / 1e3);
+    finalizeCardInteraction();
+    return ok;
+}
+
+// A stack of cards on the reader: one inventory, then every card gets the password.
+// The first card is put back on the stack, halted cards are not part of the inventory.
+static bool batchProvision() {
+    presentAgain(card);
+    const uint8_t stackUids[3][7] = {{0xDE, 0xAD, 0xBE, 0xEE}, {0x12, 0x34, 0x56, 0x78}, {0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66}};
+    VirtualMifareClassic *stack[3];
+    for (byte i = 0; i < 3; i++) {
+        stack[i] = new VirtualMifareClassic(VirtualMifareClassic::CLASSIC_1K, stackUids[i], i == 2 ? 7 : 4);
+        reader.addPicc(stack[i]);
+    }
+    const Sample start = sample();
+    const byte provisioned = processAllCards(provisionCard, (void *)password);
+    report("batch provision 4 cards", start);
+    const double batchSeconds = (sample().nanos - start.nanos) / 1e9;
+    printf("  batch    %9u cards  %8.0f cards/min\n", provisioned, provisioned / batchSeconds * 60);
+    for (byte i = 0; i < 3; i++) {
+        reader.removePicc(stack[i]);
+        delete stack[i];
+    }
+    return provisioned == 4;
+}
+
+// The same password on an NTAG215 sticker with write protection from page 4 on.
+static bool ntagWriteAndRead() {
+    const uint8_t ntagUid[7] = {0x04, 0x51, 0x62, 0x73, 0x84, 0x95, 0xA6};
+    const uint8_t ntagPack[2] = {0xCA, 0xFE};
+    VirtualNtag21x ntag(VirtualNtag21x::NTAG215, ntagUid);
+    ntag.setPassword(ntag_password, ntagPack, 4, false);
+    reader.removePicc(card);
+    reader.addPicc(&ntag);
+    Sample start = sample();
+    bool ok = waitForCard() && cardSession == &ntagSession;
+    ok = ok && writeUserDataToNfc(DATA_TYPE_PASSWORD_ENC, (byte *)password, passwordLength);
+    report("NTAG215 write", start);
+    reportNtagSession("  session");
+    finalizeCardInteraction();
+    presentAgain(&ntag);
+    byte ntagDataType;
+    uint16_t ntagDataLength;
+    byte ntagBuffer[MAX_PAYLOAD_SIZE];
+    start = sample();
+    ok = ok && waitForCard();
+    const int ntagBytesRead = ok ? readUserDataFromNfc(&ntagDataType, &ntagDataLength, ntagBuffer, sizeof(ntagBuffer)) : -1;
+    report("NTAG215 read", start);
+    reportNtagSession("  session");
+    finalizeCardInteraction();
+    ok = ok && ntagBytesRead == passwordLength && ntagDataType == DATA_TYPE_PASSWORD_ENC && memcmp(ntagBuffer, password, passwordLength) == 0;
+    ok = ok && memcmp(ntagSession.pack(), ntagPack, 2) == 0;
+    reader.removePicc(&ntag);
+    reader.addPicc(card);
+    return ok;
+}
+
+// The card as a credential vault: formatted with three entries, then presented again to look one up by label,
+// read it and give it a new password. The lookup reads the directory and the entry, the update writes the
+// entry to free blocks and the changed blocks of the other directory copy.
+static bool vaultFormatAndUpdate() {
+    const char *vaultLabels[3] = {"github", "mail", "bank"};
+    const char *vaultPasswords[3] = {"gh-0123456789abcdef", "mail-secret", "bank-pin-2468"};
+    Sample start = sample();
+    bool ok = waitForCard() && formatVault();
+    for (byte i = 0; i < 3; i++) {
+        ok = ok && writeVaultEntry(-1, vaultLabels[i], (const byte *)vaultPasswords[i], strlen(vaultPasswords[i]));
+    }
+    report("vault format + 3 adds", start);
+    reportSession("  session");
+    finalizeCardInteraction();
+    presentAgain(card);
+    char vaultLabel[VAULT_LABEL_SIZE];
+    byte vaultSecret[VAULT_MAX_SECRET];
+    start = sample();
+    ok = ok && waitForCard() && openVault() == 3;
+    vaultIndex = ok ? findVaultEntry("mail") : -1;
+    const int vaultLength = vaultIndex >= 0 ? readVaultEntry(vaultIndex, vaultLabel, vaultSecret, sizeof(vaultSecret)) : -1;
+    report("vault find + read", start);
+    reportSession("  session");
+    ok = ok && vaultLength == (int)strlen(vaultPasswords[1]) && memcmp(vaultSecret, vaultPasswords[1], vaultLength) == 0 && strcmp(vaultLabel, "mail") == 0;
+    start = sample();
+    ok = ok && writeVaultEntry(vaultIndex, "mail", (const byte *)"mail-secret-2", 13);
+    report("vault update 1 entry", start);
+    reportSession("  session");
+    ok = ok && readVaultEntry(vaultIndex, vaultLabel, vaultSecret, sizeof(vaultSecret)) == 13 && memcmp(vaultSecret, "mail-secret-2", 13) == 0;
+    finalizeCardInteraction();
+    return ok;
+}
+
+// The card leaves while the next update writes the other directory copy, before its header block: the new entry
+// is on the card, but the current copy still lists the old blocks, so the vault opens with the password from before.
+static bool tornVaultUpdate() {
+    char vaultLabel[VAULT_LABEL_SIZE];
+    byte vaultSecret[VAULT_MAX_SECRET];
+    presentAgain(card);
+    const Sample start = sample();
+    bool ok = waitForCard() && openVault() == 3;
+    const uint32_t vaultTornFrom = card->blockWrites();
+    card->dropAnswers(255, 7);
+    ok = ok && !writeVaultEntry(vaultIndex, "mail", (const byte *)"mail-secret-3", 13);
+    card->dropAnswers(0);
+    const uint32_t vaultTornWrites = card->blockWrites() - vaultTornFrom;
+    ok = ok && vaultTornWrites > 0;
+    finalizeCardInteraction();
+    presentAgain(card);
+    ok = ok && waitForCard() && openVault() == 3;
+    ok = ok && readVaultEntry(vaultIndex, vaultLabel, vaultSecret, sizeof(vaultSecret)) == 13 && memcmp(vaultSecret, "mail-secret-2", 13) == 0;
+    report("torn vault update", start);
+    printf("  torn     %9u blocks written before the card left\n", vaultTornWrites);
+    finalizeCardInteraction();
+    return ok;
+}
+
+// Filled up with entries of the longest password: an update that needs more blocks than are free is refused
+// before anything is written, the entry keeps its password.
+static bool vaultFull() {
+    const char longPassword[] = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcde"; // VAULT_MAX_SECRET with its NUL
+    char vaultLabel[VAULT_LABEL_SIZE];
+    byte vaultSecret[VAULT_MAX_SECRET];
+    presentAgain(card);
+    const Sample start = sample();
+    bool ok = waitForCard() && openVault() == 3;
+    for (byte i = 0; i < 5 && ok; i++) {
+        snprintf(vaultLabel, sizeof(vaultLabel), "long %u", i);
+        ok = writeVaultEntry(-1, vaultLabel, (const byte *)longPassword, sizeof(longPassword) - 1);
+    }
+    const uint32_t fullFrom = card->blockWrites();
+    ok = ok && !writeVaultEntry(vaultIndex, "mail", (const byte *)longPassword, sizeof(longPassword) - 1);
+    ok = ok && card->blockWrites() == fullFrom;
+    ok = ok && readVaultEntry(vaultIndex, vaultLabel, vaultSecret, sizeof(vaultSecret)) == 13 && memcmp(vaultSecret, "mail-secret-2", 13) == 0;
+    report("vault full, 5 adds", start);
+    finalizeCardInteraction();
+    return ok;
+}
+
+// A 4K card: block map and capacity from its layout, a directory of VAULT_MAX_ENTRIES and entries that run on
+// into the 16-block sectors above sector 31.
+static bool vault4k() {
+    const uint8_t bigUid[4] = {0x4B, 0x34, 0x00, 0x01};
+    VirtualMifareClassic big(VirtualMifareClassic::CLASSIC_4K, bigUid);
+    const char bigPassword[] = "0123456789abcdef0123456789abcdef0123456";   // 3 blocks with its NUL
+    char vaultLabel[VAULT_LABEL_SIZE];
+    byte vaultSecret[VAULT_MAX_SECRET];
+    reader.removePicc(card);
+    reader.addPicc(&big);
+    Sample start = sample();
+    bool ok = waitForCard() && classicSession.capacity() == 3440 && formatVault();
+    for (byte i = 0; i < 30 && ok; i++) {
+        snprintf(vaultLabel, sizeof(vaultLabel), "site %u", i);
+        ok = writeVaultEntry(-1, vaultLabel, (const byte *)bigPassword, sizeof(bigPassword) - 1);
+    }
+    report("4K vault, 30 entries", start);
+    reportSession("  session");
+    finalizeCardInteraction();
+    presentAgain(&big);
+    start = sample();
+    ok = ok && waitForCard() && openVault() == 30;
+    const int bigIndex = ok ? findVaultEntry("site 29") : -1;
+    const int bigLength = bigIndex >= 0 ? readVaultEntry(bigIndex, vaultLabel, vaultSecret, sizeof(vaultSecret)) : -1;
+    report("4K vault find + read", start);
+    reportSession("  session");
+    ok = ok && bigLength == (int)sizeof(bigPassword) - 1 && memcmp(vaultSecret, bigPassword, bigLength) == 0;
+    finalizeCardInteraction();
+    reader.removePicc(&big);
+    reader.addPicc(card);
+    return ok;
+}
+
+// A card with the NFC Forum key as Key A of sectors 1-15. The first session finds it in the dictionary after
+// FF..FF and A0..A5 failed, later sessions, also after a reset that reloads the cache from EEPROM, use it right away.
+static bool keyedCard() {
+    const uint8_t keyedUid[4] = {0xC0, 0xFF, 0xEE, 0x01};
+    VirtualMifareClassic keyed(VirtualMifareClassic::CLASSIC_1K, keyedUid);
+    for (byte sector = 1; sector < 16; sector++) {
+        memcpy(keyed.memory() + (sector * 4 + 3) * 16, keyDictionary[2].keyByte, MFRC522::MF_KEY_SIZE);
+    }
+    reader.removePicc(card);
+    reader.addPicc(&keyed);
+    keyResolver.resetStats();
+    const uint32_t eepromFrom = host::eepromWrites();
+    Sample start = sample();
+    bool ok = waitForCard() && writeUserDataToNfc(DATA_TYPE_PASSWORD_ENC, (byte *)password, passwordLength);
+    report("keyed card, new", start);
+    reportKeys("  keys", keyResolver);
+    printf("  eeprom   %9u bytes written\n", host::eepromWrites() - eepromFrom);
+    ok = ok && keyResolver.stats().walks == 2 && keyResolver.stats().failures == 0;    // The payload is in sectors 0 and 1
+    finalizeCardInteraction();
+    for (byte pass = 0; pass < 2; pass++) {
+        // Pass 1: a fresh resolver, as after a reset, with the table from EEPROM.
+        MifareKeyResolver rebooted(mfrc522, keyDictionary, KEY_DICTIONARY_SIZE);
+        MifareKeyResolver &resolver = pass ? rebooted : keyResolver;
+        ok = ok && (pass == 0 || rebooted.enablePersistence(KEY_CACHE_EEPROM_ADDRESS));
+        classicSession.setKeyResolver(&resolver);
+        resolver.resetStats();
+        presentAgain(&keyed);
+        byte dataType;
+        uint16_t dataLength;
+        byte keyedBuffer[MAX_PAYLOAD_SIZE];
+        start = sample();
+        ok = ok && waitForCard();
+        const int keyedBytesRead = ok ? readUserDataFromNfc(&dataType, &dataLength, keyedBuffer, sizeof(keyedBuffer)) : -1;
+        report(pass ? "keyed card, reset" : "keyed card, cached", start);
+        reportKeys("  keys", resolver);
+        ok = ok && keyedBytesRead == passwordLength && memcmp(keyedBuffer, password, passwordLength) == 0;
+        ok = ok && resolver.stats().walks == 0 && resolver.stats().attempts == resolver.stats().hits;
+        finalizeCardInteraction();
+        classicSession.setKeyResolver(&keyResolver);
+    }
+    reader.removePicc(&keyed);
+    reader.addPicc(card);
+    return ok;
+}
+
+// A 4K card keyed the same way up to sector 39: a vault there uses every sector. After the first session, and
+// after a reset, each sector opens with its cached key.
+static bool keyedCard4k() {
+    const uint8_t keyedBigUid[4] = {0xC0, 0xFF, 0xEE, 0x04};
+    VirtualMifareClassic keyedBig(VirtualMifareClassic::CLASSIC_4K, keyedBigUid);
+    for (byte sector = 1; sector < MifareClassicLayout::CLASSIC_4K.sectors; sector++) {
+        memcpy(keyedBig.memory() + MifareClassicLayout::trailerOf(sector) * 16, keyDictionary[2].keyByte, MFRC522::MF_KEY_SIZE);
+    }
+    reader.removePicc(card);
+    bool ok = true;
+    for (byte pass = 0; pass < 2; pass++) {
+        MifareKeyResolver rebooted(mfrc522, keyDictionary, KEY_DICTIONARY_SIZE);
+        MifareKeyResolver &resolver = pass ? rebooted : keyResolver;
+        ok = ok && (pass == 0 || rebooted.enablePersistence(KEY_CACHE_EEPROM_ADDRESS));
+        presentAgain(&keyedBig);
+        const Sample start = sample();
+        ok = ok && waitForCard();
+        resolver.resetStats();
+        for (byte sector = 0; sector < MifareClassicLayout::CLASSIC_4K.sectors && ok; sector++) {
+            ok = resolver.authenticate(sector, MifareClassicLayout::trailerOf(sector)) == MFRC522::STATUS_OK;
+        }
+        report(pass ? "keyed 4K, 40 sectors, reset" : "keyed 4K, 40 sectors, new", start);
+        reportKeys("  keys", resolver);
+        ok = ok && resolver.stats().failures == 0 && resolver.stats().walks == (pass ? 0 : MifareClassicLayout::CLASSIC_4K.sectors);
+        finalizeCardInteraction();
+    }
+    reader.removePicc(&keyedBig);
+    reader.addPicc(card);
+    return ok;
+}
+
+// Enrollment station with three readers: one after the other with the blocking calls, then round-robin.
+static bool enrollmentStation() {
+    MFRC522 station1(49, 6), station2(48, 7);
+    MFRC522Emulator emulator1(49, 6), emulator2(48, 7);
+    const uint8_t stationUids[2][4] = {{0x01, 0x02, 0x03, 0x04}, {0x05, 0x06, 0x07, 0x08}};
+    VirtualMifareClassic stationCard1(VirtualMifareClassic::CLASSIC_1K, stationUids[0]);
+    VirtualMifareClassic stationCard2(VirtualMifareClassic::CLASSIC_1K, stationUids[1]);
+    emulator1.addPicc(&stationCard1);
+    emulator2.addPicc(&stationCard2);
+    station1.PCD_Init();
+    station2.PCD_Init();
+    delay(4);
+    MFRC522 *stations[STATION_READERS] = {&mfrc522, &station1, &station2};
+    for (byte i = 0; i < STATION_READERS; i++) {
+        stationNextCard(*stations[i]);
+    }
+    Sample start = sample();
+    for (byte round = 0; round < STATION_ROUNDS; round++) {
+        for (byte i = 0; i < STATION_READERS; i++) {
+            stationOk = stationCardBlocking(*stations[i], stationBuffer[i]) && stationOk;
+            stationNextCard(*stations[i]);
+        }
+    }
+    const double serialMillis = (sample().nanos - start.nanos) / 1e6;
+    printf("station, serial        %9.3f ms  %u cards  %8.0f cards/min\n", serialMillis, STATION_READERS * STATION_ROUNDS, STATION_READERS * STATION_ROUNDS / serialMillis * 60000);
+
+    byte rounds[STATION_READERS] = {0};
+    for (byte i = 0; i < STATION_READERS; i++) {
+        pool.add(stations[i]);
+    }
+    start = sample();
+    for (bool busy = true; busy; ) {
+        busy = false;
+        for (byte i = 0; i < STATION_READERS; i++) {
+            if (pool.pending(i) == 0 && rounds[i] < STATION_ROUNDS) {
+                if (rounds[i]++) {
+                    stationNextCard(*stations[i]);
+                }
+                pool.detect(i, stationStep);
+                pool.authenticate(i, 7, &key, stationStep);
+                pool.read(i, 4, stationBuffer[i], stationStep);
+                pool.read(i, 5, stationBuffer[i], stationStep, stationBuffer);
+            }
+            busy = busy || pool.pending(i) || rounds[i] < STATION_ROUNDS;
+        }
+        pool.run();
+    }
+    const double poolMillis = (sample().nanos - start.nanos) / 1e6;
+    printf("station, MFRC522Pool   %9.3f ms  %u cards  %8.0f cards/min  %u passes\n", poolMillis, stationCards, stationCards / poolMillis * 60000, pool.stats().passes);
+    return stationOk && stationCards == STATION_READERS * STATION_ROUNDS;
+}
+
+// ISO/IEC 14443-4 card (FSC 256, FWI 4, all bit rates in TA1) on a fourth reader: a 1 KB record written and
+// read back with one APDU each. Both are chained into 256 byte frames, the write needs S(WTX) and one answer of
+// the read gets lost. Once at 106 kBd, then presented again with PPS up to 848 kBd.
+static bool isoDepRecord() {
+    MFRC522Extended isoReader(47, 8);
+    MFRC522Emulator isoEmulator(47, 8);
+    const uint8_t isoUid[7] = {0x04, 0x10, 0x20, 0x30, 0x40, 0x50, 0x60};
+    VirtualIsoDepCard isoCard(isoUid, 7, 8, 4, 0x77);
+    isoEmulator.addPicc(&isoCard);
+    isoReader.PCD_Init();
+    delay(4);
+    static byte isoApdu[7 + 1024 + 2];
+    static byte isoBack[1024 + 2];
+    const byte updateHeader[7] = {0x00, 0xD6, 0x00, 0x00, 0x00, 0x04, 0x00};     // UPDATE BINARY, extended Lc 1024
+    const byte readApdu[7] = {0x00, 0xB0, 0x00, 0x00, 0x00, 0x04, 0x00};         // READ BINARY, extended Le 1024
+    memcpy(isoApdu, updateHeader, sizeof(updateHeader));
+    bool isoOk = true;
+    const MFRC522Extended::TagBitRates isoRates[2] = {MFRC522Extended::BITRATE_106KBITS, MFRC522Extended::BITRATE_848KBITS};
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        char phase[32];
+        for (uint16_t i = 0; i < 1024; i++) {
+            isoApdu[7 + i] = (byte)(i * 7 + 3 + pass);
+        }
+        isoCard.powerOff();
+        isoCard.powerOn();
+        isoCard.resetStats();
+        isoReader.PICC_SetMaxBitRate(isoRates[pass]);
+        Sample start = sample(isoEmulator);
+        isoOk = isoOk && isoReader.PICC_IsNewCardPresent() && isoReader.PICC_ReadCardSerial();
+        isoOk = isoOk && isoReader.tag.sendBitRate == isoRates[pass] && isoReader.tag.receiveBitRate == isoRates[pass];
+        const uint16_t kbps = MFRC522Extended::PICC_BitRateKbps(isoReader.tag.receiveBitRate);
+        snprintf(phase, sizeof(phase), "ISO-DEP %u select", kbps);
+        report(phase, start, isoEmulator);
+        start = sample(isoEmulator);
+        uint16_t isoBackLen = sizeof(isoBack);
+        isoOk = isoOk && isoReader.TCL_TransceiveApdu(&isoReader.tag, isoApdu, 7 + 1024, isoBack, &isoBackLen) == MFRC522::STATUS_OK;
+        isoOk = isoOk && isoBackLen == 2 && isoBack[0] == 0x90 && isoBack[1] == 0x00;
+        snprintf(phase, sizeof(phase), "ISO-DEP %u write 1 KB", kbps);
+        report(phase, start, isoEmulator);
+        isoCard.dropAnswers(1);
+        start = sample(isoEmulator);
+        isoBackLen = sizeof(isoBack);
+        isoOk = isoOk && isoReader.TCL_TransceiveApdu(&isoReader.tag, readApdu, sizeof(readApdu), isoBack, &isoBackLen) == MFRC522::STATUS_OK;
+        isoOk = isoOk && isoBackLen == 1026 && memcmp(isoBack, isoApdu + 7, 1024) == 0 && isoBack[1024] == 0x90;
+        snprintf(phase, sizeof(phase), "ISO-DEP %u read 1 KB", kbps);
+        report(phase, start, isoEmulator);
+        isoOk = isoOk && isoReader.TCL_Deselect(&isoReader.tag) == MFRC522::STATUS_OK && isoCard.state() == Iso14443aPicc::HALT;
+        printf("  card     %9u I-blocks in %4u out %4u R(ACK) %3u R(NAK) %3u S(WTX)  %s\n",
+               isoCard.stats().iBlocksIn, isoCard.stats().iBlocksOut, isoCard.stats().acksIn, isoCard.stats().naksIn,
+               isoCard.stats().wtxRequests, isoOk ? "ok" : "FAILED");
+    }
+    return isoOk;
+}
+
+struct BenchPhase {
+    const char *name;
+    bool (*run)();
+};
+
+// In order: each phase starts with the card as the previous one left it.
+static const BenchPhase phases[] = {
+    {"blank card write", blankCardWrite},
+    {"read back + rewrite", readBackAndRewrite},
+    {"lost answers", lostAnswers},
+    {"wait without card", waitWithoutCard},
+    {"batch provision", batchProvision},
+    {"NTAG215", ntagWriteAndRead},
+    {"vault", vaultFormatAndUpdate},
+    {"torn vault update", tornVaultUpdate},
+    {"vault full", vaultFull},
+    {"4K vault", vault4k},
+    {"keyed card", keyedCard},
+    {"keyed 4K card", keyedCard4k},
+    {"enrollment station", enrollmentStation},
+    {"ISO-DEP record", isoDepRecord}
+};
+
+int main(int argc, char **argv) {
+    const uint8_t uid[4] = {0xDE, 0xAD, 0xBE, 0xEF};
+    card = (argc > 1) ? VirtualMifareClassic::fromFile(argv[1]) : new VirtualMifareClassic(VirtualMifareClassic::CLASSIC_1K, uid);
+    if (card == nullptr) {
+        fprintf(stderr, "cannot load card image %s\n", argv[1]);
+        return 2;
+    }
+    reader.addPicc(card);
+    host::setSerialEnabled(false);
+    for (byte i = 0; i < 6; i++) { key.keyByte[i] = 0xFF; }
+    keyResolver.enablePersistence(KEY_CACHE_EEPROM_ADDRESS);
+
+    const Sample start = sample();
+    SPI.begin();
+    mfrc522.PCD_Init();
+    delay(4);
+    report("PCD_Init", start);
+
+    for (const BenchPhase &phase : phases) {
+        if (!phase.run()) {
+            printf("FAILED in phase \"%s\"\n", phase.name);
+            return 1;
+        }
+    }
+    printf("total                  %9.3f ms  %u EEPROM block writes  OK\n", host::nanos() / 1e6, card->blockWrites());
+#ifdef MFRC522_TELEMETRY
+    host::setSerialEnabled(true);
+    mfrc522.PCD_DumpTelemetryToSerial();
+#endif
+
+    if (argc > 2 && !card->saveToFile(argv[2])) {
+        fprintf(stderr, "cannot save card image %s\n", argv[2]);
+        return 2;
+    }
+    return 0;
+}
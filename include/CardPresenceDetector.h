@@ -0,0 +1,76 @@
+// Duty-cycled card presence detection on top of MFRC522.
+// Waiting for a card does not need the RF field all the time: the field is switched on for a short burst of
+// REQA frames once per period and is off in between, either with the antenna drivers disabled or with the
+// whole MFRC522 in soft power-down. The burst runs on the non-blocking REQA, so loop() keeps running and
+// the SPI bus is idle between bursts. The cost is detection latency: a card is found at most one period late.
+#ifndef CARD_PRESENCE_DETECTOR_H
+#define CARD_PRESENCE_DETECTOR_H
+
+#include <Arduino.h>
+#include <MFRC522.h>
+#include <stdint.h>
+
+class CardPresenceDetector {
+public:
+    enum IdleMode : byte {
+        IDLE_ANTENNA_OFF,       // TX1/TX2 off, oscillator and receiver keep running
+        IDLE_SOFT_POWER_DOWN    // PowerDown bit in CommandReg: field and analog part off, registers kept
+    };
+
+    struct Stats {
+        uint32_t bursts;            // Field-on windows
+        uint32_t requests;          // REQA frames sent
+        uint16_t detections;
+        uint32_t rfOnMicros;        // Field on while waiting: the current proxy
+        uint32_t waitMicros;        // Time from begin() to detection or end()
+        uint32_t lastDetectMicros;  // From the last burst that found no card (or begin()) to detection: the worst case wait of the card
+        uint32_t maxDetectMicros;
+        uint32_t totalDetectMicros;
+    };
+
+    /**
+     * @param reader The MFRC522 to wait on. Its RF field must be on when waiting starts, as after PCD_Init().
+     * @param periodMillis Time from the start of one burst to the start of the next.
+     * @param burstLength REQA frames per burst before the field goes off again.
+     * @param idleMode How the field is off between bursts.
+     * @param settleMillis Field-on time before the first REQA of a burst, so a card in the field can power up (ISO/IEC 14443-3: 5 ms).
+     */
+    CardPresenceDetector(MFRC522 &reader, uint16_t periodMillis = 100, byte burstLength = 2,
+                         IdleMode idleMode = IDLE_SOFT_POWER_DOWN, byte settleMillis = 5);
+
+    void begin();   // Start waiting. The first burst runs right away, on the field that is already on.
+    bool poll();    // Call from loop(). True once a card answered REQA; the field stays on for PICC_ReadCardSerial(). Calls begin() when not waiting.
+    void end();     // Stop waiting and switch the field back on.
+    bool waiting() const { return _state != STATE_STOPPED; }
+
+    const Stats &stats() const { return _stats; }
+    void resetStats() { memset(&_stats, 0, sizeof(_stats)); }
+    uint16_t rfDutyPermille() const;
+    uint32_t averageDetectMicros() const;
+
+private:
+    enum State : byte { STATE_STOPPED, STATE_SLEEPING, STATE_SETTLING, STATE_REQUESTING };
+
+    void fieldOn();
+    void fieldOff(uint32_t now);
+    void startRequest();
+    void stop(uint32_t now);
+
+    MFRC522 &_reader;
+    uint16_t _periodMillis;
+    byte _burstLength;
+    IdleMode _idleMode;
+    byte _settleMillis;
+    State _state;
+    byte _burstRequests;            // REQA frames sent in the current burst
+    MFRC522::StatusCode _request;   // Result of the last Start call, STATUS_PENDING while it runs
+    byte _atqa[2];
+    byte _atqaSize;
+    uint32_t _beganAt;              // micros() timestamps
+    uint32_t _burstAt;
+    uint32_t _fieldOnAt;
+    uint32_t _emptyAt;              // End of the last burst without an answer
+    Stats _stats;
+};
+
+#endif // CARD_PRESENCE_DETECTOR_H
@@ -0,0 +1,69 @@
+// The user data area of the selected card as a logical byte range.
+// One implementation per card family: MifareClassicSession maps the range onto data blocks and Crypto1 sectors,
+// NtagSession onto the user pages of NTAG21x. NfcStorage picks one per card and only talks to this interface.
+#ifndef CARD_SESSION_H
+#define CARD_SESSION_H
+
+#include <Arduino.h>
+#include <MFRC522.h>
+#include <stdint.h>
+
+class CardSession {
+public:
+    static const byte DEFAULT_ATTEMPTS = 3;         // Tries per block or page operation, the first one included
+    static const uint16_t DEFAULT_BACKOFF_MS = 5;   // Pause before the second try, doubled for every further one
+    static const byte UPDATE_CHUNK = 48;            // Bytes read per step of updateRange(), a multiple of every writeUnit()
+
+    struct RetryStats {
+        uint16_t retries;       // Block or page operations tried again
+        uint16_t reselects;     // Successful WUPA + SELECT of the card after a failure
+        uint16_t failures;      // Operations that failed after the last try
+    };
+
+    CardSession() : _attempts(DEFAULT_ATTEMPTS), _backoffMillis(DEFAULT_BACKOFF_MS) { resetRetryStats(); }
+
+    virtual MFRC522::StatusCode begin() = 0;    // A card was selected: reset the session state and clear the statistics.
+    virtual void end() = 0;                     // Halt the card.
+
+    // Called by readStream() with the number of bytes of its buffer read so far.
+    typedef void (*StreamHandler)(uint16_t received, void *context);
+
+    virtual MFRC522::StatusCode readRange(uint16_t offset, byte buffer[], uint16_t length) = 0;
+    // readRange() that calls handler as the data comes in, where the card allows while the next read is on the air.
+    // The last call has received == length. The default reads everything first.
+    virtual MFRC522::StatusCode readStream(uint16_t offset, byte buffer[], uint16_t length, StreamHandler handler, void *context);
+    virtual MFRC522::StatusCode writeRange(uint16_t offset, const byte buffer[], uint16_t length) = 0;
+    // writeRange() of only the write units that differ from the card. written (optional) returns how many were written.
+    MFRC522::StatusCode updateRange(uint16_t offset, const byte buffer[], uint16_t length, uint16_t *written = nullptr);
+
+    virtual uint16_t capacity() const = 0;      // Size of the logical address space in bytes
+    virtual byte writeUnit() const = 0;         // Bytes the card writes at once: a block or a page
+    virtual uint32_t bytesPerSecond() const = 0;
+
+    // attempts = 1 turns retries off.
+    void setRetryPolicy(byte attempts, uint16_t backoffMillis) { _attempts = max(attempts, (byte)1); _backoffMillis = backoffMillis; }
+    const RetryStats &retryStats() const { return _retryStats; }
+
+protected:
+    // Called after attempt (0 for the first) of a block or page operation failed with status. Waits the backoff and
+    // selects the card again, which drops its authentication. Returns true if the operation should be tried again.
+    bool recover(MFRC522 &reader, MFRC522::StatusCode status, byte attempt);
+    void resetRetryStats() { memset(&_retryStats, 0, sizeof(_retryStats)); }
+
+    // Adds the time between construction and destruction to a counter.
+    class BusyTimer {
+    public:
+        explicit BusyTimer(uint32_t &total) : _total(total), _start(micros()) {}
+        ~BusyTimer() { _total += micros() - _start; }
+    private:
+        uint32_t &_total;
+        uint32_t _start;
+    };
+
+private:
+    byte _attempts;
+    uint16_t _backoffMillis;
+    RetryStats _retryStats;
+};
+
+#endif // CARD_SESSION_H
@@ -0,0 +1,81 @@
+// MIFARE Classic access on top of MFRC522 with authentication tracking.
+// Blocks are addressed through a logical byte range over a list of data blocks (the block map), so callers
+// never deal with sector trailers. The sector whose Crypto1 session is open is remembered between calls:
+// a read followed by a write on the same card only authenticates again when it moves to another sector.
+// A block that fails is tried again after the card was selected again (CardSession::recover()), so a range
+// operation resumes at that block and only its sector is authenticated again.
+#ifndef MIFARE_CLASSIC_SESSION_H
+#define MIFARE_CLASSIC_SESSION_H
+
+#include <Arduino.h>
+#include <MFRC522.h>
+#include "CardSession.h"
+#include "MifareClassicLayout.h"
+#include "MifareKeyResolver.h"
+#include <stdint.h>
+
+class MifareClassicSession : public CardSession {
+public:
+    static const byte BLOCK_SIZE = 16;
+    static const byte NO_SECTOR = 0xFF;
+
+    struct Stats {
+        uint32_t bytesRead;         // Data bytes returned by readRange()/readSector(), including read-modify-write reads
+        uint32_t bytesWritten;      // Data bytes sent with MIFARE_Write()
+        uint16_t authentications;   // PCD_Authenticate() calls
+        uint16_t blockReads;
+        uint16_t blockWrites;
+        uint32_t busyMicros;        // Time spent inside session calls
+    };
+
+    /**
+     * @param reader The MFRC522 the card is selected on.
+     * @param key Key used for every sector. Must outlive the session.
+     * @param blocks Block map in flash (PROGMEM): the card blocks that make up the logical address space, in order.
+     * No sector trailers.
+     * @param blockCount Number of entries in blocks.
+     * @param resolver Finds the key of every sector instead of key and authCommand, nullptr to use them. Must outlive the session.
+     */
+    MifareClassicSession(MFRC522 &reader, MFRC522::MIFARE_Key &key, const byte *blocks, byte blockCount,
+                         MFRC522::PICC_Command authCommand = MFRC522::PICC_CMD_MF_AUTH_KEY_A, MifareKeyResolver *resolver = nullptr);
+
+    MFRC522::StatusCode begin() override;   // A card was selected: forget the Crypto1 state and clear the statistics.
+    void end() override;                    // Halt the card and stop Crypto1.
+
+    void setKeyResolver(MifareKeyResolver *resolver) { _resolver = resolver; }
+    void setBlocks(const byte *blocks, byte blockCount) { _blocks = blocks; _blockCount = blockCount; }   // Block map (PROGMEM) for the next card
+    MFRC522::StatusCode authenticate(byte blockAddr);   // Open the sector of blockAddr unless it is already open.
+    MFRC522::StatusCode readSector(byte sector, byte buffer[], uint16_t bufferSize);   // Every block of a sector but the trailer
+    MFRC522::StatusCode readRange(uint16_t offset, byte buffer[], uint16_t length) override;
+    MFRC522::StatusCode readStream(uint16_t offset, byte buffer[], uint16_t length, StreamHandler handler, void *context) override;
+    MFRC522::StatusCode writeRange(uint16_t offset, const byte buffer[], uint16_t length) override;
+
+    uint16_t capacity() const override { return (uint16_t)_blockCount * BLOCK_SIZE; }
+    byte writeUnit() const override { return BLOCK_SIZE; }
+    byte authenticatedSector() const { return _sector; }
+    const Stats &stats() const { return _stats; }
+    uint32_t bytesPerSecond() const override;
+
+    // MIFARE Classic geometry, see MifareClassicLayout.
+    static constexpr byte sectorOf(byte blockAddr) { return MifareClassicLayout::sectorOf(blockAddr); }
+    static constexpr byte firstBlockOf(byte sector) { return MifareClassicLayout::firstBlockOf(sector); }
+    static constexpr byte blocksIn(byte sector) { return MifareClassicLayout::blocksIn(sector); }
+    static constexpr byte trailerOf(byte sector) { return MifareClassicLayout::trailerOf(sector); }
+
+private:
+    MFRC522::StatusCode readBlock(byte blockAddr, byte buffer[18], byte firstAttempt = 0);
+    MFRC522::StatusCode writeBlock(byte blockAddr, byte buffer[BLOCK_SIZE]);
+    MFRC522::StatusCode writePart(byte index, byte skip, const byte buffer[], byte chunk);
+    byte blockAt(byte index) const { return pgm_read_byte(&_blocks[index]); }
+
+    MFRC522 &_reader;
+    MFRC522::MIFARE_Key &_key;
+    const byte *_blocks;
+    byte _blockCount;
+    MFRC522::PICC_Command _authCommand;
+    MifareKeyResolver *_resolver;
+    byte _sector;   // Sector with an open Crypto1 session, NO_SECTOR if none
+    Stats _stats;
+};
+
+#endif // MIFARE_CLASSIC_SESSION_H
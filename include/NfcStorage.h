@@ -0,0 +1,100 @@
+// NFC user data area: card layout, header format and MIFARE Classic / NTAG21x read/write helpers.
+// Kept apart from the UI in main.cpp so the same code also runs on the host against the MFRC522 emulator (env:native_emu).
+#ifndef NFC_STORAGE_H
+#define NFC_STORAGE_H
+
+#include <Arduino.h>
+#include <MFRC522.h>
+#include "MifareClassicLayout.h"
+#include "MifareClassicSession.h"
+#include "MifareKeyResolver.h"
+#include "NtagSession.h"
+#include "CardPresenceDetector.h"
+#include <stdint.h>
+
+// --- MIFARE Classic Configuration ---
+// Block maps of Mini/1K/4K come from MifareClassicLayout, picked per card by PICC_GetType().
+const byte BLOCK_SIZE = 16;
+// A single password record stays within the user area of a 1K (752 bytes); the vault uses the whole card, 3440 bytes on a 4K.
+const int TOTAL_USER_AREA_SIZE = MifareClassicLayout::CLASSIC_1K.dataBlocks * BLOCK_SIZE;
+
+// --- Header Configuration ---
+const byte HEADER_SIZE = 4; // 1 byte type + 2 bytes length + 1 byte high-water mark
+const byte LEGACY_HEADER_SIZE = 3; // Type + length, written before the high-water mark; the rest of the area is zero
+const byte HEADER_FLAG_HWM = 0x80; // Set in the type byte of a HEADER_SIZE header
+// MAX_PAYLOAD_SIZE now refers to the max *encrypted* (and padded) data size that can be stored
+const int MAX_PAYLOAD_SIZE = TOTAL_USER_AREA_SIZE - HEADER_SIZE; // Max stored data size = 748 bytes
+
+// --- Batch Mode ---
+const byte MAX_BATCH_CARDS = 8; // Cards handled by one processAllCards() call
+
+// --- Data Type Codes ---
+const byte DATA_TYPE_NONE = 0x00;
+const byte DATA_TYPE_PASSWORD = 0x01; // Plaintext password (legacy/optional)
+const byte DATA_TYPE_PASSWORD_ENC = 0x02; // <<< Encrypted password type
+const byte DATA_TYPE_VAULT = 0x03; // Credential vault: directory + entries, see openVault()
+
+// --- Slots: the vault directory copies ---
+const byte SLOT_COUNT = 2;
+const byte SLOT_HEADER_SIZE = 8; // Sequence (2), data type, length (2), slot index, CRC-16 (2); the rest of the block is zero
+
+// --- Credential Vault ---
+const byte VAULT_VERSION = 2; // 2: the directory is kept in two slots, A and B
+const byte VAULT_ENTRY_SIZE = 8; // Directory entry: slot id, flags, label hash (2), first block, length (2), reserved
+const byte VAULT_MAX_ENTRIES = 48; // Directory entries held in RAM; cards get about one per four user blocks
+const byte VAULT_LABEL_SIZE = 16; // Label including its NUL: the first block of every entry
+const byte VAULT_MAX_SECRET = 64; // Padded password bytes per entry
+const byte VAULT_FLAG_ENCRYPTED = 0x01; // Label and password are AES-128 encrypted with aes_key
+
+struct VaultEntry {
+    byte slotId; // 1..255, stays with the entry; 0 marks a free directory entry
+    byte flags;
+    uint16_t labelHash; // Compared before any label is read
+    byte firstBlock; // Block of the user area the entry starts at
+    uint16_t length; // Stored bytes: label block + padded password
+};
+
+// --- MIFARE Classic keys ---
+const byte KEY_DICTIONARY_SIZE = 4; // Keys tried per sector, as Key A and as Key B, until one authenticates
+const int KEY_CACHE_EEPROM_ADDRESS = 0; // The keys that worked per card and sector, MifareKeyResolver::EEPROM_SIZE bytes
+
+// --- Defined by the sketch ---
+extern MFRC522 mfrc522;
+extern MFRC522::MIFARE_Key key; // Key A for every sector, used by classicSession only without keyResolver
+extern MFRC522::MIFARE_Key keyDictionary[KEY_DICTIONARY_SIZE];
+extern byte ntag_password[4]; // PWD_AUTH password of NTAG21x cards
+extern byte aes_key[16];
+
+// --- Key of every MIFARE Classic sector: cached per UID, otherwise found in keyDictionary ---
+extern MifareKeyResolver keyResolver;
+
+// --- Session on the current card: MIFARE Classic over the data blocks of its layout, or the user pages of an NTAG21x ---
+extern MifareClassicSession classicSession;
+extern NtagSession ntagSession;
+extern CardSession *cardSession; // One of the two, set when a card is selected
+extern CardPresenceDetector cardDetector; // Duty-cycled wait of pollCardInteraction()
+
+// --- Card Functions ---
+bool initializeCardInteraction();
+bool pollCardInteraction(); // Non-blocking initializeCardInteraction(), call from loop() until true
+void cancelCardInteraction(); // Stop waiting for a card started by pollCardInteraction()
+byte processAllCards(bool (*process)(void *context), void *context); // Every card in the field, one after the other
+void finalizeCardInteraction();
+bool reconnectCardInteraction(); // Same card again after finalizeCardInteraction(), no new scan
+bool authenticateBlock(byte blockAddr);
+bool readBlockFromNfc(byte blockAddr, byte buffer[], byte bufferSize);
+bool writeBlockToNfc(byte blockAddr, byte buffer[], byte bufferSize);
+int readUserDataFromNfc(byte* dataType, uint16_t* dataLength, byte dataBuffer[], int bufferCapacity);
+bool writeUserDataToNfc(byte dataType, byte plainPayloadBuffer[], uint16_t plainPayloadLength); // Takes PLAINTEXT
+bool isUserDataBlock(byte blockAddr); // Data block of the current MIFARE Classic card
+
+// --- Vault Functions: the current card, opened by openVault() or formatVault() ---
+int openVault(); // Header + current directory copy. Entries, or -2 invalid vault, -3 read error, -4 no vault on the card
+bool formatVault(); // Empty vault, the rest of the user area is left for the entries to overwrite
+byte vaultSize(); // Entries of the open vault, indexes 0..vaultSize()-1 in directory order
+bool readVaultLabel(byte index, char label[VAULT_LABEL_SIZE]);
+int readVaultEntry(byte index, char label[VAULT_LABEL_SIZE], byte password[], int capacity); // Plaintext length or negative
+int findVaultEntry(const char *label); // Index, or -1
+bool writeVaultEntry(int index, const char *label, const byte password[], uint16_t length); // index -1 adds an entry
+
+#endif // NFC_STORAGE_H
@@ -0,0 +1,61 @@
+// NTAG213/215/216 access on top of MFRC522: the user pages as one logical byte range.
+// Reads use FAST_READ, which returns up to MFRC522::FAST_READ_MAX_PAGES pages in one frame, where READ returns
+// four. Writes are one WRITE per 4 byte page. Instead of Crypto1 there is PWD_AUTH: with a password set it runs
+// once per session, before the first access, and stays valid until the card is halted.
+// Failed frames are sent again after CardSession::recover() selected the tag again and PWD_AUTH was repeated.
+#ifndef NTAG_SESSION_H
+#define NTAG_SESSION_H
+
+#include <Arduino.h>
+#include <MFRC522.h>
+#include "CardSession.h"
+#include <stdint.h>
+
+class NtagSession : public CardSession {
+public:
+    static const byte PAGE_SIZE = 4;
+    static const byte FIRST_USER_PAGE = 4;
+
+    struct Stats {
+        uint32_t bytesRead;         // Data bytes returned by readRange(), including read-modify-write reads
+        uint32_t bytesWritten;      // Data bytes sent with WRITE
+        uint16_t authentications;   // PWD_AUTH commands
+        uint16_t fastReads;         // FAST_READ frames
+        uint16_t pageWrites;
+        uint32_t busyMicros;        // Time spent inside session calls
+    };
+
+    /**
+     * @param reader The MFRC522 the card is selected on.
+     * @param password 4 byte PWD_AUTH password, nullptr to never authenticate. Must outlive the session.
+     */
+    explicit NtagSession(MFRC522 &reader, const byte *password = nullptr);
+
+    MFRC522::StatusCode begin() override;   // GET_VERSION for the user memory size. Fails on anything but NTAG213/215/216.
+    void end() override;                    // Halt the card.
+
+    MFRC522::StatusCode authenticate();     // PWD_AUTH, unless it was done in this session or there is no password.
+    MFRC522::StatusCode readRange(uint16_t offset, byte buffer[], uint16_t length) override;
+    MFRC522::StatusCode writeRange(uint16_t offset, const byte buffer[], uint16_t length) override;
+
+    uint16_t capacity() const override { return (uint16_t)_userPages * PAGE_SIZE; }
+    byte writeUnit() const override { return PAGE_SIZE; }
+    const byte *pack() const { return _pack; }  // PACK answered to the last PWD_AUTH
+    const Stats &stats() const { return _stats; }
+    uint32_t bytesPerSecond() const override;
+
+    static byte userPagesFor(byte storageSize); // From the storage size byte of GET_VERSION, 0 if not an NTAG21x
+
+private:
+    MFRC522::StatusCode readPages(byte firstPage, byte pages, byte buffer[]);
+    MFRC522::StatusCode writePage(byte page, byte data[PAGE_SIZE]);
+
+    MFRC522 &_reader;
+    const byte *_password;
+    byte _userPages;    // 0 until begin() identified the tag
+    bool _authenticated;
+    byte _pack[2];
+    Stats _stats;
+};
+
+#endif // NTAG_SESSION_H
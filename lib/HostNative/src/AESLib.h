@@ -0,0 +1,38 @@
+/**
+ * Portable replacement for the AESLib AES-128 entry points, used by host-native builds
+ * where the AVR assembly of lib/AESLib-master is not available. Same signatures and results.
+ */
+#ifndef AESLIB_H
+#define AESLIB_H
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C"{
+#endif
+// encrypt single 128bit block. data is assumed to be 16 uint8_t's
+// key is assumed to be 128bit thus 16 uint8_t's
+void aes128_enc_single(const uint8_t* key, void* data);
+
+// encrypt multiple blocks of 128bit data, data_len but be mod 16
+// key is assumed to be 128bit thus 16 uint8_t's
+void aes128_enc_multiple(const uint8_t* key, void* data, const uint16_t data_len);
+
+// decrypt single 128bit block. data is assumed to be 16 uint8_t's
+// key is assumed to be 128bit thus 16 uint8_t's
+void aes128_dec_single(const uint8_t* key, void* data);
+
+// decrypt multiple blocks of 128bit data, data_len but be mod 16
+// key is assumed to be 128bit thus 16 uint8_t's
+void aes128_dec_multiple(const uint8_t* key, void* data, const uint16_t data_len);
+
+// encrypt multiple blocks of 128bit data, data_len but be mod 16
+// key and iv are assumed to be both 128bit thus 16 uint8_t's
+void aes128_cbc_enc(const uint8_t* key, const uint8_t* iv, void* data, const uint16_t data_len);
+
+// decrypt multiple blocks of 128bit data, data_len but be mod 16
+// key and iv are assumed to be both 128bit thus 16 uint8_t's
+void aes128_cbc_dec(const uint8_t* key, const uint8_t* iv, void* data, const uint16_t data_len);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,233 @@
+/**
+ * Minimal Arduino core for host-native builds (env:native_emu).
+ */
+#include "Arduino.h"
+#include <stdio.h>
+
+HardwareSerial Serial;
+
+namespace {
+	static constexpr uint8_t MAX_LISTENERS = 8;
+
+	uint64_t nowNanos = 0;
+	bool advancing = false;
+	uint64_t pendingNanos = 0;
+	bool serialEnabled = true;
+	uint32_t randomState = 1;
+
+	uint8_t pinLevels[256];
+	void (*pinIsrs[256])(void);
+	int pinIsrModes[256];
+
+	host::TimeListener *timeListeners[MAX_LISTENERS];
+	host::PinListener *pinListeners[MAX_LISTENERS];
+
+	template <typename T>
+	void addListener(T **list, T *listener) {
+		for (uint8_t i = 0; i < MAX_LISTENERS; i++) {
+			if (list[i] == nullptr) {
+				list[i] = listener;
+				return;
+			}
+		}
+		abort();	// More peripherals than a bench will ever need.
+	}
+
+	template <typename T>
+	void removeListener(T **list, T *listener) {
+		for (uint8_t i = 0; i < MAX_LISTENERS; i++) {
+			if (list[i] == listener) {
+				list[i] = nullptr;
+			}
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Simulated time
+/////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t host::nanos() {
+	return nowNanos;
+}
+
+/**
+ * Advances the simulated clock and lets peripherals catch up.
+ * Time consumed by a listener (e.g. SPI traffic from an interrupt handler) is added after the current step.
+ */
+void host::advanceNanos(uint64_t ns) {
+	if (advancing) {
+		pendingNanos += ns;
+		return;
+	}
+	advancing = true;
+	while (ns > 0) {
+		nowNanos += ns;
+		for (uint8_t i = 0; i < MAX_LISTENERS; i++) {
+			if (timeListeners[i] != nullptr) {
+				timeListeners[i]->onTimeAdvanced(nowNanos);
+			}
+		}
+		ns = pendingNanos;
+		pendingNanos = 0;
+	}
+	advancing = false;
+}
+
+void host::addTimeListener(TimeListener *listener) { addListener(timeListeners, listener); }
+void host::removeTimeListener(TimeListener *listener) { removeListener(timeListeners, listener); }
+
+unsigned long millis() {
+	return (unsigned long)(nowNanos / 1000000u);
+}
+
+unsigned long micros() {
+	return (unsigned long)(nowNanos / 1000u);
+}
+
+void delay(unsigned long ms) {
+	host::advanceNanos((uint64_t)ms * 1000000u);
+}
+
+void delayMicroseconds(unsigned int us) {
+	host::advanceNanos((uint64_t)us * 1000u);
+}
+
+void yield() {
+	host::advanceNanos(host::YIELD_NANOS);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Pins and interrupts
+/////////////////////////////////////////////////////////////////////////////////////
+
+void pinMode(uint8_t pin, uint8_t mode) {
+	if (mode == INPUT_PULLUP) {
+		host::setPinLevel(pin, HIGH);
+	}
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+	pinLevels[pin] = val ? HIGH : LOW;
+	for (uint8_t i = 0; i < MAX_LISTENERS; i++) {
+		if (pinListeners[i] != nullptr) {
+			pinListeners[i]->onPinWrite(pin, pinLevels[pin]);
+		}
+	}
+}
+
+int digitalRead(uint8_t pin) {
+	return pinLevels[pin];
+}
+
+void attachInterrupt(uint8_t interruptNum, void (*isr)(void), int mode) {
+	pinIsrs[interruptNum] = isr;
+	pinIsrModes[interruptNum] = mode;
+}
+
+void detachInterrupt(uint8_t interruptNum) {
+	pinIsrs[interruptNum] = nullptr;
+}
+
+void host::addPinListener(PinListener *listener) { addListener(pinListeners, listener); }
+void host::removePinListener(PinListener *listener) { removeListener(pinListeners, listener); }
+
+void host::setPinLevel(uint8_t pin, uint8_t level) {
+	level = level ? HIGH : LOW;
+	const uint8_t previous = pinLevels[pin];
+	pinLevels[pin] = level;
+	if (previous == level || pinIsrs[pin] == nullptr) {
+		return;
+	}
+	const int mode = pinIsrModes[pin];
+	if (mode == CHANGE || (mode == FALLING && level == LOW) || (mode == RISING && level == HIGH)) {
+		pinIsrs[pin]();
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Random numbers
+/////////////////////////////////////////////////////////////////////////////////////
+
+void randomSeed(unsigned long seed) {
+	if (seed != 0) {
+		randomState = (uint32_t)seed;
+	}
+}
+
+long random(long howbig) {
+	if (howbig <= 0) {
+		return 0;
+	}
+	// xorshift32, good enough for test data.
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return (long)(randomState % (uint32_t)howbig);
+}
+
+long random(long howsmall, long howbig) {
+	if (howsmall >= howbig) {
+		return howsmall;
+	}
+	return howsmall + random(howbig - howsmall);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Serial
+/////////////////////////////////////////////////////////////////////////////////////
+
+void host::setSerialEnabled(bool enabled) {
+	serialEnabled = enabled;
+}
+
+size_t Print::write(uint8_t c) {
+	return write(&c, 1);
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+	if (serialEnabled) {
+		fwrite(buffer, 1, size, stdout);
+	}
+	return size;
+}
+
+size_t Print::printNumber(unsigned long n, int base) {
+	char buf[8 * sizeof(long) + 1];
+	char *str = &buf[sizeof(buf) - 1];
+	*str = '\0';
+	if (base < 2) {
+		base = 10;
+	}
+	do {
+		const char c = (char)(n % base);
+		n /= base;
+		*--str = c < 10 ? c + '0' : c + 'A' - 10;
+	} while (n);
+	return print(str);
+}
+
+size_t Print::print(const __FlashStringHelper *s) { return print(reinterpret_cast<const char *>(s)); }
+size_t Print::print(const char s[]) { return write(reinterpret_cast<const uint8_t *>(s), strlen(s)); }
+size_t Print::print(char c) { return write((uint8_t)c); }
+size_t Print::print(unsigned char n, int base) { return printNumber(n, base); }
+size_t Print::print(int n, int base) { return print((long)n, base); }
+size_t Print::print(unsigned int n, int base) { return printNumber(n, base); }
+size_t Print::print(unsigned long n, int base) { return printNumber(n, base); }
+
+size_t Print::print(long n, int base) {
+	if (base == 10 && n < 0) {
+		return print('-') + printNumber(-(unsigned long)n, 10);
+	}
+	return printNumber((unsigned long)n, base);
+}
+
+size_t Print::println() { return print("\r\n"); }
+size_t Print::println(const __FlashStringHelper *s) { return print(s) + println(); }
+size_t Print::println(const char s[]) { return print(s) + println(); }
+size_t Print::println(char c) { return print(c) + println(); }
+size_t Print::println(unsigned char n, int base) { return print(n, base) + println(); }
+size_t Print::println(int n, int base) { return print(n, base) + println(); }
+size_t Print::println(unsigned int n, int base) { return print(n, base) + println(); }
+size_t Print::println(long n, int base) { return print(n, base) + println(); }
+size_t Print::println(unsigned long n, int base) { return print(n, base) + println(); }
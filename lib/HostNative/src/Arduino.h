@@ -0,0 +1,134 @@
+/**
+ * Minimal Arduino core for host-native builds (env:native_emu).
+ *
+ * Only what the MFRC522 library and the user data code need is provided.
+ * Time is simulated: millis()/micros() advance through delay(), yield() and
+ * emulated bus traffic only, so runs are deterministic and independent of the host speed.
+ */
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <type_traits>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+#define NOT_AN_INTERRUPT -1
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define SS 10		// Default chip select of MFRC522(), as on an Uno
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+template <typename T, typename U>
+inline typename std::common_type<T, U>::type min(T a, U b) { return (a < b) ? a : b; }
+template <typename T, typename U>
+inline typename std::common_type<T, U>::type max(T a, U b) { return (a > b) ? a : b; }
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+inline int digitalPinToInterrupt(uint8_t pin) { return pin; }	// Every host pin can raise an interrupt.
+void attachInterrupt(uint8_t interruptNum, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t interruptNum);
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+class Print {
+public:
+	size_t write(uint8_t c);
+	size_t write(const uint8_t *buffer, size_t size);
+
+	size_t print(const __FlashStringHelper *s);
+	size_t print(const char s[]);
+	size_t print(char c);
+	size_t print(unsigned char n, int base = DEC);
+	size_t print(int n, int base = DEC);
+	size_t print(unsigned int n, int base = DEC);
+	size_t print(long n, int base = DEC);
+	size_t print(unsigned long n, int base = DEC);
+
+	size_t println(const __FlashStringHelper *s);
+	size_t println(const char s[]);
+	size_t println(char c);
+	size_t println(unsigned char n, int base = DEC);
+	size_t println(int n, int base = DEC);
+	size_t println(unsigned int n, int base = DEC);
+	size_t println(long n, int base = DEC);
+	size_t println(unsigned long n, int base = DEC);
+	size_t println();
+
+private:
+	size_t printNumber(unsigned long n, int base);
+};
+
+class HardwareSerial : public Print {
+public:
+	void begin(unsigned long) {}
+	operator bool() { return true; }
+};
+extern HardwareSerial Serial;
+
+// Hooks for emulated peripherals. Not part of the Arduino API.
+namespace host {
+	// Notified after every digitalWrite().
+	class PinListener {
+	public:
+		virtual ~PinListener() {}
+		virtual void onPinWrite(uint8_t pin, uint8_t level) = 0;
+	};
+
+	// Notified every time the simulated clock advances.
+	class TimeListener {
+	public:
+		virtual ~TimeListener() {}
+		virtual void onTimeAdvanced(uint64_t nowNanos) = 0;
+	};
+
+	static constexpr uint32_t YIELD_NANOS = 1000;	// Simulated cost of one yield(), i.e. one busy-wait loop iteration.
+
+	uint64_t nanos();
+	void advanceNanos(uint64_t ns);
+	void addTimeListener(TimeListener *listener);
+	void removeTimeListener(TimeListener *listener);
+	void addPinListener(PinListener *listener);
+	void removePinListener(PinListener *listener);
+	void setPinLevel(uint8_t pin, uint8_t level);	// Drive an input pin from a peripheral. Runs attached interrupt handlers on matching edges.
+	void setSerialEnabled(bool enabled);			// Silence Serial, e.g. while benchmarking.
+}
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,41 @@
+/**
+ * EEPROM for host-native builds, see EEPROM.h.
+ */
+#include "EEPROM.h"
+
+EEPROMClass EEPROM;
+
+namespace {
+	uint8_t cells[EEPROMClass::SIZE];
+	bool erased = false;
+	uint32_t writes = 0;
+
+	void eraseOnFirstUse() {
+		if (!erased) {
+			memset(cells, 0xFF, sizeof(cells));
+			erased = true;
+		}
+	}
+}
+
+uint8_t EEPROMClass::read(int address) const {
+	eraseOnFirstUse();
+	return (address >= 0 && address < SIZE) ? cells[address] : 0xFF;
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+	eraseOnFirstUse();
+	if (address >= 0 && address < SIZE) {
+		cells[address] = value;
+		writes++;
+	}
+}
+
+uint32_t host::eepromWrites() {
+	return writes;
+}
+
+void host::eraseEeprom() {
+	erased = false;
+	eraseOnFirstUse();
+}
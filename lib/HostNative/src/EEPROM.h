@@ -0,0 +1,39 @@
+/**
+ * EEPROM for host-native builds (env:native_emu).
+ *
+ * The subset of the AVR core's EEPROM library the project uses, backed by RAM that starts erased (0xFF),
+ * sized like the ATmega2560. Writes are counted to see the wear a change causes; they take no simulated time.
+ */
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+#include "Arduino.h"
+
+class EEPROMClass {
+public:
+	static constexpr uint16_t SIZE = 4096;
+
+	uint8_t read(int address) const;
+	void write(int address, uint8_t value);
+	void update(int address, uint8_t value) { if (read(address) != value) { write(address, value); } }
+	uint16_t length() const { return SIZE; }
+
+	template <typename T> T &get(int address, T &value) const {
+		uint8_t *bytes = (uint8_t *)&value;
+		for (size_t i = 0; i < sizeof(T); i++) { bytes[i] = read(address + (int)i); }
+		return value;
+	}
+	template <typename T> const T &put(int address, const T &value) {
+		const uint8_t *bytes = (const uint8_t *)&value;
+		for (size_t i = 0; i < sizeof(T); i++) { update(address + (int)i, bytes[i]); }
+		return value;
+	}
+};
+extern EEPROMClass EEPROM;
+
+namespace host {
+	uint32_t eepromWrites();		// Cells written since start, update() of an unchanged cell not included
+	void eraseEeprom();				// All cells back to 0xFF, as after a chip erase
+}
+
+#endif // HOST_EEPROM_H
@@ -0,0 +1,99 @@
+/**
+ * SPI for host-native builds (env:native_emu).
+ */
+#include "SPI.h"
+
+SPIClass SPI;
+
+namespace {
+	static constexpr uint8_t MAX_DEVICES = 8;
+
+	struct Slot {
+		uint8_t chipSelectPin;
+		host::SpiDevice *device;
+	};
+
+	Slot slots[MAX_DEVICES];
+	host::SpiDevice *selected = nullptr;
+	uint32_t clockHz = 4000000;
+	host::SpiStats stats;
+
+	// Routes chip select edges to the attached devices.
+	class ChipSelectWatcher : public host::PinListener {
+	public:
+		void onPinWrite(uint8_t pin, uint8_t level) override {
+			for (uint8_t i = 0; i < MAX_DEVICES; i++) {
+				if (slots[i].device == nullptr || slots[i].chipSelectPin != pin) {
+					continue;
+				}
+				if (level == LOW && selected != slots[i].device) {
+					selected = slots[i].device;
+					stats.frames++;
+					selected->spiSelect();
+				} else if (level == HIGH && selected == slots[i].device) {
+					selected = nullptr;
+					slots[i].device->spiDeselect();
+				}
+			}
+		}
+	};
+}
+
+void SPIClass::beginTransaction(SPISettings settings) {
+	clockHz = settings.clock ? settings.clock : 4000000;
+	stats.transactions++;
+}
+
+void SPIClass::endTransaction() {
+}
+
+uint8_t SPIClass::transfer(uint8_t data) {
+	const uint64_t ns = 8000000000ull / clockHz;
+	stats.bytes++;
+	stats.busNanos += ns;
+	host::advanceNanos(ns);
+	return (selected != nullptr) ? selected->spiTransfer(data) : 0xFF;
+}
+
+void SPIClass::transfer(void *buf, size_t count) {
+	uint8_t *p = static_cast<uint8_t *>(buf);
+	for (size_t i = 0; i < count; i++) {
+		p[i] = transfer(p[i]);
+	}
+}
+
+void host::attachSpiDevice(uint8_t chipSelectPin, SpiDevice *device) {
+	static ChipSelectWatcher watcher;	// Constructed on first use, devices may be static objects themselves.
+	static bool watching = false;
+	if (!watching) {
+		host::addPinListener(&watcher);
+		watching = true;
+	}
+	for (uint8_t i = 0; i < MAX_DEVICES; i++) {
+		if (slots[i].device == nullptr) {
+			slots[i].chipSelectPin = chipSelectPin;
+			slots[i].device = device;
+			return;
+		}
+	}
+	abort();
+}
+
+void host::detachSpiDevice(SpiDevice *device) {
+	for (uint8_t i = 0; i < MAX_DEVICES; i++) {
+		if (slots[i].device == device) {
+			slots[i].device = nullptr;
+		}
+	}
+	if (selected == device) {
+		selected = nullptr;
+	}
+}
+
+const host::SpiStats &host::spiStats() {
+	return stats;
+}
+
+void host::resetSpiStats() {
+	stats = host::SpiStats();
+}
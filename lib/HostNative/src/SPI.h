@@ -0,0 +1,63 @@
+/**
+ * SPI for host-native builds (env:native_emu).
+ *
+ * Transfers go to the host::SpiDevice whose chip select pin is LOW.
+ * Every byte advances the simulated clock by 8 SPI clock cycles.
+ */
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include "Arduino.h"
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+class SPISettings {
+public:
+	SPISettings() : clock(4000000), bitOrder(MSBFIRST), dataMode(SPI_MODE0) {}
+	SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) : clock(clock), bitOrder(bitOrder), dataMode(dataMode) {}
+	uint32_t clock;
+	uint8_t bitOrder;
+	uint8_t dataMode;
+};
+
+class SPIClass {
+public:
+	void begin() {}
+	void end() {}
+	void beginTransaction(SPISettings settings);
+	void endTransaction();
+	uint8_t transfer(uint8_t data);
+	void transfer(void *buf, size_t count);
+};
+extern SPIClass SPI;
+
+namespace host {
+	// A peripheral on the emulated SPI bus.
+	class SpiDevice {
+	public:
+		virtual ~SpiDevice() {}
+		virtual void spiSelect() = 0;					// Chip select went LOW.
+		virtual void spiDeselect() = 0;					// Chip select went HIGH.
+		virtual uint8_t spiTransfer(uint8_t mosi) = 0;	// One full-duplex byte. Returns MISO.
+	};
+
+	struct SpiStats {
+		uint32_t transactions;	// SPI.beginTransaction() calls
+		uint32_t frames;		// Chip select assertions of any attached device
+		uint32_t bytes;			// Bytes clocked
+		uint64_t busNanos;		// Simulated time spent clocking bytes
+	};
+
+	void attachSpiDevice(uint8_t chipSelectPin, SpiDevice *device);
+	void detachSpiDevice(SpiDevice *device);
+	const SpiStats &spiStats();
+	void resetSpiStats();
+}
+
+#endif // HOST_SPI_H
@@ -0,0 +1,713 @@
+/**
+ * Register-level MFRC522 emulator for host-native runs of the MFRC522 library.
+ */
+#include "MFRC522Emulator.h"
+
+namespace {
+	// Register numbers as in chapter 9 of the datasheet (not shifted like MFRC522::PCD_Register).
+	enum : uint8_t {
+		CommandReg		= 0x01,
+		ComIEnReg		= 0x02,
+		DivIEnReg		= 0x03,
+		ComIrqReg		= 0x04,
+		DivIrqReg		= 0x05,
+		ErrorReg		= 0x06,
+		Status1Reg		= 0x07,
+		Status2Reg		= 0x08,
+		FIFODataReg		= 0x09,
+		FIFOLevelReg	= 0x0A,
+		WaterLevelReg	= 0x0B,
+		ControlReg		= 0x0C,
+		BitFramingReg	= 0x0D,
+		CollReg			= 0x0E,
+		ModeReg			= 0x11,
+		TxModeReg		= 0x12,
+		RxModeReg		= 0x13,
+		TxControlReg	= 0x14,
+		DemodReg		= 0x19,
+		CRCResultRegH	= 0x21,
+		CRCResultRegL	= 0x22,
+		ModWidthReg		= 0x24,
+		TModeReg		= 0x2A,
+		TPrescalerReg	= 0x2B,
+		TReloadRegH		= 0x2C,
+		TReloadRegL		= 0x2D,
+		TCounterValueRegH	= 0x2E,
+		TCounterValueRegL	= 0x2F,
+		VersionReg		= 0x37
+	};
+
+	enum : uint8_t {
+		PCD_Idle				= 0x00,
+		PCD_Mem					= 0x01,
+		PCD_GenerateRandomID	= 0x02,
+		PCD_CalcCRC				= 0x03,
+		PCD_Transmit			= 0x04,
+		PCD_NoCmdChange			= 0x07,
+		PCD_Receive				= 0x08,
+		PCD_Transceive			= 0x0C,
+		PCD_MFAuthent			= 0x0E,
+		PCD_SoftReset			= 0x0F
+	};
+
+	// ComIrqReg bits
+	enum : uint8_t {
+		TxIRq		= 0x40,
+		RxIRq		= 0x20,
+		IdleIRq		= 0x10,
+		HiAlertIRq	= 0x08,
+		LoAlertIRq	= 0x04,
+		TimerIRq	= 0x01
+	};
+
+	// ErrorReg bits
+	enum : uint8_t {
+		BufferOvfl	= 0x10,
+		CollErr		= 0x08,
+		CRCErr		= 0x04
+	};
+
+	const uint16_t CRC_NANOS_PER_BYTE = 600;		// 8 bits at fc/2
+
+	// Reset values, datasheet chapter 9.3.
+	const uint8_t resetValues[64] = {
+		0x00, 0x20, 0x80, 0x00, 0x14, 0x00, 0x00, 0x21,	// 0x00
+		0x00, 0x00, 0x00, 0x08, 0x10, 0x00, 0xA0, 0x00,	// 0x08
+		0x00, 0x3F, 0x00, 0x00, 0x80, 0x00, 0x10, 0x84,	// 0x10
+		0x84, 0x4D, 0x00, 0x00, 0x62, 0x00, 0x00, 0xEB,	// 0x18
+		0x00, 0xFF, 0xFF, 0x00, 0x26, 0x00, 0x48, 0x88,	// 0x20
+		0x20, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0x28
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, MFRC522Emulator::VERSION,	// 0x30
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00	// 0x38
+	};
+
+	uint16_t crcPreset(uint8_t modeReg) {
+		static const uint16_t presets[4] = { 0x0000, 0x6363, 0xA671, 0xFFFF };
+		return presets[modeReg & 0x03];
+	}
+}
+
+MFRC522Emulator::MFRC522Emulator(uint8_t chipSelectPin, uint8_t resetPowerDownPin, uint8_t irqPin) {
+	_chipSelectPin = chipSelectPin;
+	_resetPowerDownPin = resetPowerDownPin;
+	_irqPin = irqPin;
+	_irqLevel = HIGH;
+	_resetHeld = false;
+	_fieldOn = false;
+	_spiAddressPending = false;
+	_spiRead = false;
+	_spiAddress = 0;
+	_spiOut = 0;
+	memset(_piccs, 0, sizeof(_piccs));
+	resetStats();
+	reset();
+
+	host::attachSpiDevice(_chipSelectPin, this);
+	host::addTimeListener(this);
+	host::addPinListener(this);
+}
+
+MFRC522Emulator::~MFRC522Emulator() {
+	host::detachSpiDevice(this);
+	host::removeTimeListener(this);
+	host::removePinListener(this);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Field
+/////////////////////////////////////////////////////////////////////////////////////
+
+bool MFRC522Emulator::addPicc(VirtualPicc *picc) {
+	for (uint8_t i = 0; i < MAX_PICCS; i++) {
+		if (_piccs[i] == nullptr) {
+			_piccs[i] = picc;
+			if (_fieldOn) {
+				picc->powerOn();
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+void MFRC522Emulator::removePicc(VirtualPicc *picc) {
+	for (uint8_t i = 0; i < MAX_PICCS; i++) {
+		if (_piccs[i] == picc) {
+			_piccs[i] = nullptr;
+			picc->powerOff();
+		}
+	}
+}
+
+void MFRC522Emulator::updateField() {
+	const bool on = !_resetHeld && !(_regs[CommandReg] & 0x10) && (_regs[TxControlReg] & 0x03);
+	if (on == _fieldOn) {
+		return;
+	}
+	_fieldOn = on;
+	if (on) {
+		_fieldOnAt = host::nanos();
+	} else {
+		_stats.fieldNanos += host::nanos() - _fieldOnAt;
+	}
+	for (uint8_t i = 0; i < MAX_PICCS; i++) {
+		if (_piccs[i] != nullptr) {
+			if (on) {
+				_piccs[i]->powerOn();
+			} else {
+				_piccs[i]->powerOff();
+			}
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Registers
+/////////////////////////////////////////////////////////////////////////////////////
+
+void MFRC522Emulator::reset() {
+	memcpy(_regs, resetValues, sizeof(_regs));
+	_fifoLevel = 0;
+	_txStartAt = _txByteAt = _txEndAt = NEVER;
+	_rxStartAt = _rxByteAt = _rxEndAt = _timerAt = _idleAt = _crcAt = NEVER;
+	_timerStartedAt = NEVER;
+	_authenticated = false;
+	_crcResult = 0xFFFF;
+	_collisionBit = -1;
+	_txFrame.clear();
+	_response.clear();
+	_rxCount = _rxPushed = 0;
+	updateField();
+	updateIrq();
+}
+
+void MFRC522Emulator::updateIrq() {
+	const bool active = (_regs[ComIrqReg] & _regs[ComIEnReg] & 0x7F) || (_regs[DivIrqReg] & _regs[DivIEnReg] & 0x14);
+	const bool inverted = _regs[ComIEnReg] & 0x80;
+	const uint8_t level = (active != inverted) ? HIGH : LOW;
+	if (_irqPin != UNUSED_PIN && level != _irqLevel) {
+		_irqLevel = level;
+		host::setPinLevel(_irqPin, level);
+	}
+	_irqLevel = level;
+}
+
+void MFRC522Emulator::fifoPush(uint8_t value) {
+	if (_fifoLevel >= FIFO_SIZE) {
+		_regs[ErrorReg] |= BufferOvfl;
+		return;
+	}
+	_fifo[_fifoLevel++] = value;
+	fifoChanged();
+}
+
+uint8_t MFRC522Emulator::fifoPop() {
+	const uint8_t value = _fifo[0];
+	memmove(_fifo, _fifo + 1, --_fifoLevel);
+	fifoChanged();
+	return value;
+}
+
+// HiAlertIRq and LoAlertIRq latch the HiAlert and LoAlert bits of Status1Reg whenever the FIFO level changes.
+void MFRC522Emulator::fifoChanged() {
+	const uint8_t before = _regs[ComIrqReg];
+	if (FIFO_SIZE - _fifoLevel <= _regs[WaterLevelReg]) {
+		_regs[ComIrqReg] |= HiAlertIRq;
+	}
+	if (_fifoLevel <= _regs[WaterLevelReg]) {
+		_regs[ComIrqReg] |= LoAlertIRq;
+	}
+	if (_regs[ComIrqReg] != before) {
+		updateIrq();
+	}
+}
+
+uint8_t MFRC522Emulator::readRegister(uint8_t reg) {
+	_stats.registerReads++;
+	switch (reg) {
+		case FIFODataReg: {
+			return (_fifoLevel == 0) ? 0 : fifoPop();
+		}
+		case FIFOLevelReg:
+			return _fifoLevel;
+		case Status1Reg: {
+			uint8_t value = 0x20;	// CRCReady, the coprocessor is never busy for long
+			if (_crcAt != NEVER) {
+				value &= ~0x20;
+			} else if (_crcResult == 0) {
+				value |= 0x40;		// CRCOk
+			}
+			if ((_regs[ComIrqReg] & _regs[ComIEnReg] & 0x7F) || (_regs[DivIrqReg] & _regs[DivIEnReg] & 0x14)) {
+				value |= 0x10;		// IRq
+			}
+			if (_timerAt != NEVER) {
+				value |= 0x08;		// TRunning
+			}
+			if (FIFO_SIZE - _fifoLevel <= _regs[WaterLevelReg]) {
+				value |= 0x02;		// HiAlert
+			}
+			if (_fifoLevel <= _regs[WaterLevelReg]) {
+				value |= 0x01;		// LoAlert
+			}
+			return value;
+		}
+		case TCounterValueRegH:
+		case TCounterValueRegL: {
+			uint16_t counter = 0;
+			if (_timerAt != NEVER) {
+				const uint64_t left = (_timerAt > host::nanos()) ? _timerAt - host::nanos() : 0;
+				counter = (uint16_t)(left / timerTickNanos());
+			}
+			return (reg == TCounterValueRegH) ? counter >> 8 : counter & 0xFF;
+		}
+		default:
+			return _regs[reg];
+	}
+}
+
+void MFRC522Emulator::writeRegister(uint8_t reg, uint8_t value) {
+	_stats.registerWrites++;
+	switch (reg) {
+		case CommandReg: {
+			const uint8_t command = value & 0x0F;
+			if (command == PCD_SoftReset) {
+				reset();
+				return;
+			}
+			_regs[CommandReg] = (_regs[CommandReg] & 0x0F) | (value & 0x30);
+			if (command != PCD_NoCmdChange) {
+				startCommand(command);
+			}
+			updateField();
+			break;
+		}
+		case ComIrqReg:
+			if (value & 0x80) {
+				_regs[ComIrqReg] |= value & 0x7F;
+			} else {
+				_regs[ComIrqReg] &= ~value;
+			}
+			updateIrq();
+			break;
+		case DivIrqReg:
+			if (value & 0x80) {
+				_regs[DivIrqReg] |= value & 0x14;
+			} else {
+				_regs[DivIrqReg] &= ~value;
+			}
+			updateIrq();
+			break;
+		case ComIEnReg:
+		case DivIEnReg:
+			_regs[reg] = value;
+			updateIrq();
+			break;
+		case FIFODataReg:
+			fifoPush(value);
+			break;
+		case FIFOLevelReg:
+			if (value & 0x80) {
+				_fifoLevel = 0;
+				_regs[ErrorReg] &= ~BufferOvfl;
+				fifoChanged();
+			}
+			break;
+		case ControlReg:
+			if (value & 0x80) {			// TStopNow
+				_timerAt = NEVER;
+			} else if (value & 0x40) {	// TStartNow
+				startTimer(host::nanos());
+			}
+			break;
+		case BitFramingReg:
+			_regs[BitFramingReg] = value;
+			if ((value & 0x80) && (_regs[CommandReg] & 0x0F) == PCD_Transceive) {
+				startTransmit();
+			}
+			break;
+		case Status2Reg:
+			// MFCrypto1On can only be cleared by software.
+			_regs[Status2Reg] = (value & 0xC0) | (_regs[Status2Reg] & value & 0x08) | (_regs[Status2Reg] & 0x07);
+			break;
+		case CollReg:
+			_regs[CollReg] = (value & 0x80) | (_regs[CollReg] & 0x7F);
+			break;
+		case TxControlReg:
+			_regs[TxControlReg] = value;
+			updateField();
+			break;
+		case ErrorReg:
+		case Status1Reg:
+		case CRCResultRegH:
+		case CRCResultRegL:
+		case TCounterValueRegH:
+		case TCounterValueRegL:
+		case VersionReg:
+			break;	// Read only
+		default:
+			_regs[reg] = value;
+			break;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Commands
+/////////////////////////////////////////////////////////////////////////////////////
+
+void MFRC522Emulator::startCommand(uint8_t command) {
+	// A new command cancels whatever the previous one was doing.
+	_txByteAt = _txEndAt = _rxStartAt = _rxByteAt = _rxEndAt = _idleAt = _crcAt = NEVER;
+	_regs[CommandReg] = (_regs[CommandReg] & 0xF0) | command;
+	if (command == PCD_Idle) {
+		return;
+	}
+	_stats.commands++;
+	_regs[ErrorReg] &= BufferOvfl;
+
+	switch (command) {
+		case PCD_CalcCRC:
+			_crcResult = iso14443aCrc(_fifo, _fifoLevel, crcPreset(_regs[ModeReg]));
+			_crcAt = host::nanos() + (uint64_t)_fifoLevel * CRC_NANOS_PER_BYTE + CRC_NANOS_PER_BYTE;
+			_fifoLevel = 0;
+			fifoChanged();
+			break;
+		case PCD_Transmit:
+			startTransmit();
+			break;
+		case PCD_Transceive:
+		case PCD_Receive:
+			break;	// Transceive waits for StartSend. Receive is not modelled: nothing arrives.
+		case PCD_MFAuthent:
+			startAuthent();
+			break;
+		default:
+			// Mem, GenerateRandomID and anything undocumented finish right away.
+			_idleAt = host::nanos();
+			break;
+	}
+}
+
+uint64_t MFRC522Emulator::timerTickNanos() const {
+	const uint32_t prescaler = ((uint32_t)(_regs[TModeReg] & 0x0F) << 8) | _regs[TPrescalerReg];
+	const uint32_t divider = 2 * prescaler + ((_regs[DemodReg] & 0x10) ? 2 : 1);	// TPrescalEven
+	return (uint64_t)divider * 1000000000ull / 13560000ull;
+}
+
+void MFRC522Emulator::startTimer(uint64_t at) {
+	const uint32_t reload = ((uint32_t)_regs[TReloadRegH] << 8) | _regs[TReloadRegL];
+	_timerStartedAt = at;
+	_timerAt = at + timerTickNanos() * (reload + 1);
+}
+
+/**
+ * Transmit or StartSend: after the start of frame the FIFO is sent one byte per 9 etu (8 bits and parity),
+ * so the host can keep writing while the frame is on the air. The frame ends when the FIFO is empty
+ * as the next byte is due.
+ */
+void MFRC522Emulator::startTransmit() {
+	_txStartAt = host::nanos();
+	_txFrame.clear();
+	_txFrame.speed = (_regs[TxModeReg] >> 4) & 0x03;
+	_txLastBits = _regs[BitFramingReg] & 0x07;
+	_rxStartAt = _rxByteAt = _rxEndAt = NEVER;
+	_collisionBit = -1;
+	_response.clear();
+	_txByteAt = _txStartAt + _txFrame.etuNanos();
+}
+
+void MFRC522Emulator::takeTxByte(uint64_t at) {
+	if (_fifoLevel == 0) {
+		_txByteAt = NEVER;
+		finishTransmit();
+		return;
+	}
+	const uint8_t value = fifoPop();
+	if (_txFrame.bytes() < RfFrame::MAX_BYTES) {
+		_txFrame.data[_txFrame.bytes()] = value;
+	}
+	// TxLastBits applies to the last byte of the frame, the one that empties the FIFO.
+	if (_fifoLevel == 0 && _txLastBits) {
+		_txFrame.bits += _txLastBits;
+		_txByteAt = NEVER;
+		finishTransmit();
+		return;
+	}
+	_txFrame.bits += 8;
+	_txByteAt = at + 9 * _txFrame.etuNanos();
+}
+
+void MFRC522Emulator::finishTransmit() {
+	RfFrame &frame = _txFrame;
+	if (frame.bits > RfFrame::MAX_BYTES * 8u) {
+		frame.bits = RfFrame::MAX_BYTES * 8u;	// Longer than any PICC accepts, it only has to fail
+	}
+	if ((_regs[TxModeReg] & 0x80) && frame.bits % 8 == 0 && frame.bits > 0 && frame.bytes() + 2 <= RfFrame::MAX_BYTES) {
+		frame.appendCrc();	// TxCRCEn
+	}
+
+	const uint32_t txNanos = frame.airNanos();
+	_txEndAt = _txStartAt + txNanos;
+	_stats.rfFrames++;
+	_stats.rfNanos += txNanos;
+	// A modulation pause longer than half a bit (64/fc at 106 kBd) cannot be decoded by the PICC.
+	if (!_fieldOn || frame.bits == 0 || _regs[ModWidthReg] + 1u >= (64u >> frame.speed)) {
+		_stats.rfTimeouts++;
+		return;
+	}
+
+	// Ask every PICC in the field. Answers are superimposed bit by bit.
+	const bool crypto = _regs[Status2Reg] & 0x08;
+	uint8_t answers = 0;
+	uint32_t processingNanos = 0;
+	for (uint8_t i = 0; i < MAX_PICCS; i++) {
+		if (_piccs[i] == nullptr) {
+			continue;
+		}
+		RfFrame answer;
+		uint32_t processing = 0;
+		if (!_piccs[i]->receive(frame, crypto, answer, processing)) {
+			continue;
+		}
+		if (answers == 0) {
+			_response = answer;
+		} else {
+			const uint16_t common = min(_response.bits, answer.bits);
+			// The first bit where this answer differs from the ones before, if that is earlier than the collision so far.
+			for (uint16_t b = 0; b < common; b++) {
+				if (_response.bit(b) != answer.bit(b)) {
+					if (_collisionBit < 0 || b < _collisionBit) {
+						_collisionBit = b;
+					}
+					break;
+				}
+			}
+			for (uint16_t b = 0; b < answer.bits; b++) {
+				_response.setBit(b, (b < _response.bits && _response.bit(b)) || answer.bit(b));
+			}
+			_response.bits = max(_response.bits, answer.bits);
+		}
+		processingNanos = max(processingNanos, processing);
+		answers++;
+	}
+	if (answers == 0 || _response.speed != ((_regs[RxModeReg] >> 4) & 0x03)) {
+		_stats.rfTimeouts++;	// An answer at another bit rate is not even recognised as a frame
+		return;
+	}
+	if (answers > 1) {
+		_stats.collisions++;
+	}
+	_rxStartAt = _txEndAt + ISO14443A_FDT_NANOS + processingNanos;
+	_rxEndAt = _rxStartAt + _response.airNanos();
+	_stats.rfNanos += _rxEndAt - _txEndAt;
+}
+
+/**
+ * MFAuthent: 60/61, block, CRC -> nonce (4) -> token (8) -> token (4).
+ * The PICC decides right away, the timing follows the frames of a real authentication.
+ */
+void MFRC522Emulator::startAuthent() {
+	const uint64_t now = host::nanos();
+	uint8_t buffer[12];
+	const bool complete = (_fifoLevel >= 12);
+	memcpy(buffer, _fifo, complete ? 12 : _fifoLevel);
+	_fifoLevel = 0;
+	fifoChanged();
+
+	_authenticated = false;
+	for (uint8_t i = 0; i < MAX_PICCS && complete && _fieldOn; i++) {
+		if (_piccs[i] != nullptr && _piccs[i]->mifareAuthenticate(buffer[0], buffer[1], &buffer[2], &buffer[8])) {
+			_authenticated = true;
+		}
+	}
+
+	RfFrame frame;
+	frame.clear();
+	frame.bits = 4 * 8;
+	const uint32_t shortFrame = frame.airNanos();
+	frame.bits = 8 * 8;
+	const uint32_t tokenFrame = frame.airNanos();
+	const uint64_t untilToken = shortFrame + ISO14443A_FDT_NANOS + shortFrame + ISO14443A_FDT_NANOS + tokenFrame;
+	_stats.rfFrames += 2;
+	if (_authenticated) {
+		const uint64_t total = untilToken + ISO14443A_FDT_NANOS + shortFrame;
+		_stats.rfNanos += total;
+		_idleAt = now + total;
+	} else {
+		// No answer to the token. Starts the timer like any other unanswered frame.
+		_stats.rfNanos += untilToken;
+		_stats.rfTimeouts++;
+		_txEndAt = now + untilToken;
+	}
+}
+
+/**
+ * Works out what the answer leaves in the FIFO: collisions, RxCRCEn and RxAlign applied. The bytes then
+ * arrive one per 9 etu; errors, RxLastBits and RxIRq only at the end of the frame.
+ */
+void MFRC522Emulator::startReception(uint64_t at) {
+	RfFrame frame = _response;
+	const uint8_t rxAlign = (_regs[BitFramingReg] >> 4) & 0x07;
+	const bool valuesAfterColl = _regs[CollReg] & 0x80;
+
+	_rxErrors = 0;
+	if (_collisionBit >= 0) {
+		_rxErrors |= CollErr;
+		if (!valuesAfterColl) {
+			for (uint16_t b = (uint16_t)_collisionBit; b < frame.bits; b++) {
+				frame.setBit(b, false);
+			}
+		}
+	}
+	if ((_regs[RxModeReg] & 0x80) && !frame.checkAndStripCrc()) {
+		_rxErrors |= CRCErr;	// RxCRCEn
+	}
+
+	// The first received bit lands at bit position RxAlign of the first FIFO byte.
+	memset(_rxData, 0, sizeof(_rxData));
+	for (uint16_t b = 0; b < frame.bits; b++) {
+		const uint16_t position = rxAlign + b;
+		if (frame.bit(b)) {
+			_rxData[position / 8] |= (uint8_t)(1 << (position % 8));
+		}
+	}
+	const uint16_t totalBits = rxAlign + frame.bits;
+	_rxCount = (totalBits + 7) / 8;
+	_rxPushed = 0;
+	_rxLastBits = totalBits % 8;
+	_rxByteAt = (_rxCount > 0) ? at + 10 * _response.etuNanos() : NEVER;	// Start of frame and the first byte
+}
+
+void MFRC522Emulator::pushRxByte() {
+	fifoPush(_rxData[_rxPushed++]);
+	_rxByteAt = (_rxPushed < _rxCount) ? _rxByteAt + 9 * _response.etuNanos() : NEVER;
+}
+
+void MFRC522Emulator::finishReception() {
+	while (_rxPushed < _rxCount) {
+		pushRxByte();	// A partial last byte and the bytes the stripped CRC was timed for
+	}
+	_rxByteAt = NEVER;
+	if (_collisionBit >= 0) {
+		// CollPos counts from bit 0 of the first FIFO byte, RxAlign included. 0 means the 32nd bit.
+		const uint16_t position = ((_regs[BitFramingReg] >> 4) & 0x07) + _collisionBit + 1;
+		_regs[CollReg] = (_regs[CollReg] & 0x80) | ((position > 32) ? 0x20 : (position & 0x1F));
+	} else {
+		_regs[CollReg] = (_regs[CollReg] & 0x80) | 0x20;	// CollPosNotValid
+	}
+	_regs[ErrorReg] |= _rxErrors;
+	_regs[ControlReg] = (_regs[ControlReg] & 0xF8) | _rxLastBits;
+	_regs[ComIrqReg] |= RxIRq;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Simulated time
+/////////////////////////////////////////////////////////////////////////////////////
+
+void MFRC522Emulator::onTimeAdvanced(uint64_t nowNanos) {
+	for (;;) {
+		uint64_t next = min(min(_txEndAt, _rxStartAt), min(_rxEndAt, _timerAt));
+		next = min(next, min(_idleAt, _crcAt));
+		next = min(next, min(_txByteAt, _rxByteAt));
+		if (next > nowNanos) {
+			break;
+		}
+		if (next == _txByteAt) {
+			takeTxByte(next);
+		} else if (next == _rxByteAt) {
+			pushRxByte();
+		} else if (next == _txEndAt) {
+			_txEndAt = NEVER;
+			_regs[ComIrqReg] |= TxIRq;
+			if ((_regs[CommandReg] & 0x0F) == PCD_Transmit) {
+				_regs[ComIrqReg] |= IdleIRq;
+				_regs[CommandReg] &= 0xF0;
+			}
+			if (_regs[TModeReg] & 0x80) {	// TAuto: the timer starts when transmission ends
+				startTimer(next);
+			}
+		} else if (next == _rxStartAt) {
+			_rxStartAt = NEVER;
+			if (_regs[TModeReg] & 0x80) {	// TAuto: and stops when reception starts
+				_timerAt = NEVER;
+			}
+			startReception(next);
+		} else if (next == _rxEndAt) {
+			_rxEndAt = NEVER;
+			finishReception();
+		} else if (next == _timerAt) {
+			_regs[ComIrqReg] |= TimerIRq;
+			if (_regs[TModeReg] & 0x10) {	// TAutoRestart
+				startTimer(next);
+			} else {
+				_timerAt = NEVER;
+			}
+		} else if (next == _idleAt) {
+			_idleAt = NEVER;
+			if ((_regs[CommandReg] & 0x0F) == PCD_MFAuthent && _authenticated) {
+				_regs[Status2Reg] |= 0x08;	// MFCrypto1On
+			}
+			_regs[ComIrqReg] |= IdleIRq;
+			_regs[CommandReg] &= 0xF0;
+		} else {
+			_crcAt = NEVER;
+			_regs[CRCResultRegL] = _crcResult & 0xFF;
+			_regs[CRCResultRegH] = _crcResult >> 8;
+			_regs[DivIrqReg] |= 0x04;	// CRCIRq
+		}
+		updateIrq();
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Pins and SPI
+/////////////////////////////////////////////////////////////////////////////////////
+
+void MFRC522Emulator::onPinWrite(uint8_t pin, uint8_t level) {
+	if (pin != _resetPowerDownPin || _resetPowerDownPin == UNUSED_PIN) {
+		return;
+	}
+	// NRSTPD low: hard power down. Registers come back with reset values.
+	if (level == LOW && !_resetHeld) {
+		_resetHeld = true;
+		reset();
+	} else if (level == HIGH && _resetHeld) {
+		_resetHeld = false;
+		updateField();
+	}
+}
+
+void MFRC522Emulator::spiSelect() {
+	_spiAddressPending = true;
+	_stats.spiFrames++;
+}
+
+void MFRC522Emulator::spiDeselect() {
+	_spiAddressPending = false;
+}
+
+/**
+ * Datasheet 8.1.2: the first byte is the address, MSB set for reads. A write continues with
+ * data bytes for the same register. A read continues with address bytes, each clocking out
+ * the value of the previously addressed register, and is closed with 0.
+ */
+uint8_t MFRC522Emulator::spiTransfer(uint8_t mosi) {
+	if (_resetHeld) {
+		return 0;
+	}
+	if (_spiAddressPending) {
+		_spiAddressPending = false;
+		_spiRead = mosi & 0x80;
+		_spiAddress = (mosi >> 1) & 0x3F;
+		if (_spiRead) {
+			_spiOut = readRegister(_spiAddress);
+		}
+		return 0;
+	}
+	if (!_spiRead) {
+		writeRegister(_spiAddress, mosi);
+		return 0;
+	}
+	const uint8_t out = _spiOut;
+	_spiOut = (mosi & 0x80) ? readRegister((mosi >> 1) & 0x3F) : 0;
+	return out;
+}
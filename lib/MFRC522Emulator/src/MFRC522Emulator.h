@@ -0,0 +1,136 @@
+/**
+ * Register-level MFRC522 emulator for host-native runs of the MFRC522 library.
+ *
+ * Sits on the emulated SPI bus (see HostNative SPI.h) and models what the library
+ * relies on: the register file with reset values, the 64 byte FIFO, the timer,
+ * ComIrqReg/DivIrqReg and the IRQ pin, the CRC coprocessor, TxCRCEn/RxCRCEn,
+ * bit oriented frames with RxAlign/TxLastBits, collisions, MFAuthent and the RF field.
+ * PICCs (see VirtualPicc.h) are put into the field with addPicc().
+ *
+ * All activity is timed on the simulated clock: SPI bytes at the configured
+ * SPI clock, frames at the TxSpeed/RxSpeed bit rate (106 to 848 kBd) plus the
+ * frame delay time of the PICC. A frame reaches the PICCs only if ModWidthReg
+ * keeps the modulation pause within half a bit, and the answer only if the PICC
+ * sends at RxSpeed. The FIFO
+ * drains and fills one byte per 9 etu while a frame is on the air, so frames
+ * longer than the FIFO work as on the chip: the host tops it up or drains it
+ * in time (HiAlert/LoAlert against WaterLevelReg), or the frame ends early
+ * (transmit) or BufferOvfl is set (receive).
+ * Not modelled: analog settings, the UART/I2C interfaces, the self-test, Mem and Receive commands.
+ */
+#ifndef MFRC522_EMULATOR_H
+#define MFRC522_EMULATOR_H
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "VirtualPicc.h"
+
+class MFRC522Emulator : public host::SpiDevice, public host::TimeListener, public host::PinListener {
+public:
+	static constexpr uint8_t UNUSED_PIN = UINT8_MAX;
+	static constexpr uint8_t MAX_PICCS = 8;
+	static constexpr uint8_t FIFO_SIZE = 64;
+	static constexpr uint8_t VERSION = 0x92;	// MFRC522 version 2.0
+
+	struct Stats {
+		uint32_t spiFrames;			// Chip select assertions addressed to this reader
+		uint32_t registerReads;		// Every address byte of a read, FIFODataReg included
+		uint32_t registerWrites;	// Every data byte of a write, FIFODataReg included
+		uint32_t commands;			// Commands started through CommandReg, Idle excluded
+		uint32_t rfFrames;			// Frames sent by the PCD, MFAuthent counts its two frames
+		uint32_t rfTimeouts;		// Frames no PICC answered
+		uint32_t collisions;		// Frames with more than one answer
+		uint64_t rfNanos;			// Time on air, PCD and PICC frames and the delays in between
+		uint64_t fieldNanos;		// Time with the RF field on, up to the last field change. See fieldNanos().
+	};
+
+	MFRC522Emulator(uint8_t chipSelectPin, uint8_t resetPowerDownPin = UNUSED_PIN, uint8_t irqPin = UNUSED_PIN);
+	~MFRC522Emulator();
+
+	bool addPicc(VirtualPicc *picc);		// Moves a PICC into the field
+	void removePicc(VirtualPicc *picc);		// Takes a PICC out of the field
+	bool fieldOn() const { return _fieldOn; }
+
+	const Stats &stats() const { return _stats; }
+	void resetStats() { memset(&_stats, 0, sizeof(_stats)); _fieldOnAt = host::nanos(); }
+	uint64_t fieldNanos() const { return _stats.fieldNanos + (_fieldOn ? host::nanos() - _fieldOnAt : 0); }	// Including the current field-on period
+	uint8_t peekRegister(uint8_t reg) const { return _regs[reg & 0x3F]; }	// Register number as in the datasheet, without side effects
+
+	// host::SpiDevice
+	void spiSelect() override;
+	void spiDeselect() override;
+	uint8_t spiTransfer(uint8_t mosi) override;
+	// host::TimeListener
+	void onTimeAdvanced(uint64_t nowNanos) override;
+	// host::PinListener
+	void onPinWrite(uint8_t pin, uint8_t level) override;
+
+private:
+	static constexpr uint64_t NEVER = UINT64_MAX;
+
+	void reset();
+	uint8_t readRegister(uint8_t reg);
+	void writeRegister(uint8_t reg, uint8_t value);
+	void startCommand(uint8_t command);
+	void startTransmit();
+	void takeTxByte(uint64_t at);
+	void finishTransmit();
+	void startAuthent();
+	void startTimer(uint64_t at);
+	uint64_t timerTickNanos() const;
+	void startReception(uint64_t at);
+	void pushRxByte();
+	void finishReception();
+	void fifoPush(uint8_t value);
+	uint8_t fifoPop();
+	void fifoChanged();
+	void updateField();
+	void updateIrq();
+
+	uint8_t _chipSelectPin;
+	uint8_t _resetPowerDownPin;
+	uint8_t _irqPin;
+	uint8_t _irqLevel;
+
+	uint8_t _regs[64];
+	uint8_t _fifo[FIFO_SIZE];
+	uint8_t _fifoLevel;
+	bool _resetHeld;
+	bool _fieldOn;
+	uint64_t _fieldOnAt;
+
+	// SPI slave state
+	bool _spiAddressPending;
+	bool _spiRead;
+	uint8_t _spiAddress;
+	uint8_t _spiOut;
+
+	// Scheduled events on the simulated clock
+	uint64_t _txStartAt;
+	uint64_t _txByteAt;			// Next byte leaves the FIFO
+	uint64_t _txEndAt;
+	uint64_t _rxStartAt;
+	uint64_t _rxByteAt;			// Next byte of _rxData arrives in the FIFO
+	uint64_t _rxEndAt;
+	uint64_t _timerAt;
+	uint64_t _timerStartedAt;
+	uint64_t _idleAt;
+	uint64_t _crcAt;
+	bool _authenticated;		// Result of the MFAuthent in progress
+	uint16_t _crcResult;
+
+	RfFrame _txFrame;			// Frame being sent, bytes are added as they leave the FIFO
+	uint8_t _txLastBits;
+	RfFrame _response;			// Merged answer of all PICCs, received from _rxStartAt to _rxEndAt
+	int16_t _collisionBit;		// First collided bit of _response, -1 for none
+	uint8_t _rxData[RfFrame::MAX_BYTES + 1];	// _response as it lands in the FIFO: RxAlign applied, CRC stripped
+	uint16_t _rxCount;
+	uint16_t _rxPushed;
+	uint8_t _rxLastBits;
+	uint8_t _rxErrors;			// ErrorReg bits set at the end of reception
+
+	VirtualPicc *_piccs[MAX_PICCS];
+	Stats _stats;
+};
+
+#endif // MFRC522_EMULATOR_H
@@ -0,0 +1,326 @@
+/**
+ * ISO/IEC 14443-4 PICC for the MFRC522 emulator.
+ */
+#include "VirtualIsoDepCard.h"
+
+namespace {
+	// PCB of the three block types, ISO/IEC 14443-4 7.1.1.2. CID (0x08) and block number (0x01) are added when sent.
+	enum : uint8_t {
+		PCB_I			= 0x02,
+		PCB_I_CHAINING	= 0x12,
+		PCB_R_ACK		= 0xA2,
+		PCB_R_NAK		= 0xB2,
+		PCB_S_DESELECT	= 0xC2,
+		PCB_S_WTX		= 0xF2
+	};
+
+	// FSDI and FSCI to bytes, ISO/IEC 14443-4 5.1. Values above 8 are RFU and treated as 256.
+	uint16_t frameSize(uint8_t index) {
+		static const uint16_t sizes[9] = { 16, 24, 32, 40, 48, 64, 96, 128, 256 };
+		return sizes[min(index, (uint8_t)8)];
+	}
+
+	uint16_t atqaFor(uint8_t uidSize) {
+		return (uidSize == 4) ? 0x0004 : ((uidSize == 7) ? 0x0344 : 0x0084);
+	}
+}
+
+VirtualIsoDepCard::VirtualIsoDepCard(const uint8_t *uid, uint8_t uidSize, uint8_t fsci, uint8_t fwi, uint8_t ta1)
+	: Iso14443aPicc(uid, uidSize, atqaFor(uidSize), 0x20) {
+	_fsci = min(fsci, (uint8_t)8);
+	_fwi = min(fwi, (uint8_t)14);
+	_ta1 = ta1 & 0xF7;		// b4 is RFU
+	_dropAnswers = 0;
+	memset(_file, 0, sizeof(_file));
+	resetStats();
+	onDeselect();
+}
+
+void VirtualIsoDepCard::onDeselect() {
+	_protocolActive = false;
+	_ppsAllowed = false;
+	_blockNumber = true;		// The PICC starts with block number 1, ISO/IEC 14443-4 7.5.3.1
+	_cid = false;
+	_fsd = 32;
+	_commandLength = 0;
+	_commandOverflow = false;
+	_responseLength = 0;
+	_responseSent = 0;
+	_pendingNanos = 0;
+	_lastBlock.clear();
+}
+
+bool VirtualIsoDepCard::receiveActive(const RfFrame &request, bool crypto, RfFrame &response, uint32_t &processingNanos) {
+	(void)crypto;
+	RfFrame frame = request;
+	const bool valid = frame.bits % 8 == 0 && frame.checkAndStripCrc() && frame.bytes() > 0;
+
+	if (!_protocolActive) {
+		// RATS: E0, FSDI and CID
+		if (!valid || frame.bytes() != 2 || frame.data[0] != 0xE0) {
+			dropToIdle();
+			return false;
+		}
+		_fsd = frameSize(frame.data[1] >> 4);
+		_protocolActive = true;
+		_ppsAllowed = true;
+		// TL, T0 (TA1, TB1 and TC1 follow, FSCI), TA1 (bit rates), TB1 (FWI, SFGI 0), TC1 (CID supported)
+		const uint8_t ats[5] = { 5, (uint8_t)(0x70 | _fsci), _ta1, (uint8_t)(_fwi << 4), 0x02 };
+		response.assign(ats, sizeof(ats));
+		response.appendCrc();
+		return true;
+	}
+	if (!valid) {
+		return false;	// Invalid blocks are ignored, the PCD times out and recovers, ISO/IEC 14443-4 7.5.5
+	}
+
+	// PPS: Dx, PPS0 [, PPS1 with DSI and DRI], ISO/IEC 14443-4 5.3. Answered with the start byte at 106 kBd,
+	// the new bit rates apply from the next block on. Bit rates TA1 does not offer are not answered.
+	if (_ppsAllowed && (frame.data[0] & 0xF0) == 0xD0) {
+		_ppsAllowed = false;
+		uint8_t dsi = 0;
+		uint8_t dri = 0;
+		if (frame.bytes() == 3 && frame.data[1] == 0x11) {
+			dsi = (frame.data[2] >> 2) & 0x03;
+			dri = frame.data[2] & 0x03;
+		} else if (frame.bytes() != 2 || frame.data[1] != 0x00) {
+			return false;
+		}
+		const bool dsOffered = dsi == 0 || (_ta1 & (0x10 << (dsi - 1)));
+		const bool drOffered = dri == 0 || (_ta1 & (0x01 << (dri - 1)));
+		if (!dsOffered || !drOffered || ((_ta1 & 0x80) && dsi != dri)) {
+			return false;
+		}
+		response.assign(frame.data, 1);
+		response.appendCrc();
+		setBitRates(dsi, dri);
+		return true;
+	}
+	_ppsAllowed = false;
+
+	if (!receiveBlock(frame, response, processingNanos)) {
+		return false;
+	}
+	if (_dropAnswers > 0) {
+		_dropAnswers--;
+		processingNanos = 0;
+		return false;
+	}
+	return true;
+}
+
+bool VirtualIsoDepCard::receiveBlock(const RfFrame &frame, RfFrame &response, uint32_t &processingNanos) {
+	const uint8_t pcb = frame.data[0];
+	uint16_t offset = 1;
+	_cid = pcb & 0x08;
+	if (_cid) {
+		if (frame.bytes() < 2 || frame.data[1] != 0x00) {
+			return false;	// Another CID
+		}
+		offset++;
+	}
+	if (pcb & 0x04) {
+		offset++;			// NAD, not used
+	}
+	if (offset > frame.bytes()) {
+		return false;
+	}
+	const uint8_t *inf = frame.data + offset;
+	const uint16_t infLength = frame.bytes() - offset;
+
+	// I-block: the PICC toggles its block number and answers with the same one (rule C).
+	if ((pcb & 0xE2) == 0x02) {
+		_stats.iBlocksIn++;
+		_blockNumber = !_blockNumber;
+		_pendingNanos = 0;
+		_responseLength = _responseSent = 0;
+		if (_commandLength + infLength > MAX_APDU) {
+			_commandOverflow = true;
+		} else {
+			memcpy(_command + _commandLength, inf, infLength);
+			_commandLength += infLength;
+		}
+		if (pcb & 0x10) {
+			sendR(response, true);	// More to come
+			return true;
+		}
+		uint32_t busyNanos = 0;
+		execute(busyNanos);
+		if (busyNanos > fwtNanos()) {
+			// Ask for FWT * WTXM, enough to finish (ISO/IEC 14443-4 7.3, WTXM at most 59).
+			const uint8_t wtxm = (uint8_t)min((busyNanos + fwtNanos() - 1) / fwtNanos(), (uint32_t)59);
+			_pendingNanos = busyNanos;
+			_stats.wtxRequests++;
+			sendS(response, PCB_S_WTX, &wtxm, 1);
+			return true;
+		}
+		processingNanos = busyNanos;
+		sendNextI(response);
+		return true;
+	}
+
+	// R-block: with the current block number the last block is repeated (rule 11). R(NAK) with the other one
+	// is answered with R(ACK) (rule 12), R(ACK) with the other one acknowledges a chained I-block (rule 13).
+	if ((pcb & 0xE6) == 0xA2) {
+		const bool nak = pcb & 0x10;
+		if (nak) {
+			_stats.naksIn++;
+		} else {
+			_stats.acksIn++;
+		}
+		if ((bool)(pcb & 0x01) == _blockNumber) {
+			_stats.retransmissions++;
+			response = _lastBlock;
+			return _lastBlock.bits > 0;
+		}
+		if (nak) {
+			sendR(response, true);
+			return true;
+		}
+		_blockNumber = !_blockNumber;
+		if (_responseSent >= _responseLength) {
+			return false;
+		}
+		sendNextI(response);
+		return true;
+	}
+
+	if ((pcb & 0xF7) == PCB_S_DESELECT) {
+		sendS(response, PCB_S_DESELECT, nullptr, 0);
+		halt();
+		return true;
+	}
+
+	// S(WTX) response: the PCD grants the extension, the answer follows when the work is done.
+	if ((pcb & 0xF7) == PCB_S_WTX && _pendingNanos > 0) {
+		processingNanos = _pendingNanos;
+		_pendingNanos = 0;
+		sendNextI(response);
+		return true;
+	}
+	return false;
+}
+
+/**
+ * Runs the command APDU in _command, ISO/IEC 7816-4 5.1: CLA INS P1 P2, then short (1 byte) or
+ * extended (00 and 2 bytes) Lc with data and/or Le. P1 P2 is the offset into the file.
+ */
+void VirtualIsoDepCard::execute(uint32_t &busyNanos) {
+	_stats.apdus++;
+	const uint8_t *apdu = _command;
+	const uint16_t length = _commandLength;
+	const bool overflow = _commandOverflow;
+	_commandLength = 0;
+	_commandOverflow = false;
+	_responseLength = 0;
+
+	uint16_t sw = 0x9000;
+	uint32_t lc = 0;
+	uint32_t le = 0;
+	const uint8_t *data = nullptr;
+	const uint8_t *body = apdu + 4;
+	const uint16_t bodyLength = (length >= 4) ? length - 4 : 0;
+	bool wellFormed = !overflow && length >= 4;
+	if (wellFormed && bodyLength == 1) {
+		le = body[0] ? body[0] : 256;
+	} else if (wellFormed && bodyLength > 1 && body[0] != 0) {
+		lc = body[0];
+		data = body + 1;
+		if (bodyLength == 2 + lc) {
+			le = body[1 + lc] ? body[1 + lc] : 256;
+		} else if (bodyLength != 1 + lc) {
+			wellFormed = false;
+		}
+	} else if (wellFormed && bodyLength == 3) {
+		le = ((uint32_t)body[1] << 8) | body[2];
+		le = le ? le : 65536;
+	} else if (wellFormed && bodyLength > 3) {
+		lc = ((uint32_t)body[1] << 8) | body[2];
+		data = body + 3;
+		if (bodyLength == 5 + lc) {
+			le = ((uint32_t)body[3 + lc] << 8) | body[4 + lc];
+			le = le ? le : 65536;
+		} else if (bodyLength != 3 + lc) {
+			wellFormed = false;
+		}
+	} else if (wellFormed && bodyLength != 0) {
+		wellFormed = false;
+	}
+
+	const uint16_t offset = ((uint16_t)(apdu[2] & 0x7F) << 8) | apdu[3];
+	if (!wellFormed) {
+		sw = 0x6700;
+	} else if (apdu[0] != 0x00) {
+		sw = 0x6E00;		// CLA not supported
+	} else if (apdu[1] == 0xB0) {
+		if (lc != 0 || le == 0) {
+			sw = 0x6700;
+		} else if (offset >= FILE_SIZE) {
+			sw = 0x6B00;	// Wrong P1 P2
+		} else {
+			const uint16_t count = (uint16_t)min(le, (uint32_t)min((uint16_t)(FILE_SIZE - offset), (uint16_t)(MAX_APDU - 2)));
+			memcpy(_response, _file + offset, count);
+			_responseLength = count;
+		}
+	} else if (apdu[1] == 0xD6) {
+		if (lc == 0) {
+			sw = 0x6700;
+		} else if (offset + lc > FILE_SIZE) {
+			sw = 0x6B00;
+		} else {
+			memcpy(_file + offset, data, lc);
+			busyNanos = lc * UPDATE_NANOS_PER_BYTE;
+		}
+	} else {
+		sw = 0x6D00;		// INS not supported
+	}
+	_response[_responseLength++] = sw >> 8;
+	_response[_responseLength++] = sw & 0xFF;
+}
+
+void VirtualIsoDepCard::sendNextI(RfFrame &response) {
+	const uint16_t maxInf = _fsd - (_cid ? 4 : 3);		// PCB, CID and CRC_A
+	const uint16_t chunk = min((uint16_t)(_responseLength - _responseSent), maxInf);
+	const bool chaining = (_responseSent + chunk < _responseLength);
+	response.clear();
+	uint16_t n = 0;
+	response.data[n++] = (chaining ? PCB_I_CHAINING : PCB_I) | (_cid ? 0x08 : 0x00) | (_blockNumber ? 0x01 : 0x00);
+	if (_cid) {
+		response.data[n++] = 0x00;
+	}
+	memcpy(response.data + n, _response + _responseSent, chunk);
+	response.bits = (n + chunk) * 8u;
+	_responseSent += chunk;
+	_stats.iBlocksOut++;
+	finish(response);
+}
+
+void VirtualIsoDepCard::sendR(RfFrame &response, bool ack) {
+	response.clear();
+	uint16_t n = 0;
+	response.data[n++] = (ack ? PCB_R_ACK : PCB_R_NAK) | (_cid ? 0x08 : 0x00) | (_blockNumber ? 0x01 : 0x00);
+	if (_cid) {
+		response.data[n++] = 0x00;
+	}
+	response.bits = n * 8u;
+	finish(response);
+}
+
+void VirtualIsoDepCard::sendS(RfFrame &response, uint8_t pcb, const uint8_t *inf, uint8_t size) {
+	response.clear();
+	uint16_t n = 0;
+	response.data[n++] = pcb | (_cid ? 0x08 : 0x00);
+	if (_cid) {
+		response.data[n++] = 0x00;
+	}
+	if (size > 0) {
+		memcpy(response.data + n, inf, size);
+	}
+	response.bits = (n + size) * 8u;
+	finish(response);
+}
+
+void VirtualIsoDepCard::finish(RfFrame &response) {
+	response.appendCrc();
+	_lastBlock = response;
+}
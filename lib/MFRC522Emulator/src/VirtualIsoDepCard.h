@@ -0,0 +1,82 @@
+/**
+ * ISO/IEC 14443-4 PICC for the MFRC522 emulator: a minimal contactless smart card.
+ *
+ * Answers RATS with an ATS carrying the configured FSCI, FWI and TA1, switches bit rates with PPS, and runs the
+ * block protocol of ISO/IEC 14443-4 chapter 7: I-block chaining in both directions, R(ACK)
+ * and R(NAK) with the block number rules, S(WTX) when an APDU takes longer than FWT, and
+ * S(DESELECT). The application is one transparent file with the ISO/IEC 7816-4 commands
+ * READ BINARY (00 B0) and UPDATE BINARY (00 D6), short and extended Lc/Le.
+ * Not modelled: NAD and CIDs other than 0.
+ */
+#ifndef VIRTUAL_ISO_DEP_CARD_H
+#define VIRTUAL_ISO_DEP_CARD_H
+
+#include "VirtualPicc.h"
+
+class VirtualIsoDepCard : public Iso14443aPicc {
+public:
+	static constexpr uint16_t FILE_SIZE = 4096;
+	static constexpr uint16_t MAX_APDU = 2048 + 9;			// Extended header, 2048 data bytes, Le
+	static constexpr uint32_t UPDATE_NANOS_PER_BYTE = 20000;	// EEPROM programming of UPDATE BINARY, estimate
+
+	struct Stats {
+		uint32_t iBlocksIn;			// I-blocks received, chained ones included
+		uint32_t iBlocksOut;
+		uint32_t acksIn;			// R(ACK) received
+		uint32_t naksIn;			// R(NAK) received
+		uint32_t retransmissions;	// Blocks sent again on R(ACK)/R(NAK)
+		uint32_t wtxRequests;		// S(WTX) sent
+		uint32_t apdus;
+	};
+
+	/**
+	 * Blank card, the file is zero.
+	 * @param fsci	Frame size the card accepts, 0..8 for 16..256 bytes.
+	 * @param fwi	Frame waiting time integer, FWT = 302μs * 2^fwi.
+	 * @param ta1	TA1 of the ATS: b8 same D both ways, b7..b5 DS 8/4/2 (848/424/212 kBd PICC to PCD),
+	 *				b3..b1 DR 8/4/2 (PCD to PICC). 0x00 for 106 kBd only.
+	 */
+	VirtualIsoDepCard(const uint8_t *uid, uint8_t uidSize, uint8_t fsci = 8, uint8_t fwi = 4, uint8_t ta1 = 0x00);
+
+	uint8_t *file() { return _file; }
+	const Stats &stats() const { return _stats; }
+	void resetStats() { memset(&_stats, 0, sizeof(_stats)); }
+	void dropAnswers(uint8_t count) { _dropAnswers = count; }	// Stay silent on the next count blocks, as if the answers got lost
+
+protected:
+	bool receiveActive(const RfFrame &request, bool crypto, RfFrame &response, uint32_t &processingNanos) override;
+	void onDeselect() override;
+
+private:
+	bool receiveBlock(const RfFrame &frame, RfFrame &response, uint32_t &processingNanos);
+	void execute(uint32_t &busyNanos);				// _command to _response
+	void sendNextI(RfFrame &response);				// Next block of _response
+	void sendR(RfFrame &response, bool ack);
+	void sendS(RfFrame &response, uint8_t pcb, const uint8_t *inf, uint8_t size);
+	void finish(RfFrame &response);					// Appends CRC_A and keeps the block for retransmission
+	uint32_t fwtNanos() const { return (302064ul << _fwi); }
+
+	uint8_t _fsci;
+	uint8_t _fwi;
+	uint8_t _ta1;
+	uint16_t _fsd;				// From RATS
+	bool _protocolActive;		// RATS answered
+	bool _ppsAllowed;			// Only the first block after the ATS may be a PPS
+	bool _blockNumber;
+	bool _cid;					// The PCD sends CID bytes
+	uint8_t _dropAnswers;
+
+	uint8_t _command[MAX_APDU];
+	uint16_t _commandLength;
+	bool _commandOverflow;
+	uint8_t _response[MAX_APDU];
+	uint16_t _responseLength;
+	uint16_t _responseSent;		// Bytes of _response sent in acknowledged or pending I-blocks
+	uint32_t _pendingNanos;		// Processing left after S(WTX), 0 if none is pending
+	RfFrame _lastBlock;
+
+	uint8_t _file[FILE_SIZE];
+	Stats _stats;
+};
+
+#endif // VIRTUAL_ISO_DEP_CARD_H
@@ -0,0 +1,367 @@
+/**
+ * MIFARE Classic Mini/1K/4K PICC for the MFRC522 emulator.
+ */
+#include "VirtualMifareClassic.h"
+#include <stdio.h>
+
+namespace {
+	// MIFARE Classic commands, see MF1S50 chapter 10.
+	enum : uint8_t {
+		MF_AUTH_KEY_A	= 0x60,
+		MF_AUTH_KEY_B	= 0x61,
+		MF_READ			= 0x30,
+		MF_WRITE		= 0xA0,
+		MF_DECREMENT	= 0xC0,
+		MF_INCREMENT	= 0xC1,
+		MF_RESTORE		= 0xC2,
+		MF_TRANSFER		= 0xB0
+	};
+
+	// 4 bit ACK/NAK codes
+	enum : uint8_t {
+		MF_ACK				= 0xA,
+		MF_NAK_INVALID		= 0x0,
+		MF_NAK_CRC			= 0x1
+	};
+
+	// Data blocks, indexed by C1 C2 C3 (MF1S50 table 8). Bit 0 = Key A, bit 1 = Key B.
+	const uint8_t dataRead[8]		= { 3, 3, 3, 2, 3, 2, 3, 0 };
+	const uint8_t dataWrite[8]		= { 3, 0, 0, 2, 2, 0, 2, 0 };
+	const uint8_t dataIncrement[8]	= { 3, 0, 0, 0, 0, 0, 2, 0 };
+	const uint8_t dataDecrement[8]	= { 3, 3, 0, 0, 0, 0, 3, 0 };	// Also transfer and restore
+
+	// Sector trailer, indexed by C1 C2 C3 (MF1S50 table 7).
+	const uint8_t trailerKeyAWrite[8]		= { 1, 1, 0, 2, 2, 0, 0, 0 };
+	const uint8_t trailerAccessRead[8]		= { 1, 1, 1, 3, 3, 3, 3, 3 };
+	const uint8_t trailerAccessWrite[8]		= { 0, 1, 0, 2, 0, 2, 0, 0 };
+	const uint8_t trailerKeyBRead[8]		= { 1, 1, 1, 0, 0, 0, 0, 0 };
+	const uint8_t trailerKeyBWrite[8]		= { 1, 1, 0, 2, 2, 0, 0, 0 };
+
+	uint16_t atqaFor(VirtualMifareClassic::Size size, uint8_t uidSize) {
+		const uint16_t atqa = (size == VirtualMifareClassic::CLASSIC_4K) ? 0x0002 : 0x0004;
+		return (uidSize == 7) ? (atqa | 0x0040) : atqa;
+	}
+
+	uint8_t sakFor(VirtualMifareClassic::Size size) {
+		switch (size) {
+			case VirtualMifareClassic::MINI:		return 0x09;
+			case VirtualMifareClassic::CLASSIC_4K:	return 0x18;
+			default:								return 0x08;
+		}
+	}
+}
+
+VirtualMifareClassic::VirtualMifareClassic(Size size, const uint8_t *uid, uint8_t uidSize)
+	: Iso14443aPicc(uid, uidSize, atqaFor(size, uidSize), sakFor(size)) {
+	_size = size;
+	_blockWrites = 0;
+	_authenticated = false;
+	_authSector = 0;
+	_authKeyB = false;
+	_pendingCommand = 0;
+	_pendingBlock = 0;
+	_transferBuffer = 0;
+	_transferValid = false;
+	_dropAnswers = 0;
+	_dropAfter = 0;
+
+	memset(_memory, 0, sizeof(_memory));
+	if (_uidSize == 4) {
+		memcpy(_memory, _uid, 4);
+		_memory[4] = _uid[0] ^ _uid[1] ^ _uid[2] ^ _uid[3];
+	} else {
+		memcpy(_memory, _uid, 7);
+	}
+	_memory[5] = _sak;
+	_memory[6] = _atqa & 0xFF;
+	_memory[7] = _atqa >> 8;
+
+	const uint8_t sectors = sectorOf(blockCount() - 1) + 1;
+	for (uint8_t sector = 0; sector < sectors; sector++) {
+		uint8_t *trailer = &_memory[(firstBlockOf(sector) + blocksIn(sector) - 1) * 16];
+		memset(trailer, 0xFF, 16);
+		trailer[6] = 0xFF;
+		trailer[7] = 0x07;
+		trailer[8] = 0x80;
+		trailer[9] = 0x69;
+	}
+}
+
+VirtualMifareClassic *VirtualMifareClassic::fromImage(const uint8_t *image, size_t length) {
+	if (length != MINI && length != CLASSIC_1K && length != CLASSIC_4K) {
+		return nullptr;
+	}
+	VirtualMifareClassic *card = new VirtualMifareClassic((Size)length, image, 4);
+	memcpy(card->_memory, image, length);
+	return card;
+}
+
+VirtualMifareClassic *VirtualMifareClassic::fromFile(const char *path) {
+	FILE *file = fopen(path, "rb");
+	if (file == nullptr) {
+		return nullptr;
+	}
+	uint8_t image[CLASSIC_4K + 1];
+	const size_t length = fread(image, 1, sizeof(image), file);
+	fclose(file);
+	return fromImage(image, length);
+}
+
+bool VirtualMifareClassic::saveToFile(const char *path) const {
+	FILE *file = fopen(path, "wb");
+	if (file == nullptr) {
+		return false;
+	}
+	const bool ok = fwrite(_memory, 1, _size, file) == _size;
+	return (fclose(file) == 0) && ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Access conditions
+/////////////////////////////////////////////////////////////////////////////////////
+
+bool VirtualMifareClassic::accessCondition(uint8_t blockAddr, uint8_t *condition) const {
+	const uint8_t sector = sectorOf(blockAddr);
+	const uint8_t trailer = firstBlockOf(sector) + blocksIn(sector) - 1;
+	const uint8_t *bits = &_memory[trailer * 16 + 6];
+
+	// Byte 6..8 hold every bit twice, once inverted.
+	if ((bits[0] & 0x0F) != (~bits[1] >> 4 & 0x0F) || (bits[0] >> 4) != (~bits[2] & 0x0F) || (bits[1] & 0x0F) != (~bits[2] >> 4 & 0x0F)) {
+		return false;
+	}
+
+	// 4K sectors 32..39 have 15 data blocks in groups of 5.
+	uint8_t group = blockAddr - firstBlockOf(sector);
+	if (blocksIn(sector) == 16) {
+		group = (blockAddr == trailer) ? 3 : group / 5;
+	}
+	const uint8_t c1 = (bits[1] >> (4 + group)) & 1;
+	const uint8_t c2 = (bits[2] >> group) & 1;
+	const uint8_t c3 = (bits[2] >> (4 + group)) & 1;
+	*condition = (uint8_t)(c1 << 2 | c2 << 1 | c3);
+	return true;
+}
+
+bool VirtualMifareClassic::isValueBlock(const uint8_t *block, int32_t *value) const {
+	for (uint8_t i = 0; i < 4; i++) {
+		if (block[i] != block[i + 8] || block[i] != (uint8_t)~block[i + 4]) {
+			return false;
+		}
+	}
+	if (block[12] != block[14] || block[13] != block[15] || block[12] != (uint8_t)~block[13]) {
+		return false;
+	}
+	*value = (int32_t)((uint32_t)block[3] << 24 | (uint32_t)block[2] << 16 | (uint32_t)block[1] << 8 | block[0]);
+	return true;
+}
+
+void VirtualMifareClassic::writeBlock(uint8_t blockAddr, const uint8_t *data) {
+	memcpy(&_memory[blockAddr * 16], data, 16);
+	_blockWrites++;
+}
+
+void VirtualMifareClassic::ack(RfFrame &response, uint8_t code) const {
+	response.clear();
+	response.data[0] = code;
+	response.bits = 4;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Commands
+/////////////////////////////////////////////////////////////////////////////////////
+
+void VirtualMifareClassic::onDeselect() {
+	_authenticated = false;
+	_pendingCommand = 0;
+	_transferValid = false;
+}
+
+bool VirtualMifareClassic::mifareAuthenticate(uint8_t command, uint8_t blockAddr, const uint8_t *key, const uint8_t *uid4) {
+	if (state() != ACTIVE) {
+		return false;
+	}
+	// Nested authentication starts from a fresh state.
+	_authenticated = false;
+	_pendingCommand = 0;
+
+	uint8_t condition;
+	const bool keyB = (command == MF_AUTH_KEY_B);
+	if ((command != MF_AUTH_KEY_A && !keyB) || blockAddr >= blockCount() || memcmp(uid4, &_uid[_uidSize - 4], 4) != 0
+			|| !accessCondition(trailerOf(blockAddr), &condition)) {
+		dropToIdle();
+		return false;
+	}
+	const uint8_t *trailer = &_memory[trailerOf(blockAddr) * 16];
+	const uint8_t *expected = keyB ? &trailer[10] : &trailer[0];
+	// A readable Key B is plain data and cannot be used to authenticate.
+	if (memcmp(key, expected, 6) != 0 || (keyB && keyBReadable(condition))) {
+		dropToIdle();
+		return false;
+	}
+	_authenticated = true;
+	_authSector = sectorOf(blockAddr);
+	_authKeyB = keyB;
+	return true;
+}
+
+bool VirtualMifareClassic::receiveActive(const RfFrame &request, bool crypto, RfFrame &response, uint32_t &processingNanos) {
+	if (!receiveCommand(request, crypto, response, processingNanos)) {
+		return false;
+	}
+	if (_dropAfter > 0) {
+		_dropAfter--;
+	} else if (_dropAnswers > 0) {
+		// The command took effect, only the answer is lost.
+		_dropAnswers--;
+		processingNanos = 0;
+		return false;
+	}
+	return true;
+}
+
+bool VirtualMifareClassic::receiveCommand(const RfFrame &request, bool crypto, RfFrame &response, uint32_t &processingNanos) {
+	(void)crypto;
+	RfFrame frame = request;
+	if (!frame.checkAndStripCrc()) {
+		_pendingCommand = 0;
+		ack(response, MF_NAK_CRC);
+		return true;
+	}
+
+	// Second part of WRITE or a value operation
+	if (_pendingCommand != 0) {
+		const uint8_t command = _pendingCommand;
+		_pendingCommand = 0;
+		if (command == MF_WRITE) {
+			if (frame.bits != 16 * 8) {
+				ack(response, MF_NAK_INVALID);
+				return true;
+			}
+			if (_pendingBlock == trailerOf(_pendingBlock)) {
+				// Only the parts the current key may write are changed.
+				uint8_t condition = 7;
+				accessCondition(_pendingBlock, &condition);
+				uint8_t trailer[16];
+				memcpy(trailer, &_memory[_pendingBlock * 16], 16);
+				if (allowed(trailerKeyAWrite[condition])) {
+					memcpy(&trailer[0], &frame.data[0], 6);
+				}
+				if (allowed(trailerAccessWrite[condition])) {
+					memcpy(&trailer[6], &frame.data[6], 4);
+				}
+				if (allowed(trailerKeyBWrite[condition])) {
+					memcpy(&trailer[10], &frame.data[10], 6);
+				}
+				writeBlock(_pendingBlock, trailer);
+			} else {
+				writeBlock(_pendingBlock, frame.data);
+			}
+			processingNanos = WRITE_NANOS;
+			ack(response, MF_ACK);
+			return true;
+		}
+		// INCREMENT, DECREMENT, RESTORE: no answer to part 2.
+		int32_t value;
+		if (frame.bits != 4 * 8 || !isValueBlock(&_memory[_pendingBlock * 16], &value)) {
+			ack(response, MF_NAK_INVALID);
+			return true;
+		}
+		const int32_t operand = (int32_t)((uint32_t)frame.data[3] << 24 | (uint32_t)frame.data[2] << 16 | (uint32_t)frame.data[1] << 8 | frame.data[0]);
+		if (command == MF_INCREMENT) {
+			_transferBuffer = value + operand;
+		} else if (command == MF_DECREMENT) {
+			_transferBuffer = value - operand;
+		} else {
+			_transferBuffer = value;
+		}
+		_transferValid = true;
+		return false;
+	}
+
+	if (frame.bits != 2 * 8) {
+		dropToIdle();
+		return false;
+	}
+	const uint8_t command = frame.data[0];
+	const uint8_t blockAddr = frame.data[1];
+	uint8_t condition;
+	if (blockAddr >= blockCount() || sectorOf(blockAddr) != _authSector || !accessCondition(blockAddr, &condition)) {
+		ack(response, MF_NAK_INVALID);
+		return true;
+	}
+	const bool isTrailer = (blockAddr == trailerOf(blockAddr));
+
+	switch (command) {
+		case MF_READ: {
+			if (isTrailer) {
+				uint8_t *block = response.data;
+				memcpy(block, &_memory[blockAddr * 16], 16);
+				memset(block, 0, 6);				// Key A never reads back
+				if (!allowed(trailerAccessRead[condition])) {
+					memset(&block[6], 0, 4);
+				}
+				if (!allowed(trailerKeyBRead[condition])) {
+					memset(&block[10], 0, 6);
+				}
+			} else {
+				if (!allowed(dataRead[condition])) {
+					ack(response, MF_NAK_INVALID);
+					return true;
+				}
+				memcpy(response.data, &_memory[blockAddr * 16], 16);
+			}
+			response.bits = 16 * 8;
+			response.appendCrc();
+			return true;
+		}
+		case MF_WRITE: {
+			const bool permitted = isTrailer
+				? allowed(trailerKeyAWrite[condition] | trailerAccessWrite[condition] | trailerKeyBWrite[condition])
+				: allowed(dataWrite[condition]);
+			if (blockAddr == 0 || !permitted) {
+				ack(response, MF_NAK_INVALID);
+				return true;
+			}
+			_pendingCommand = MF_WRITE;
+			_pendingBlock = blockAddr;
+			ack(response, MF_ACK);
+			return true;
+		}
+		case MF_INCREMENT:
+		case MF_DECREMENT:
+		case MF_RESTORE: {
+			const uint8_t permission = (command == MF_INCREMENT) ? dataIncrement[condition] : dataDecrement[condition];
+			int32_t value;
+			if (isTrailer || !allowed(permission) || !isValueBlock(&_memory[blockAddr * 16], &value)) {
+				ack(response, MF_NAK_INVALID);
+				return true;
+			}
+			_pendingCommand = command;
+			_pendingBlock = blockAddr;
+			ack(response, MF_ACK);
+			return true;
+		}
+		case MF_TRANSFER: {
+			if (isTrailer || blockAddr == 0 || !_transferValid || !allowed(dataDecrement[condition])) {
+				ack(response, MF_NAK_INVALID);
+				return true;
+			}
+			uint8_t block[16];
+			memcpy(block, &_memory[blockAddr * 16], 16);
+			for (uint8_t i = 0; i < 4; i++) {
+				const uint8_t b = (uint8_t)((uint32_t)_transferBuffer >> (8 * i));
+				block[i] = b;
+				block[i + 4] = (uint8_t)~b;
+				block[i + 8] = b;
+			}
+			writeBlock(blockAddr, block);
+			_transferValid = false;
+			processingNanos = WRITE_NANOS;
+			ack(response, MF_ACK);
+			return true;
+		}
+		default:
+			dropToIdle();
+			return false;
+	}
+}
@@ -0,0 +1,86 @@
+/**
+ * MIFARE Classic Mini/1K/4K PICC for the MFRC522 emulator.
+ *
+ * Memory, sector trailers, access conditions and the value block operations follow
+ * the NXP MF1S50/MF1S70 datasheets. Authentication is modelled logically: MFAuthent
+ * checks key, access bits and UID and then both sides are "in crypto", but the
+ * Crypto1 keystream itself is not generated, so frames on the emulated air are plain.
+ */
+#ifndef VIRTUAL_MIFARE_CLASSIC_H
+#define VIRTUAL_MIFARE_CLASSIC_H
+
+#include "VirtualPicc.h"
+
+class VirtualMifareClassic : public Iso14443aPicc {
+public:
+	enum Size : uint16_t {
+		MINI		= 320,
+		CLASSIC_1K	= 1024,
+		CLASSIC_4K	= 4096
+	};
+
+	static constexpr uint32_t WRITE_NANOS = 2500000;	// EEPROM programming before the ACK of WRITE/TRANSFER, estimate
+
+	/**
+	 * Blank card in transport configuration: Key A = Key B = FF FF FF FF FF FF, access bits FF 07 80 69.
+	 * Block 0 is filled with the UID (4 byte UIDs only), BCC, SAK and ATQA.
+	 */
+	VirtualMifareClassic(Size size, const uint8_t *uid, uint8_t uidSize = 4);
+
+	/**
+	 * Card from a raw memory dump of 320, 1024 or 4096 bytes. The 4 byte UID is taken from block 0.
+	 * @return nullptr if the size does not match a MIFARE Classic card.
+	 */
+	static VirtualMifareClassic *fromImage(const uint8_t *image, size_t length);
+	static VirtualMifareClassic *fromFile(const char *path);
+	bool saveToFile(const char *path) const;
+
+	uint8_t *memory() { return _memory; }
+	const uint8_t *memory() const { return _memory; }
+	Size size() const { return _size; }
+	uint16_t blockCount() const { return _size / 16; }
+	uint32_t blockWrites() const { return _blockWrites; }	// EEPROM programming cycles, WRITE and TRANSFER
+	void resetBlockWrites() { _blockWrites = 0; }
+	// Stay silent on count commands in ACTIVE state, after answering the next after ones, as if the answers got lost.
+	void dropAnswers(uint8_t count, uint16_t after = 0) { _dropAnswers = count; _dropAfter = after; }
+
+	static uint8_t sectorOf(uint8_t blockAddr) { return (blockAddr < 128) ? blockAddr / 4 : 32 + (blockAddr - 128) / 16; }
+	static uint8_t firstBlockOf(uint8_t sector) { return (sector < 32) ? sector * 4 : 128 + (sector - 32) * 16; }
+	static uint8_t blocksIn(uint8_t sector) { return (sector < 32) ? 4 : 16; }
+
+	bool mifareAuthenticate(uint8_t command, uint8_t blockAddr, const uint8_t *key, const uint8_t *uid4) override;
+
+protected:
+	bool receiveActive(const RfFrame &request, bool crypto, RfFrame &response, uint32_t &processingNanos) override;
+	void onDeselect() override;
+	bool cryptoActive() const override { return _authenticated; }
+
+private:
+	enum Permission : uint8_t { NEVER = 0, KEY_A = 1, KEY_B = 2, KEY_AB = 3 };
+
+	uint8_t trailerOf(uint8_t blockAddr) const { return firstBlockOf(sectorOf(blockAddr)) + blocksIn(sectorOf(blockAddr)) - 1; }
+	bool accessCondition(uint8_t blockAddr, uint8_t *condition) const;		// C1 C2 C3 of the block, false if the access bits are inconsistent
+	bool allowed(uint8_t permission) const { return permission & (_authKeyB ? KEY_B : KEY_A); }
+	bool keyBReadable(uint8_t trailerCondition) const { return trailerCondition <= 2; }
+	bool isValueBlock(const uint8_t *block, int32_t *value) const;
+	void writeBlock(uint8_t blockAddr, const uint8_t *data);
+	void ack(RfFrame &response, uint8_t code) const;
+	bool receiveCommand(const RfFrame &request, bool crypto, RfFrame &response, uint32_t &processingNanos);
+
+	Size _size;
+	uint8_t _memory[CLASSIC_4K];
+	uint32_t _blockWrites;
+	uint8_t _dropAnswers;
+	uint16_t _dropAfter;
+
+	bool _authenticated;
+	uint8_t _authSector;
+	bool _authKeyB;
+
+	uint8_t _pendingCommand;	// WRITE, INCREMENT, DECREMENT or RESTORE waiting for part 2, or 0
+	uint8_t _pendingBlock;
+	int32_t _transferBuffer;
+	bool _transferValid;
+};
+
+#endif // VIRTUAL_MIFARE_CLASSIC_H
@@ -0,0 +1,172 @@
+/**
+ * NTAG213/215/216 PICC for the MFRC522 emulator.
+ */
+#include "VirtualNtag21x.h"
+
+namespace {
+	// NTAG21x commands, see NTAG213_215_216 chapter 10.
+	enum : uint8_t {
+		NTAG_GET_VERSION	= 0x60,
+		NTAG_READ			= 0x30,
+		NTAG_FAST_READ		= 0x3A,
+		NTAG_WRITE			= 0xA2,
+		NTAG_PWD_AUTH		= 0x1B
+	};
+
+	// 4 bit ACK/NAK codes
+	enum : uint8_t {
+		NTAG_ACK			= 0xA,
+		NTAG_NAK_INVALID	= 0x0,
+		NTAG_NAK_CRC		= 0x1
+	};
+
+	uint8_t pagesFor(VirtualNtag21x::Type type) {
+		switch (type) {
+			case VirtualNtag21x::NTAG213:	return 45;
+			case VirtualNtag21x::NTAG215:	return 135;
+			default:						return 231;
+		}
+	}
+}
+
+VirtualNtag21x::VirtualNtag21x(Type type, const uint8_t *uid7)
+	: Iso14443aPicc(uid7, 7, 0x0044, 0x00) {
+	_type = type;
+	_pages = pagesFor(type);
+	_pageWrites = 0;
+	_authenticated = false;
+
+	memset(_memory, 0, sizeof(_memory));
+	// UID with BCC0 (cascade tag included) and BCC1
+	memcpy(&_memory[0], _uid, 3);
+	_memory[3] = 0x88 ^ _uid[0] ^ _uid[1] ^ _uid[2];
+	memcpy(&_memory[4], &_uid[3], 4);
+	_memory[8] = _uid[3] ^ _uid[4] ^ _uid[5] ^ _uid[6];
+	_memory[9] = 0x48;		// Internal
+	// Capability container: NDEF 1.0, data area size / 8, read/write access
+	_memory[12] = 0xE1;
+	_memory[13] = 0x10;
+	_memory[14] = (uint8_t)(userPages() * 4 / 8);
+	_memory[15] = 0x00;
+	_memory[cfg0Page() * 4 + 0] = 0x04;		// MIRROR
+	_memory[cfg0Page() * 4 + 3] = 0xFF;		// AUTH0: no page protected
+	_memory[cfg1Page() * 4 + 1] = 0x05;
+	memset(&_memory[pwdPage() * 4], 0xFF, 4);
+}
+
+void VirtualNtag21x::setPassword(const uint8_t *password, const uint8_t *pack, uint8_t auth0, bool protectReads) {
+	memcpy(&_memory[pwdPage() * 4], password, 4);
+	memcpy(&_memory[packPage() * 4], pack, 2);
+	_memory[cfg0Page() * 4 + 3] = auth0;
+	_memory[cfg1Page() * 4] = protectReads ? (_memory[cfg1Page() * 4] | 0x80) : (_memory[cfg1Page() * 4] & 0x7F);
+}
+
+bool VirtualNtag21x::accessible(uint8_t page, bool write) const {
+	const uint8_t auth0 = _memory[cfg0Page() * 4 + 3];
+	const bool protectReads = _memory[cfg1Page() * 4] & 0x80;
+	return _authenticated || page < auth0 || (!write && !protectReads);
+}
+
+void VirtualNtag21x::readPages(uint8_t first, uint8_t count, uint8_t *out) const {
+	for (uint8_t i = 0; i < count; i++) {
+		const uint8_t page = (uint8_t)((first + i) % _pages);
+		if (page == pwdPage() || page == packPage()) {
+			memset(&out[i * 4], 0, 4);
+		} else {
+			memcpy(&out[i * 4], &_memory[page * 4], 4);
+		}
+	}
+}
+
+// A NAK sends the tag back to IDLE (or HALT), so a new selection is needed.
+bool VirtualNtag21x::nak(RfFrame &response, uint8_t code) {
+	dropToIdle();
+	response.clear();
+	response.data[0] = code;
+	response.bits = 4;
+	return true;
+}
+
+bool VirtualNtag21x::receiveActive(const RfFrame &request, bool crypto, RfFrame &response, uint32_t &processingNanos) {
+	(void)crypto;
+	RfFrame frame = request;
+	if (!frame.checkAndStripCrc()) {
+		return nak(response, NTAG_NAK_CRC);
+	}
+	const uint8_t command = frame.data[0];
+	const uint8_t length = frame.bytes();
+
+	switch (command) {
+		case NTAG_GET_VERSION: {
+			if (length != 1) {
+				return nak(response, NTAG_NAK_INVALID);
+			}
+			const uint8_t version[8] = { 0x00, 0x04, 0x04, 0x02, 0x01, 0x00, (uint8_t)_type, 0x03 };
+			response.assign(version, sizeof(version));
+			response.appendCrc();
+			return true;
+		}
+		case NTAG_READ: {
+			const uint8_t page = frame.data[1];
+			if (length != 2 || page >= _pages || !accessible(page, false)) {
+				return nak(response, NTAG_NAK_INVALID);
+			}
+			uint8_t data[16];
+			readPages(page, 4, data);
+			response.assign(data, sizeof(data));
+			response.appendCrc();
+			return true;
+		}
+		case NTAG_FAST_READ: {
+			const uint8_t start = frame.data[1];
+			const uint8_t end = frame.data[2];
+			if (length != 3 || start > end || end >= _pages || !accessible(end, false) || !accessible(start, false)) {
+				return nak(response, NTAG_NAK_INVALID);
+			}
+			const uint8_t count = end - start + 1;
+			if (count * 4u + 2 > RfFrame::MAX_BYTES) {
+				return nak(response, NTAG_NAK_INVALID);	// Longer than the emulated air frame; the MFRC522 FIFO would overflow anyway
+			}
+			response.clear();
+			readPages(start, count, response.data);
+			response.bits = count * 32u;
+			response.appendCrc();
+			return true;
+		}
+		case NTAG_WRITE: {
+			const uint8_t page = frame.data[1];
+			if (length != 6 || page < 2 || page >= _pages || !accessible(page, true)) {
+				return nak(response, NTAG_NAK_INVALID);
+			}
+			uint8_t *target = &_memory[page * 4];
+			if (page == 2) {
+				target[2] |= frame.data[4];		// Static lock bytes are one-time programmable
+				target[3] |= frame.data[5];
+			} else if (page == 3) {
+				for (uint8_t i = 0; i < 4; i++) {
+					target[i] |= frame.data[2 + i];	// Capability container, OTP
+				}
+			} else {
+				memcpy(target, &frame.data[2], 4);
+			}
+			_pageWrites++;
+			processingNanos = WRITE_NANOS;
+			response.clear();
+			response.data[0] = NTAG_ACK;
+			response.bits = 4;
+			return true;
+		}
+		case NTAG_PWD_AUTH: {
+			if (length != 5 || memcmp(&frame.data[1], &_memory[pwdPage() * 4], 4) != 0) {
+				_authenticated = false;
+				return nak(response, NTAG_NAK_INVALID);
+			}
+			_authenticated = true;
+			response.assign(&_memory[packPage() * 4], 2);
+			response.appendCrc();
+			return true;
+		}
+		default:
+			return nak(response, NTAG_NAK_INVALID);
+	}
+}
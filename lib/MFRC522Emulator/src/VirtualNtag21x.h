@@ -0,0 +1,64 @@
+/**
+ * NTAG213/215/216 PICC for the MFRC522 emulator.
+ *
+ * Memory layout, GET_VERSION, READ, FAST_READ, WRITE and PWD_AUTH follow the NXP
+ * NTAG213/215/216 datasheet. Password protection uses AUTH0 and the PROT bit of the
+ * configuration pages. Not modelled: the originality signature, the NFC counter,
+ * AUTHLIM, the UID mirror and the static/dynamic lock bits beyond storing them.
+ */
+#ifndef VIRTUAL_NTAG21X_H
+#define VIRTUAL_NTAG21X_H
+
+#include "VirtualPicc.h"
+
+class VirtualNtag21x : public Iso14443aPicc {
+public:
+	enum Type : uint8_t {
+		NTAG213		= 0x0F,		// Storage size byte of GET_VERSION
+		NTAG215		= 0x11,
+		NTAG216		= 0x13
+	};
+
+	static constexpr uint32_t WRITE_NANOS = 4100000;	// EEPROM programming before the ACK of WRITE, datasheet typical
+
+	/**
+	 * Blank tag as delivered: user memory zero, capability container for NDEF, password protection off
+	 * (AUTH0 = FFh), password FF FF FF FF.
+	 */
+	VirtualNtag21x(Type type, const uint8_t *uid7);
+
+	uint8_t *memory() { return _memory; }
+	const uint8_t *memory() const { return _memory; }
+	Type type() const { return _type; }
+	uint8_t pageCount() const { return _pages; }
+	uint8_t userPages() const { return _pages - 9; }			// Pages 4 .. 4 + userPages() - 1
+	uint32_t pageWrites() const { return _pageWrites; }
+	void resetPageWrites() { _pageWrites = 0; }
+
+	/**
+	 * Sets PWD and PACK and protects the pages from auth0 on. With protectReads, READ and FAST_READ
+	 * of these pages need PWD_AUTH as well, otherwise only WRITE does.
+	 */
+	void setPassword(const uint8_t *password, const uint8_t *pack, uint8_t auth0, bool protectReads);
+
+protected:
+	bool receiveActive(const RfFrame &request, bool crypto, RfFrame &response, uint32_t &processingNanos) override;
+	void onDeselect() override { _authenticated = false; }
+
+private:
+	uint8_t cfg0Page() const { return _pages - 4; }
+	uint8_t cfg1Page() const { return _pages - 3; }
+	uint8_t pwdPage() const { return _pages - 2; }
+	uint8_t packPage() const { return _pages - 1; }
+	bool accessible(uint8_t page, bool write) const;	// Password protection of a page
+	void readPages(uint8_t first, uint8_t count, uint8_t *out) const;	// PWD and PACK read as zero
+	bool nak(RfFrame &response, uint8_t code);
+
+	Type _type;
+	uint8_t _pages;
+	uint8_t _memory[231 * 4];
+	uint32_t _pageWrites;
+	bool _authenticated;
+};
+
+#endif // VIRTUAL_NTAG21X_H
@@ -0,0 +1,217 @@
+/**
+ * ISO/IEC 14443A PICC models for the MFRC522 emulator.
+ */
+#include "VirtualPicc.h"
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Frames
+/////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * CRC_A as defined in ISO/IEC 14443-3 Annex B. The MFRC522 coprocessor computes the same with CRCPreset = 01.
+ */
+uint16_t iso14443aCrc(const uint8_t *data, size_t length, uint16_t preset) {
+	uint16_t crc = preset;
+	for (size_t i = 0; i < length; i++) {
+		uint8_t ch = data[i] ^ (uint8_t)(crc & 0xFF);
+		ch ^= (uint8_t)(ch << 4);
+		crc = (crc >> 8) ^ ((uint16_t)ch << 8) ^ ((uint16_t)ch << 3) ^ ((uint16_t)ch >> 4);
+	}
+	return crc;
+}
+
+void RfFrame::setBit(uint16_t index, bool value) {
+	if (value) {
+		data[index / 8] |= (uint8_t)(1 << (index % 8));
+	} else {
+		data[index / 8] &= (uint8_t)~(1 << (index % 8));
+	}
+}
+
+void RfFrame::appendCrc() {
+	const uint16_t n = bytes();
+	const uint16_t crc = iso14443aCrc(data, n);
+	data[n] = crc & 0xFF;
+	data[n + 1] = crc >> 8;
+	bits = (n + 2) * 8u;
+}
+
+bool RfFrame::checkAndStripCrc() {
+	if (bits % 8 != 0 || bytes() < 3) {
+		return false;
+	}
+	const uint16_t n = bytes() - 2;
+	const uint16_t crc = iso14443aCrc(data, n);
+	if (data[n] != (crc & 0xFF) || data[n + 1] != (crc >> 8)) {
+		return false;
+	}
+	bits -= 16;
+	return true;
+}
+
+uint32_t RfFrame::airNanos() const {
+	// Every complete byte is followed by a parity bit. Start of frame and end of frame take one etu each.
+	const uint32_t etus = 2 + (bits / 8) * 9u + (bits % 8);
+	return etus * etuNanos();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// ISO/IEC 14443-3 state machine
+/////////////////////////////////////////////////////////////////////////////////////
+
+Iso14443aPicc::Iso14443aPicc(const uint8_t *uid, uint8_t uidSize, uint16_t atqa, uint8_t sak) {
+	_uidSize = (uidSize == 7 || uidSize == 10) ? uidSize : 4;
+	memset(_uid, 0, sizeof(_uid));
+	memcpy(_uid, uid, _uidSize);
+	_atqa = atqa;
+	_sak = sak;
+	_state = POWER_OFF;
+	_wokenFromHalt = false;
+	_cascadeLevel = 0;
+	_sendSpeed = 0;
+	_receiveSpeed = 0;
+}
+
+void Iso14443aPicc::powerOn() {
+	if (_state == POWER_OFF) {
+		_state = IDLE;
+		_wokenFromHalt = false;
+	}
+}
+
+void Iso14443aPicc::powerOff() {
+	if (_state == ACTIVE) {
+		deselect();
+	}
+	_state = POWER_OFF;
+}
+
+void Iso14443aPicc::dropToIdle() {
+	if (_state == ACTIVE) {
+		deselect();
+	}
+	_state = _wokenFromHalt ? HALT : IDLE;
+}
+
+void Iso14443aPicc::halt() {
+	deselect();
+	_state = HALT;
+}
+
+void Iso14443aPicc::deselect() {
+	_sendSpeed = 0;
+	_receiveSpeed = 0;
+	onDeselect();
+}
+
+void Iso14443aPicc::setBitRates(uint8_t sendSpeed, uint8_t receiveSpeed) {
+	_sendSpeed = sendSpeed & 0x03;
+	_receiveSpeed = receiveSpeed & 0x03;
+}
+
+void Iso14443aPicc::cascadeLevelBits(uint8_t *uidCl) const {
+	const bool lastLevel = (_uidSize == 4) || (_uidSize == 7 && _cascadeLevel == 1) || (_uidSize == 10 && _cascadeLevel == 2);
+	const uint8_t offset = _cascadeLevel * 3;
+	if (lastLevel) {
+		memcpy(uidCl, &_uid[offset], 4);
+	} else {
+		uidCl[0] = 0x88;	// Cascade tag
+		memcpy(&uidCl[1], &_uid[offset], 3);
+	}
+	uidCl[4] = uidCl[0] ^ uidCl[1] ^ uidCl[2] ^ uidCl[3];
+}
+
+bool Iso14443aPicc::receive(const RfFrame &request, bool crypto, RfFrame &response, uint32_t &processingNanos) {
+	processingNanos = 0;
+	response.clear();
+	if (_state == POWER_OFF || request.speed != _receiveSpeed) {
+		return false;
+	}
+
+	// REQA and WUPA are short frames and never enciphered.
+	if (request.isShortFrame()) {
+		const uint8_t command = request.data[0] & 0x7F;
+		if ((command == 0x26 && _state == IDLE) || (command == 0x52 && (_state == IDLE || _state == HALT))) {
+			_wokenFromHalt = (_state == HALT);
+			_state = READY;
+			_cascadeLevel = 0;
+			response.data[0] = _atqa & 0xFF;
+			response.data[1] = _atqa >> 8;
+			response.bits = 16;
+			return true;
+		}
+		if (_state == READY || _state == ACTIVE) {
+			dropToIdle();
+		}
+		return false;
+	}
+
+	if (_state == READY) {
+		uint8_t uidCl[5];
+		cascadeLevelBits(uidCl);
+		if (request.bits < 16 || request.data[0] != 0x93 + 2 * _cascadeLevel) {
+			dropToIdle();
+			return false;
+		}
+		const uint8_t nvb = request.data[1];
+
+		if (nvb == 0x70) {
+			// SELECT
+			RfFrame select = request;
+			if (select.bits != 9 * 8 || !select.checkAndStripCrc() || memcmp(&select.data[2], uidCl, 5) != 0) {
+				dropToIdle();
+				return false;
+			}
+			const bool cascade = (uidCl[0] == 0x88);
+			response.data[0] = cascade ? 0x04 : _sak;
+			response.bits = 8;
+			response.appendCrc();
+			if (cascade) {
+				_cascadeLevel++;
+			} else {
+				_state = ACTIVE;
+			}
+			return true;
+		}
+
+		// ANTICOLLISION: answer with the rest of UID CLn and BCC if the known bits match.
+		const uint16_t knownBits = (uint16_t)(((nvb >> 4) - 2) * 8 + (nvb & 0x07));
+		if ((nvb >> 4) < 2 || knownBits >= 40 || request.bits != 16 + knownBits) {
+			dropToIdle();
+			return false;
+		}
+		RfFrame cl;
+		cl.assign(uidCl, 5);
+		for (uint16_t i = 0; i < knownBits; i++) {
+			if (request.bit(16 + i) != cl.bit(i)) {
+				return false;
+			}
+		}
+		for (uint16_t i = knownBits; i < 40; i++) {
+			response.setBit(i - knownBits, cl.bit(i));
+		}
+		response.bits = 40 - knownBits;
+		return true;
+	}
+
+	if (_state == ACTIVE) {
+		if (crypto != cryptoActive()) {
+			// Plain frame while the PICC expects ciphertext or the other way round.
+			dropToIdle();
+			return false;
+		}
+		RfFrame hlta = request;
+		if (hlta.bits == 4 * 8 && hlta.checkAndStripCrc() && hlta.data[0] == 0x50 && hlta.data[1] == 0x00) {
+			halt();
+			return false;
+		}
+		const uint8_t sendSpeed = _sendSpeed;	// A PPS is answered at the old bit rate
+		if (!receiveActive(request, crypto, response, processingNanos)) {
+			return false;
+		}
+		response.speed = sendSpeed;
+		return true;
+	}
+
+	return false;	// IDLE and HALT only listen to REQA/WUPA.
+}
@@ -0,0 +1,109 @@
+/**
+ * ISO/IEC 14443A PICC models for the MFRC522 emulator.
+ *
+ * VirtualPicc is what the emulated PCD talks to. Iso14443aPicc implements the
+ * ISO/IEC 14443-3 part (REQA/WUPA, anticollision, SELECT, HLTA) for 4, 7 and 10 byte UIDs,
+ * card types only implement what happens in the ACTIVE state.
+ */
+#ifndef VIRTUAL_PICC_H
+#define VIRTUAL_PICC_H
+
+#include <Arduino.h>
+
+// Air interface timing at 106 kBd. 1 etu = 128/fc, halved with every step up to 848 kBd.
+static constexpr uint32_t ISO14443A_ETU_NANOS = 9440;
+static constexpr uint32_t ISO14443A_FDT_NANOS = 91150;		// 1236/fc, PCD frame end to PICC frame start
+
+// A frame on the air, LSB first. Parity and Miller/Manchester coding are not modelled.
+struct RfFrame {
+	static constexpr uint16_t MAX_BYTES = 258;		// FSD/FSC 256 of ISO/IEC 14443-4 and some slack
+	uint8_t data[MAX_BYTES];
+	uint16_t bits;
+	uint8_t speed;		// Bit rate 106 kBd << speed, coded like TxSpeed/RxSpeed of the MFRC522
+
+	uint16_t bytes() const { return (uint16_t)((bits + 7) / 8); }
+	bool isShortFrame() const { return bits == 7; }
+	bool bit(uint16_t index) const { return (data[index / 8] >> (index % 8)) & 1; }
+	void setBit(uint16_t index, bool value);
+	void clear() { bits = 0; speed = 0; memset(data, 0, sizeof(data)); }
+	void assign(const uint8_t *src, uint16_t count) { clear(); memcpy(data, src, count); bits = count * 8u; }
+	void appendCrc();					// Appends CRC_A. Only valid on byte-aligned frames.
+	bool checkAndStripCrc();			// Verifies and removes a trailing CRC_A.
+	uint32_t airNanos() const;			// Time on air including SOF, parity bits and EOF.
+	uint32_t etuNanos() const { return ISO14443A_ETU_NANOS >> speed; }
+};
+
+uint16_t iso14443aCrc(const uint8_t *data, size_t length, uint16_t preset = 0x6363);
+
+class VirtualPicc {
+public:
+	virtual ~VirtualPicc() {}
+
+	virtual void powerOn() = 0;			// RF field switched on or PICC moved into the field.
+	virtual void powerOff() = 0;		// RF field switched off or PICC removed.
+
+	/**
+	 * Handles one frame from the PCD.
+	 * @param crypto		true if the PCD had MFCrypto1On set while transmitting.
+	 * @param response		Frame to answer with.
+	 * @param processingNanos	Additional delay before the answer, e.g. for EEPROM programming.
+	 * @return true if the PICC answers.
+	 */
+	virtual bool receive(const RfFrame &request, bool crypto, RfFrame &response, uint32_t &processingNanos) = 0;
+
+	/**
+	 * The MFRC522 MFAuthent command. Only MIFARE Classic PICCs implement it.
+	 * @return true if this PICC completed the three pass authentication.
+	 */
+	virtual bool mifareAuthenticate(uint8_t command, uint8_t blockAddr, const uint8_t *key, const uint8_t *uid4) {
+		(void)command; (void)blockAddr; (void)key; (void)uid4;
+		return false;
+	}
+};
+
+class Iso14443aPicc : public VirtualPicc {
+public:
+	enum State : uint8_t { POWER_OFF, IDLE, READY, ACTIVE, HALT };
+
+	/**
+	 * @param uid		4, 7 or 10 bytes.
+	 * @param atqa		Answer to request, LSB first on the air.
+	 * @param sak		SAK of the last cascade level.
+	 */
+	Iso14443aPicc(const uint8_t *uid, uint8_t uidSize, uint16_t atqa, uint8_t sak);
+
+	void powerOn() override;
+	void powerOff() override;
+	bool receive(const RfFrame &request, bool crypto, RfFrame &response, uint32_t &processingNanos) override;
+
+	State state() const { return _state; }
+	const uint8_t *uid() const { return _uid; }
+	uint8_t uidSize() const { return _uidSize; }
+
+protected:
+	// Frame received in ACTIVE state that is not HLTA. Return false to stay silent.
+	virtual bool receiveActive(const RfFrame &request, bool crypto, RfFrame &response, uint32_t &processingNanos) = 0;
+	// Anything that is not understood sends the PICC back to IDLE, or HALT if it was woken from there.
+	void dropToIdle();
+	void halt();					// HLTA or S(DESELECT): ACTIVE to HALT
+	void setBitRates(uint8_t sendSpeed, uint8_t receiveSpeed);	// After an ISO/IEC 14443-4 PPS, back to 106 kBd when leaving ACTIVE
+	virtual void onDeselect() {}	// Left ACTIVE, e.g. to reset an authentication.
+	virtual bool cryptoActive() const { return false; }
+
+	uint8_t _uid[10];
+	uint8_t _uidSize;
+	uint16_t _atqa;
+	uint8_t _sak;
+
+private:
+	void cascadeLevelBits(uint8_t *uidCl) const;	// 4 UID bytes (or CT + 3) and BCC of _cascadeLevel
+	void deselect();
+
+	State _state;
+	bool _wokenFromHalt;
+	uint8_t _cascadeLevel;		// 0..2 while READY
+	uint8_t _sendSpeed;			// RfFrame::speed of answers
+	uint8_t _receiveSpeed;		// Frames at another bit rate are not understood
+};
+
+#endif // VIRTUAL_PICC_H
@@ -0,0 +1,89 @@
+// MIFARE Classic Mini/1K/4K block layout, computed at compile time.
+// Sectors 0-31 have 4 blocks, sectors 32-39 (4K only) have 16. The last block of every sector is its trailer and
+// block 0 holds the manufacturer data; all other blocks are data blocks. Listed in address order, the data blocks of
+// a Mini or 1K are the start of those of a 4K, so one table built for the 4K is the block map of every type.
+// The tables are in flash (PROGMEM), read them with pgm_read_byte() or through blockAt() and isDataBlock().
+#ifndef MIFARE_CLASSIC_LAYOUT_H
+#define MIFARE_CLASSIC_LAYOUT_H
+
+#include <Arduino.h>
+#include <MFRC522.h>
+#include <stdint.h>
+
+namespace MifareClassicLayout {
+
+constexpr byte sectorOf(byte blockAddr) { return (blockAddr < 128) ? blockAddr / 4 : 32 + (blockAddr - 128) / 16; }
+constexpr byte firstBlockOf(byte sector) { return (sector < 32) ? sector * 4 : 128 + (sector - 32) * 16; }
+constexpr byte blocksIn(byte sector) { return (sector < 32) ? 4 : 16; }
+constexpr byte trailerOf(byte sector) { return firstBlockOf(sector) + blocksIn(sector) - 1; }
+constexpr bool isDataBlock(byte blockAddr) { return blockAddr != 0 && blockAddr != trailerOf(sectorOf(blockAddr)); }
+
+// Data blocks in the first sectors sectors: 3 per small sector, 15 per large one, minus block 0.
+constexpr byte dataBlocksIn(byte sectors) { return (sectors <= 32) ? (sectors ? sectors * 3 - 1 : 0) : 95 + (sectors - 32) * 15; }
+
+// Address of data block index, counted from block 1.
+constexpr byte dataBlock(byte index) {
+    return (index < 95) ? (index + 1) / 3 * 4 + (index + 1) % 3 : 128 + (index - 95) / 15 * 16 + (index - 95) % 15;
+}
+
+// Data block flags of blocks 8 * octet .. 8 * octet + 7, bit 0 first.
+constexpr byte dataBlockBits(byte octet) {
+    return (isDataBlock(octet * 8) ? 0x01 : 0) | (isDataBlock(octet * 8 + 1) ? 0x02 : 0) | (isDataBlock(octet * 8 + 2) ? 0x04 : 0)
+         | (isDataBlock(octet * 8 + 3) ? 0x08 : 0) | (isDataBlock(octet * 8 + 4) ? 0x10 : 0) | (isDataBlock(octet * 8 + 5) ? 0x20 : 0)
+         | (isDataBlock(octet * 8 + 6) ? 0x40 : 0) | (isDataBlock(octet * 8 + 7) ? 0x80 : 0);
+}
+
+struct Layout {
+    byte sectors;       // 0 if the card is not a MIFARE Classic
+    uint16_t blocks;    // Block 0 and the trailers included
+    byte dataBlocks;    // Entries of the block map
+};
+
+constexpr Layout MINI = {5, 20, dataBlocksIn(5)};
+constexpr Layout CLASSIC_1K = {16, 64, dataBlocksIn(16)};
+constexpr Layout CLASSIC_4K = {40, 256, dataBlocksIn(40)};
+static_assert(CLASSIC_1K.dataBlocks == 47 && CLASSIC_4K.dataBlocks == 215, "MIFARE Classic layout");
+
+// Tables filled by the compiler and kept in flash: Table<0, 1, ..., Count - 1>::values[i] = Value(i).
+template <byte (*Value)(byte), byte... Index>
+struct Table {
+    static const byte values[sizeof...(Index)];
+};
+template <byte (*Value)(byte), byte... Index>
+const byte Table<Value, Index...>::values[sizeof...(Index)] PROGMEM = {Value(Index)...};
+
+template <byte (*Value)(byte), byte Count, byte... Index>
+struct MakeTable : MakeTable<Value, Count - 1, Count - 1, Index...> {};
+template <byte (*Value)(byte), byte... Index>
+struct MakeTable<Value, 0, Index...> {
+    typedef Table<Value, Index...> type;
+};
+
+// Block map of the 4K: the first dataBlocks entries are the map of any Layout.
+typedef MakeTable<dataBlock, CLASSIC_4K.dataBlocks>::type DataBlocks;
+// One bit per block of the 4K, set for data blocks.
+typedef MakeTable<dataBlockBits, CLASSIC_4K.blocks / 8>::type DataBlockBits;
+
+// The block map itself, a PROGMEM pointer.
+inline const byte *blockMap() { return DataBlocks::values; }
+// Entry index of the block map.
+inline byte blockAt(byte index) { return pgm_read_byte(&DataBlocks::values[index]); }
+
+// Layout of a card type from PICC_GetType(), sectors 0 for anything but MIFARE Classic.
+inline Layout layoutOf(MFRC522::PICC_Type type) {
+    switch (type) {
+        case MFRC522::PICC_TYPE_MIFARE_MINI: return MINI;
+        case MFRC522::PICC_TYPE_MIFARE_1K: return CLASSIC_1K;
+        case MFRC522::PICC_TYPE_MIFARE_4K: return CLASSIC_4K;
+        default: return Layout{0, 0, 0};
+    }
+}
+
+// Data block of layout: a bit lookup, no trailer arithmetic.
+inline bool isDataBlock(const Layout &layout, byte blockAddr) {
+    return blockAddr < layout.blocks && ((pgm_read_byte(&DataBlockBits::values[blockAddr / 8]) >> (blockAddr % 8)) & 1);
+}
+
+} // namespace MifareClassicLayout
+
+#endif // MIFARE_CLASSIC_LAYOUT_H
@@ -0,0 +1,164 @@
+// Key resolution for MIFARE Classic: key dictionary and per-card LRU table of the keys that worked.
+#include "MifareKeyResolver.h"
+#include <EEPROM.h>
+
+static const byte EEPROM_MAGIC = 0x4B;     // 'K', first byte of the table in EEPROM
+
+MifareKeyResolver::MifareKeyResolver(MFRC522 &reader, MFRC522::MIFARE_Key *keys, byte keyCount)
+    : _reader(reader), _keys(keys), _keyCount((keyCount < MAX_KEYS) ? keyCount : (byte)MAX_KEYS), _eepromAddress(-1), _lastKey(NO_KEY) {
+    memset(_cache, 0, sizeof(_cache));
+    resetStats();
+}
+
+/**
+ * @brief Mirrors the table to EEPROM at eepromAddress, EEPROM_SIZE bytes. A table stored there is loaded if it was
+ * written for the same dictionary and table size, otherwise the RAM table is written over it. Only learning a new key writes to
+ * EEPROM, and only the bytes that changed; using a cached key reorders the table in RAM only.
+ * @return true if a stored table was loaded.
+ */
+bool MifareKeyResolver::enablePersistence(int eepromAddress) {
+    _eepromAddress = eepromAddress;
+    if (EEPROM.read(eepromAddress) != EEPROM_MAGIC || EEPROM.read(eepromAddress + 1) != CACHE_CARDS
+        || EEPROM.read(eepromAddress + 2) != CACHED_SECTORS || EEPROM.read(eepromAddress + 3) != dictionaryCheck()) {
+        save();
+        return false;
+    }
+    byte *bytes = (byte *)_cache;
+    for (size_t i = 0; i < sizeof(_cache); i++) {
+        bytes[i] = EEPROM.read(eepromAddress + 4 + (int)i);
+    }
+    for (byte i = 0; i < CACHE_CARDS; i++) {
+        if (_cache[i].uidSize != 4 && _cache[i].uidSize != 7 && _cache[i].uidSize != 10) {
+            _cache[i].uidSize = 0;
+        }
+    }
+    return true;
+}
+
+void MifareKeyResolver::clear() {
+    memset(_cache, 0, sizeof(_cache));
+    save();
+}
+
+/**
+ * @brief Authenticates sector of the selected card (reader.uid). Tries the cached key first; if there is none or it
+ * no longer works, walks the dictionary and caches the key that opened the sector.
+ * Every failed attempt is followed by WUPA + SELECT of the same UID. If no key works the card is left selected
+ * without a Crypto1 session.
+ * @param trailerBlock Sector trailer of sector, the block the authentication is addressed to.
+ */
+MFRC522::StatusCode MifareKeyResolver::authenticate(byte sector, byte trailerBlock) {
+    const byte cached = cachedKey(_reader.uid, sector);
+    MFRC522::StatusCode status = MFRC522::STATUS_ERROR;
+    if (cached != NO_KEY && (cached & ~KEY_B) < _keyCount) {
+        status = attempt(cached, trailerBlock);
+        if (status == MFRC522::STATUS_OK) {
+            _stats.hits++;
+            learn(sector, cached);
+            return MFRC522::STATUS_OK;
+        }
+        if (!reactivate()) {
+            return status;
+        }
+    }
+    _stats.walks++;
+    for (byte code = 0; code < (byte)(KEY_B | _keyCount); code++) {
+        if ((code & ~KEY_B) >= _keyCount || code == cached) {
+            continue;
+        }
+        status = attempt(code, trailerBlock);
+        if (status == MFRC522::STATUS_OK) {
+            learn(sector, code);
+            return MFRC522::STATUS_OK;
+        }
+        if (!reactivate()) {
+            return status;
+        }
+    }
+    _stats.failures++;
+    return status;
+}
+
+byte MifareKeyResolver::cachedKey(const MFRC522::Uid &uid, byte sector) const {
+    const int index = find(uid);
+    if (index < 0 || sector >= CACHED_SECTORS) {
+        return NO_KEY;
+    }
+    return (_cache[index].keys[sector / 2] >> ((sector % 2) * 4)) & 0x0F;
+}
+
+int MifareKeyResolver::find(const MFRC522::Uid &uid) const {
+    for (byte i = 0; i < CACHE_CARDS; i++) {
+        if (_cache[i].uidSize != 0 && _cache[i].uidSize == uid.size && memcmp(_cache[i].uid, uid.uidByte, uid.size) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Moves the card to the front of the table, evicting the least recently used one if it is new, and stores code for sector.
+void MifareKeyResolver::learn(byte sector, byte code) {
+    _lastKey = code;
+    int index = find(_reader.uid);
+    Entry entry;
+    if (index < 0) {
+        index = CACHE_CARDS - 1;
+        entry.uidSize = _reader.uid.size;
+        memset(entry.uid, 0, sizeof(entry.uid));
+        memcpy(entry.uid, _reader.uid.uidByte, _reader.uid.size);
+        memset(entry.keys, 0xFF, sizeof(entry.keys));
+    } else {
+        entry = _cache[index];
+    }
+    memmove(&_cache[1], &_cache[0], index * sizeof(Entry));
+    _cache[0] = entry;
+    if (sector < CACHED_SECTORS && cachedKey(_reader.uid, sector) != code) {
+        const byte shift = (sector % 2) * 4;
+        _cache[0].keys[sector / 2] = (byte)((_cache[0].keys[sector / 2] & ~(0x0F << shift)) | (code << shift));
+        save();
+    }
+}
+
+MFRC522::StatusCode MifareKeyResolver::attempt(byte code, byte trailerBlock) {
+    _stats.attempts++;
+    const MFRC522::PICC_Command command = (code & KEY_B) ? MFRC522::PICC_CMD_MF_AUTH_KEY_B : MFRC522::PICC_CMD_MF_AUTH_KEY_A;
+    return _reader.PCD_Authenticate(command, trailerBlock, &_keys[code & ~KEY_B], &_reader.uid);
+}
+
+// A failed authentication sends the card back to IDLE, or HALT if it was woken from there: WUPA + SELECT by UID.
+bool MifareKeyResolver::reactivate() {
+    _reader.PCD_StopCrypto1();
+    byte atqa[2];
+    byte atqaSize = sizeof(atqa);
+    MFRC522::StatusCode status = _reader.PICC_WakeupA(atqa, &atqaSize);
+    if (status != MFRC522::STATUS_OK && status != MFRC522::STATUS_COLLISION) {
+        return false;
+    }
+    MFRC522::Uid uid = _reader.uid;
+    return _reader.PICC_Select(&uid, uid.size * 8) == MFRC522::STATUS_OK;
+}
+
+// Changes with the dictionary, so a table stored for other keys is not used.
+byte MifareKeyResolver::dictionaryCheck() const {
+    byte check = _keyCount;
+    for (byte i = 0; i < _keyCount; i++) {
+        for (byte j = 0; j < MFRC522::MF_KEY_SIZE; j++) {
+            check = (byte)(((check << 1) | (check >> 7)) ^ _keys[i].keyByte[j]);
+        }
+    }
+    return check;
+}
+
+void MifareKeyResolver::save() const {
+    if (_eepromAddress < 0) {
+        return;
+    }
+    EEPROM.update(_eepromAddress, EEPROM_MAGIC);
+    EEPROM.update(_eepromAddress + 1, CACHE_CARDS);
+    EEPROM.update(_eepromAddress + 2, CACHED_SECTORS);
+    EEPROM.update(_eepromAddress + 3, dictionaryCheck());
+    const byte *bytes = (const byte *)_cache;
+    for (size_t i = 0; i < sizeof(_cache); i++) {
+        EEPROM.update(_eepromAddress + 4 + (int)i, bytes[i]);
+    }
+}
@@ -0,0 +1,67 @@
+// Key resolution for MIFARE Classic: finds the key of a sector in a dictionary of keys, tried as Key A and Key B,
+// and remembers per card (UID) and sector which one worked, for all 40 sectors of a 4K. The table holds the last
+// CACHE_CARDS cards in LRU order, 248 bytes, and can be mirrored to EEPROM, so it survives a reset. A known card authenticates in one attempt; a
+// dictionary walk costs a WUPA + SELECT per failed key, because a failed authentication drops the card out of ACTIVE.
+#ifndef MIFARE_KEY_RESOLVER_H
+#define MIFARE_KEY_RESOLVER_H
+
+#include <Arduino.h>
+#include <MFRC522.h>
+#include <stdint.h>
+
+class MifareKeyResolver {
+public:
+    static const byte CACHE_CARDS = 8;
+    static const byte CACHED_SECTORS = 40;  // All of Mini/1K/4K: the vault spans every sector of the card
+    static const byte MAX_KEYS = 7;         // Dictionary entries beyond this are ignored
+    static const byte KEY_B = 0x08;         // Key code: dictionary index in bits 0-2, KEY_B set for Key B
+    static const byte NO_KEY = 0x0F;        // Key code of a sector that is not cached
+    static const int EEPROM_SIZE = 4 + CACHE_CARDS * (1 + 10 + CACHED_SECTORS / 2);    // Bytes used by enablePersistence()
+
+    struct Stats {
+        uint16_t hits;          // Sectors opened with the cached key
+        uint16_t walks;         // Dictionary walks, the cached key was missing or stale
+        uint16_t attempts;      // PCD_Authenticate() calls
+        uint16_t failures;      // No key of the dictionary opened the sector
+    };
+
+    /**
+     * @param reader The MFRC522 the card is selected on. The card is reader.uid.
+     * @param keys Dictionary, tried in order as Key A, then in order as Key B. Must outlive the resolver.
+     * @param keyCount Number of entries in keys, at most MAX_KEYS.
+     */
+    MifareKeyResolver(MFRC522 &reader, MFRC522::MIFARE_Key *keys, byte keyCount);
+
+    bool enablePersistence(int eepromAddress);  // Loads the table from EEPROM, learned keys are written back. false if nothing valid was stored.
+    MFRC522::StatusCode authenticate(byte sector, byte trailerBlock);
+    byte cachedKey(const MFRC522::Uid &uid, byte sector) const;    // Key code, NO_KEY if not cached
+    byte lastKey() const { return _lastKey; }   // Key code of the last successful authenticate()
+    void clear();                               // Forget all cards, in EEPROM too
+
+    const Stats &stats() const { return _stats; }
+    void resetStats() { memset(&_stats, 0, sizeof(_stats)); }
+
+private:
+    struct Entry {
+        byte uidSize;                       // 0: free
+        byte uid[10];
+        byte keys[CACHED_SECTORS / 2];      // Key code per sector, two per byte, low nibble first
+    };
+
+    int find(const MFRC522::Uid &uid) const;    // Index in _cache, -1 if the card is not cached
+    void learn(byte sector, byte code);
+    MFRC522::StatusCode attempt(byte code, byte trailerBlock);
+    bool reactivate();
+    byte dictionaryCheck() const;
+    void save() const;
+
+    MFRC522 &_reader;
+    MFRC522::MIFARE_Key *_keys;
+    byte _keyCount;
+    int _eepromAddress;         // -1: RAM only
+    byte _lastKey;
+    Entry _cache[CACHE_CARDS];  // Most recently used first
+    Stats _stats;
+};
+
+#endif // MIFARE_KEY_RESOLVER_H
@@ -0,0 +1,119 @@
+/**
+ * ----------------------------------------------------------------------------
+ * This is a MFRC522 library example; see https://github.com/miguelbalboa/rfid
+ * for further details and other examples.
+ *
+ * NOTE: The library file MFRC522.h has a lot of useful info. Please read it.
+ *
+ * Released into the public domain.
+ * ----------------------------------------------------------------------------
+ * Reads block 4 of a MIFARE Classic PICC (= card/tag) without blocking loop().
+ *
+ * Every exchange with the card is started with one of the Start functions and
+ * finished by calling PCD_Poll() from loop(), so the sketch keeps blinking the
+ * LED at an even rate while the card answers. The completion callback prints
+ * the result of each step.
+ *
+ * Typical pin layout used:
+ * -----------------------------------------------------------------------------------------
+ *             MFRC522      Arduino       Arduino   Arduino    Arduino          Arduino
+ *             Reader/PCD   Uno/101       Mega      Nano v3    Leonardo/Micro   Pro Micro
+ * Signal      Pin          Pin           Pin       Pin        Pin              Pin
+ * -----------------------------------------------------------------------------------------
+ * RST/Reset   RST          9             5         D9         RESET/ICSP-5     RST
+ * SPI SS      SDA(SS)      10            53        D10        10               10
+ * SPI MOSI    MOSI         11 / ICSP-4   51        D11        ICSP-4           16
+ * SPI MISO    MISO         12 / ICSP-1   50        D12        ICSP-1           14
+ * SPI SCK     SCK          13 / ICSP-3   52        D13        ICSP-3           15
+ *
+ * More pin layouts for other boards can be found here: https://github.com/miguelbalboa/rfid#pin-layout
+ *
+ */
+
+#include <SPI.h>
+#include <MFRC522.h>
+
+#define RST_PIN         9           // Configurable, see typical pin layout above
+#define SS_PIN          10          // Configurable, see typical pin layout above
+
+MFRC522 mfrc522(SS_PIN, RST_PIN);   // Create MFRC522 instance.
+
+MFRC522::MIFARE_Key key;
+byte buffer[18];
+byte size;
+
+enum Step : byte { DETECT, AUTHENTICATE, READ };
+Step step = DETECT;
+
+/**
+ * Called by PCD_Poll() when the running command completes.
+ */
+void onComplete(MFRC522 *reader, MFRC522::StatusCode status, void *context) {
+  Serial.print(F("Step "));
+  Serial.print(*(Step *)context);
+  Serial.print(F(": "));
+  Serial.println(reader->GetStatusCodeName(status));
+}
+
+/**
+ * Initialize.
+ */
+void setup() {
+  Serial.begin(9600); // Initialize serial communications with the PC
+  while (!Serial);    // Do nothing if no serial port is opened (added for Arduinos based on ATMEGA32U4)
+  SPI.begin();        // Init SPI bus
+  mfrc522.PCD_Init(); // Init MFRC522 card
+  pinMode(LED_BUILTIN, OUTPUT);
+
+  // Using the default key FFFFFFFFFFFFh which is the default at chip delivery from the factory
+  for (byte i = 0; i < 6; i++) {
+    key.keyByte[i] = 0xFF;
+  }
+  mfrc522.PCD_SetCompletionCallback(onComplete, &step);
+  mfrc522.PICC_StartIsNewCardPresent();
+}
+
+/**
+ * Main loop.
+ */
+void loop() {
+  digitalWrite(LED_BUILTIN, (millis() / 250) % 2);
+
+  MFRC522::StatusCode status = mfrc522.PCD_Poll();
+  if (status == MFRC522::STATUS_PENDING) {
+    return;
+  }
+
+  switch (step) {
+    case DETECT:
+      // Selecting runs the anticollision loop, which is still blocking (a few ms).
+      if (status == MFRC522::STATUS_OK && mfrc522.PICC_ReadCardSerial()) {
+        step = AUTHENTICATE;
+        mfrc522.PCD_StartAuthenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, 7, &key, &(mfrc522.uid));
+        return;
+      }
+      break;
+    case AUTHENTICATE:
+      if (status == MFRC522::STATUS_OK) {
+        step = READ;
+        size = sizeof(buffer);
+        mfrc522.MIFARE_StartRead(4, buffer, &size);
+        return;
+      }
+      break;
+    case READ:
+      if (status == MFRC522::STATUS_OK) {
+        for (byte i = 0; i < 16; i++) {
+          Serial.print(buffer[i] < 0x10 ? " 0" : " ");
+          Serial.print(buffer[i], HEX);
+        }
+        Serial.println();
+      }
+      mfrc522.PICC_HaltA();
+      mfrc522.PCD_StopCrypto1();
+      break;
+  }
+  // Done or failed: look for the next card.
+  step = DETECT;
+  mfrc522.PICC_StartIsNewCardPresent();
+}
@@ -0,0 +1,81 @@
+/**
+ * --------------------------------------------------------------------------------------------------------------------
+ * Example sketch/program measuring the register access speed of the compiled MFRC522 host interface.
+ * --------------------------------------------------------------------------------------------------------------------
+ * This is a MFRC522 library example; for further details and other examples see: https://github.com/miguelbalboa/rfid
+ *
+ * The host interface is selected at compile time, eg with a build flag:
+ *   -D MFRC522_TRANSPORT=MFRC522_TRANSPORT_SPI_FAST
+ * See MFRC522Transport.h for the choices. The sketch fills and drains the 64 byte FIFO and reads single registers,
+ * no PICC is needed. Compare the output of two builds to see what a transport gains on your board.
+ *
+ * @license Released into the public domain.
+ *
+ * Typical pin layout used:
+ * -----------------------------------------------------------------------------------------
+ *             MFRC522      Arduino       Arduino   Arduino    Arduino          Arduino
+ *             Reader/PCD   Uno/101       Mega      Nano v3    Leonardo/Micro   Pro Micro
+ * Signal      Pin          Pin           Pin       Pin        Pin              Pin
+ * -----------------------------------------------------------------------------------------
+ * RST/Reset   RST          9             5         D9         RESET/ICSP-5     RST
+ * SPI SS      SDA(SS)      10            53        D10        10               10
+ * SPI MOSI    MOSI         11 / ICSP-4   51        D11        ICSP-4           16
+ * SPI MISO    MISO         12 / ICSP-1   50        D12        ICSP-1           14
+ * SPI SCK     SCK          13 / ICSP-3   52        D13        ICSP-3           15
+ *
+ * More pin layouts for other boards can be found here: https://github.com/miguelbalboa/rfid#pin-layout
+ */
+
+#include <SPI.h>
+#include <MFRC522.h>
+
+#define RST_PIN         9          // Configurable, see typical pin layout above
+#define SS_PIN          10         // Configurable, see typical pin layout above
+
+#define ROUNDS          100
+
+MFRC522 mfrc522(SS_PIN, RST_PIN);  // Create MFRC522 instance
+
+void setup() {
+	Serial.begin(9600);		// Initialize serial communications with the PC
+	while (!Serial);		// Do nothing if no serial port is opened (added for Arduinos based on ATMEGA32U4)
+	SPI.begin();			// Init SPI bus
+	mfrc522.PCD_Init();		// Init MFRC522
+	Serial.print(F("MFRC522_TRANSPORT "));
+	Serial.println(MFRC522_TRANSPORT);
+}
+
+void loop() {
+	byte buffer[MFRC522::FIFO_SIZE];
+	for (byte i = 0; i < sizeof(buffer); i++) {
+		buffer[i] = i;
+	}
+
+	// 64 bytes into the FIFO and back, the path of every transceive.
+	unsigned long start = micros();
+	for (byte round = 0; round < ROUNDS; round++) {
+		mfrc522.PCD_WriteRegister(MFRC522::FIFOLevelReg, 0x80);		// FlushBuffer = 1, FIFO initialization
+		mfrc522.PCD_WriteRegister(MFRC522::FIFODataReg, sizeof(buffer), buffer);
+		mfrc522.PCD_ReadRegister(MFRC522::FIFODataReg, sizeof(buffer), buffer, 0);
+	}
+	const unsigned long fifoMicros = micros() - start;
+
+	// Single register reads, the path of status polling.
+	start = micros();
+	for (byte round = 0; round < ROUNDS; round++) {
+		mfrc522.PCD_ReadRegister(MFRC522::ComIrqReg);
+	}
+	const unsigned long registerMicros = micros() - start;
+
+	bool ok = true;
+	for (byte i = 0; i < sizeof(buffer); i++) {
+		ok = ok && buffer[i] == i;
+	}
+
+	Serial.print(F("FIFO 64 byte write + read: "));
+	Serial.print(fifoMicros / ROUNDS);
+	Serial.print(F(" us, single register read: "));
+	Serial.print(registerMicros / ROUNDS);
+	Serial.println(ok ? F(" us") : F(" us, FIFO data MISMATCH"));
+	delay(2000);
+}
@@ -6,6 +6,11 @@
 
 #include <Arduino.h>
 #include "MFRC522.h"
+#if defined(MFRC522_IRQ_SLEEP) && defined(__AVR__)
+#include <avr/sleep.h>
+#endif
+
+MFRC522 *MFRC522::_irqOwners[MFRC522::IRQ_SLOTS] = {};
 
 /////////////////////////////////////////////////////////////////////////////////////
 // Functions for setting up the Arduino
@@ -33,6 +38,23 @@ MFRC522::MFRC522(	byte chipSelectPin,		///< Arduino pin connected to MFRC522's S
 				) {
 	_chipSelectPin = chipSelectPin;
 	_resetPowerDownPin = resetPowerDownPin;
+	_irqPin = UNUSED_PIN;
+	_irqSlot = 0;
+	_irqPending = false;
+	_hardwareCRC = false;
+	_txSpeed = 0;
+	_rxSpeed = 0;
+	_commandTimeout = TIMEOUT_DEFAULT;
+	_timerPrescaler = 0x0A9;
+	_timerReload = 0x3E8;
+	_async.command = ASYNC_IDLE;
+	_async.result = STATUS_OK;
+	_async.callback = nullptr;
+	_async.context = nullptr;
+	PCD_ShadowInvalidate();
+#ifdef MFRC522_TELEMETRY
+	PCD_ResetTelemetry();
+#endif
 } // End constructor
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -46,12 +68,12 @@ MFRC522::MFRC522(	byte chipSelectPin,		///< Arduino pin connected to MFRC522's S
 void MFRC522::PCD_WriteRegister(	PCD_Register reg,	///< The register to write to. One of the PCD_Register enums.
 									byte value			///< The value to write.
 								) {
-	SPI.beginTransaction(SPISettings(MFRC522_SPICLOCK, MSBFIRST, SPI_MODE0));	// Set the settings to work with SPI bus
-	digitalWrite(_chipSelectPin, LOW);		// Select slave
-	SPI.transfer(reg);						// MSB == 0 is for writing. LSB is not used in address. Datasheet section 8.1.2.3.
-	SPI.transfer(value);
-	digitalWrite(_chipSelectPin, HIGH);		// Release slave again
-	SPI.endTransaction(); // Stop using the SPI bus
+	if (!PCD_ShadowPut(reg, value)) {
+		return;		// The register holds this value already.
+	}
+	_transport.beginTransaction();
+	PCD_TransferWrite(reg, 1, &value);
+	_transport.endTransaction();
 } // End PCD_WriteRegister()
 
 /**
@@ -62,14 +84,13 @@ void MFRC522::PCD_WriteRegister(	PCD_Register reg,	///< The register to write to
 									byte count,			///< The number of bytes to write to the register
 									byte *values		///< The values to write. Byte array.
 								) {
-	SPI.beginTransaction(SPISettings(MFRC522_SPICLOCK, MSBFIRST, SPI_MODE0));	// Set the settings to work with SPI bus
-	digitalWrite(_chipSelectPin, LOW);		// Select slave
-	SPI.transfer(reg);						// MSB == 0 is for writing. LSB is not used in address. Datasheet section 8.1.2.3.
-	for (byte index = 0; index < count; index++) {
-		SPI.transfer(values[index]);
-	}
-	digitalWrite(_chipSelectPin, HIGH);		// Release slave again
-	SPI.endTransaction(); // Stop using the SPI bus
+	if (count == 0) {
+		return;
+	}
+	PCD_ShadowPut(reg, values[count - 1]);	// The register keeps the last value.
+	_transport.beginTransaction();
+	PCD_TransferWrite(reg, count, values);
+	_transport.endTransaction();
 } // End PCD_WriteRegister()
 
 /**
@@ -79,12 +100,9 @@ void MFRC522::PCD_WriteRegister(	PCD_Register reg,	///< The register to write to
 byte MFRC522::PCD_ReadRegister(	PCD_Register reg	///< The register to read from. One of the PCD_Register enums.
 								) {
 	byte value;
-	SPI.beginTransaction(SPISettings(MFRC522_SPICLOCK, MSBFIRST, SPI_MODE0));	// Set the settings to work with SPI bus
-	digitalWrite(_chipSelectPin, LOW);			// Select slave
-	SPI.transfer(0x80 | reg);					// MSB == 1 is for reading. LSB is not used in address. Datasheet section 8.1.2.3.
-	value = SPI.transfer(0);					// Read the value back. Send 0 to stop reading.
-	digitalWrite(_chipSelectPin, HIGH);			// Release slave again
-	SPI.endTransaction(); // Stop using the SPI bus
+	_transport.beginTransaction();
+	PCD_TransferRead(reg, 1, &value, 0);
+	_transport.endTransaction();
 	return value;
 } // End PCD_ReadRegister()
 
@@ -100,30 +118,129 @@ void MFRC522::PCD_ReadRegister(	PCD_Register reg,	///< The register to read from
 	if (count == 0) {
 		return;
 	}
-	//Serial.print(F("Reading ")); 	Serial.print(count); Serial.println(F(" bytes from register."));
-	byte address = 0x80 | reg;				// MSB == 1 is for reading. LSB is not used in address. Datasheet section 8.1.2.3.
-	byte index = 0;							// Index in values array.
-	SPI.beginTransaction(SPISettings(MFRC522_SPICLOCK, MSBFIRST, SPI_MODE0));	// Set the settings to work with SPI bus
-	digitalWrite(_chipSelectPin, LOW);		// Select slave
-	count--;								// One read is performed outside of the loop
-	SPI.transfer(address);					// Tell MFRC522 which address we want to read
+	_transport.beginTransaction();
+	PCD_TransferRead(reg, count, values, rxAlign);
+	_transport.endTransaction();
+} // End PCD_ReadRegister()
+
+/**
+ * Writes count bytes to a register with one chip select assertion.
+ * The caller must own the bus, see MFRC522Transport::beginTransaction().
+ */
+void MFRC522::PCD_TransferWrite(	PCD_Register reg,		///< The register to write to. One of the PCD_Register enums.
+									byte count,				///< The number of bytes to write to the register
+									const byte *values		///< The values to write. Byte array.
+								) {
+	_transport.write(reg, count, values);
+#ifdef MFRC522_TELEMETRY
+	_telemetry.spiBytes += count + 1u;
+#endif
+} // End PCD_TransferWrite()
+
+/**
+ * Reads count bytes from a register with one chip select assertion.
+ * The caller must own the bus, see MFRC522Transport::beginTransaction().
+ */
+void MFRC522::PCD_TransferRead(	PCD_Register reg,	///< The register to read from. One of the PCD_Register enums.
+								byte count,			///< The number of bytes to read, at least 1
+								byte *values,		///< Byte array to store the values in.
+								byte rxAlign		///< Only bit positions rxAlign..7 in values[0] are updated.
+								) {
+	const byte first = values[0];
+	_transport.read(reg, count, values);
+#ifdef MFRC522_TELEMETRY
+	_telemetry.spiBytes += count + 1u;
+#endif
 	if (rxAlign) {		// Only update bit positions rxAlign..7 in values[0]
 		// Create bit mask for bit positions rxAlign..7
 		byte mask = (0xFF << rxAlign) & 0xFF;
-		// Read value and tell that we want to read the same address again.
-		byte value = SPI.transfer(address);
-		// Apply mask to both current value of values[0] and the new data in value.
-		values[0] = (values[0] & ~mask) | (value & mask);
-		index++;
+		// Apply mask to both the previous value of values[0] and the new data.
+		values[0] = (first & ~mask) | (values[0] & mask);
 	}
+} // End PCD_TransferRead()
+
+/**
+ * Executes a list of register operations inside a single SPI transaction.
+ * 
+ * Every PCD_WriteRegister()/PCD_ReadRegister() call pays for _transport.beginTransaction() and its own chip select toggle.
+ * Running the steps of a command as one sequence pays for the bus setup once. The chip only allows writes to a
+ * single address per chip select assertion (datasheet section 8.1.2.2), so each write still gets its own
+ * assertion, but runs of REG_OP_READ are clocked out back to back in one assertion (section 8.1.2.1).
+ * The read-modify-write ops do their read and write without giving up the bus in between.
+ * With MFRC522_SHADOW_REGISTERS they skip the read for shadowed registers, and writes of the value a
+ * shadowed register already holds are dropped. The bus is only claimed if anything is left to transfer.
+ */
+void MFRC522::PCD_RunRegisterSequence(	const PCD_RegisterOp *ops,	///< The operations to execute, in order.
+										byte count					///< Number of entries in ops.
+									) {
+	bool transaction = false;
+	byte index = 0;
 	while (index < count) {
-		values[index] = SPI.transfer(address);	// Read value and tell that we want to read the same address again.
+		const PCD_RegisterOp &op = ops[index];
+		PCD_RegisterOpType type = op.type;
+		byte value = op.value;
+		if ((type == REG_OP_SET_BITS || type == REG_OP_CLEAR_BITS) && PCD_ShadowGet(op.reg, &value)) {
+			value = (type == REG_OP_SET_BITS) ? (value | op.value) : (value & (~op.value));
+			type = REG_OP_WRITE;
+		}
+		if (type == REG_OP_WRITE && !PCD_ShadowPut(op.reg, value)) {
+			index++;	// The register holds this value already.
+			continue;
+		}
+		if (!transaction) {
+			_transport.beginTransaction();
+			transaction = true;
+		}
+		switch (type) {
+			case REG_OP_WRITE:
+				PCD_TransferWrite(op.reg, 1, &value);
+				break;
+			
+			case REG_OP_WRITE_BUFFER:
+				if (op.count) {
+					PCD_ShadowPut(op.reg, op.values[op.count - 1]);
+				}
+				PCD_TransferWrite(op.reg, op.count, op.values);
+				break;
+			
+			case REG_OP_READ:
+				// Each address byte clocks out the value of the previous address.
+				_transport.readFirst(op.reg);
+				while (index + 1 < count && ops[index + 1].type == REG_OP_READ) {
+					ops[index].values[0] = _transport.readNext(ops[index + 1].reg);
+					index++;
+#ifdef MFRC522_TELEMETRY
+					_telemetry.spiBytes++;
+#endif
+				}
+				ops[index].values[0] = _transport.readLast();
+#ifdef MFRC522_TELEMETRY
+				_telemetry.spiBytes += 2;
+#endif
+				break;
+			
+			case REG_OP_READ_BUFFER:
+				if (op.count) {
+					PCD_TransferRead(op.reg, op.count, op.values, op.value);
+				}
+				break;
+			
+			case REG_OP_SET_BITS:
+			case REG_OP_CLEAR_BITS: {
+				byte tmp;
+				PCD_TransferRead(op.reg, 1, &tmp, 0);
+				tmp = (op.type == REG_OP_SET_BITS) ? (tmp | op.value) : (tmp & (~op.value));
+				PCD_ShadowPut(op.reg, tmp);
+				PCD_TransferWrite(op.reg, 1, &tmp);
+				break;
+			}
+		}
 		index++;
 	}
-	values[index] = SPI.transfer(0);			// Read the final byte. Send 0 to stop reading.
-	digitalWrite(_chipSelectPin, HIGH);			// Release slave again
-	SPI.endTransaction(); // Stop using the SPI bus
-} // End PCD_ReadRegister()
+	if (transaction) {
+		_transport.endTransaction();
+	}
+} // End PCD_RunRegisterSequence()
 
 /**
  * Sets the bits given in mask in register reg.
@@ -131,9 +248,10 @@ void MFRC522::PCD_ReadRegister(	PCD_Register reg,	///< The register to read from
 void MFRC522::PCD_SetRegisterBitMask(	PCD_Register reg,	///< The register to update. One of the PCD_Register enums.
 										byte mask			///< The bits to set.
 									) { 
-	byte tmp;
-	tmp = PCD_ReadRegister(reg);
-	PCD_WriteRegister(reg, tmp | mask);			// set bit mask
+	const PCD_RegisterOp ops[] = {
+		{ REG_OP_SET_BITS, reg, mask, 0, nullptr }			// set bit mask
+	};
+	PCD_RunRegisterSequence(ops, sizeof(ops) / sizeof(ops[0]));
 } // End PCD_SetRegisterBitMask()
 
 /**
@@ -142,14 +260,113 @@ void MFRC522::PCD_SetRegisterBitMask(	PCD_Register reg,	///< The register to upd
 void MFRC522::PCD_ClearRegisterBitMask(	PCD_Register reg,	///< The register to update. One of the PCD_Register enums.
 										byte mask			///< The bits to clear.
 									  ) {
-	byte tmp;
-	tmp = PCD_ReadRegister(reg);
-	PCD_WriteRegister(reg, tmp & (~mask));		// clear bit mask
+	const PCD_RegisterOp ops[] = {
+		{ REG_OP_CLEAR_BITS, reg, mask, 0, nullptr }		// clear bit mask
+	};
+	PCD_RunRegisterSequence(ops, sizeof(ops) / sizeof(ops[0]));
 } // End PCD_ClearRegisterBitMask()
 
+#ifdef MFRC522_SHADOW_REGISTERS
+// Registers with a shadow copy. owned are the bits that only change when the driver writes them, the others
+// are status bits (CollReg CollPos, Status2Reg ModemState and MFCrypto1On) and read back as 0 from the shadow.
+// Writing a trigger bit as 1 has an effect by itself (BitFramingReg StartSend), so such writes are never dropped.
+// Neither are writes to Status2Reg: the MFRC522 sets MFCrypto1On, writing it 0 stops Crypto1.
+static const struct {
+	MFRC522::PCD_Register	reg;
+	byte					owned;
+	byte					trigger;
+	bool					droppable;
+} shadowRegisters[] = {
+	{ MFRC522::BitFramingReg,	0xFF,	0x80,	true },
+	{ MFRC522::CollReg,			0x80,	0x00,	true },
+	{ MFRC522::TxModeReg,		0xFF,	0x00,	true },
+	{ MFRC522::RxModeReg,		0xFF,	0x00,	true },
+	{ MFRC522::ModWidthReg,		0xFF,	0x00,	true },
+	{ MFRC522::TModeReg,		0xFF,	0x00,	true },
+	{ MFRC522::Status2Reg,		0xC0,	0x00,	false }
+};
+#endif
+
+/**
+ * Looks up the shadow copy of a register.
+ * 
+ * @return true if reg is shadowed and its value is known, value is then set to it.
+ */
+bool MFRC522::PCD_ShadowGet(	PCD_Register reg,	///< The register to look up.
+								byte *value			///< Out: The value last written, status bits 0.
+							) {
+#ifdef MFRC522_SHADOW_REGISTERS
+	for (byte i = 0; i < SHADOW_COUNT; i++) {
+		if (shadowRegisters[i].reg == reg) {
+			if (!(_shadowValid & (1 << i))) {
+				return false;
+			}
+			*value = _shadow[i];
+			return true;
+		}
+	}
+#else
+	(void)reg;
+	(void)value;
+#endif
+	return false;
+} // End PCD_ShadowGet()
+
+/**
+ * Records a value about to be written to a register.
+ * 
+ * @return false if the write can be dropped because the register holds the value already, true otherwise.
+ */
+bool MFRC522::PCD_ShadowPut(	PCD_Register reg,	///< The register written to.
+								byte value			///< The value written.
+							) {
+#ifdef MFRC522_SHADOW_REGISTERS
+	for (byte i = 0; i < SHADOW_COUNT; i++) {
+		if (shadowRegisters[i].reg == reg) {
+			if (shadowRegisters[i].droppable && (_shadowValid & (1 << i)) && value == _shadow[i] && !(value & shadowRegisters[i].trigger)) {
+				return false;
+			}
+			_shadow[i] = value & shadowRegisters[i].owned;
+			_shadowValid |= (1 << i);
+			return true;
+		}
+	}
+#else
+	(void)reg;
+	(void)value;
+#endif
+	return true;
+} // End PCD_ShadowPut()
+
+/**
+ * Forgets all shadowed register values, eg because the MFRC522 was reset.
+ */
+void MFRC522::PCD_ShadowInvalidate() {
+#ifdef MFRC522_SHADOW_REGISTERS
+	static_assert(sizeof(shadowRegisters) / sizeof(shadowRegisters[0]) == SHADOW_COUNT, "SHADOW_COUNT does not match shadowRegisters[]");
+	_shadowValid = 0;
+#endif
+} // End PCD_ShadowInvalidate()
+
+
+#if MFRC522_CRC_MODE == MFRC522_CRC_TABLE
+// CRC_A (ISO/IEC 14443-3 Annex B) is the reflected CRC-16/CCITT, polynomial 0x8408.
+// The table holds the CRC register after shifting out the 8 bits of each possible low byte.
+static constexpr uint16_t crcAEntry(uint16_t crc, byte bits = 8) {
+	return (bits == 0) ? crc : crcAEntry((crc & 1) ? (crc >> 1) ^ 0x8408 : (crc >> 1), bits - 1);
+}
+#define CRC_A_4(i)		crcAEntry(i), crcAEntry(i + 1), crcAEntry(i + 2), crcAEntry(i + 3)
+#define CRC_A_16(i)		CRC_A_4(i), CRC_A_4(i + 4), CRC_A_4(i + 8), CRC_A_4(i + 12)
+#define CRC_A_64(i)		CRC_A_16(i), CRC_A_16(i + 16), CRC_A_16(i + 32), CRC_A_16(i + 48)
+static const uint16_t crcATable[256] PROGMEM = { CRC_A_64(0), CRC_A_64(64), CRC_A_64(128), CRC_A_64(192) };
+#undef CRC_A_4
+#undef CRC_A_16
+#undef CRC_A_64
+#endif
 
 /**
- * Use the CRC coprocessor in the MFRC522 to calculate a CRC_A.
+ * Calculates a CRC_A.
+ * Uses the CRC coprocessor in the MFRC522, or the table in flash if MFRC522_CRC_MODE is MFRC522_CRC_TABLE.
  * 
  * @return STATUS_OK on success, STATUS_??? otherwise.
  */
@@ -157,36 +374,189 @@ MFRC522::StatusCode MFRC522::PCD_CalculateCRC(	byte *data,		///< In: Pointer to
 												byte length,	///< In: The number of bytes to transfer.
 												byte *result	///< Out: Pointer to result buffer. Result is written to result[0..1], low byte first.
 					 ) {
-	PCD_WriteRegister(CommandReg, PCD_Idle);		// Stop any active command.
-	PCD_WriteRegister(DivIrqReg, 0x04);				// Clear the CRCIRq interrupt request bit
-	PCD_WriteRegister(FIFOLevelReg, 0x80);			// FlushBuffer = 1, FIFO initialization
-	PCD_WriteRegister(FIFODataReg, length, data);	// Write data to the FIFO
-	PCD_WriteRegister(CommandReg, PCD_CalcCRC);		// Start the calculation
+	MFRC522_TELEMETRY_BEGIN();
+#if MFRC522_CRC_MODE == MFRC522_CRC_TABLE
+	uint16_t crc = 0x6363;	// Preset of CRC_A, ISO 14443-3 part 6.2.4
+	for (byte i = 0; i < length; i++) {
+		crc = (crc >> 8) ^ pgm_read_word(&crcATable[(crc ^ data[i]) & 0xFF]);
+	}
+	result[0] = crc & 0xFF;
+	result[1] = crc >> 8;
+	return MFRC522_TELEMETRY_END(TELEMETRY_CRC, STATUS_OK);
+#else
+	const bool irqMode = (_irqPin != UNUSED_PIN);
+	const PCD_RegisterOp start[] = {
+		{ REG_OP_WRITE,			ComIEnReg,		0x80, 0, nullptr },				// IRQ pin mode only: IRqInv=1 (IRQ active low), no ComIrqReg sources
+		{ REG_OP_WRITE,			DivIEnReg,		0x84, 0, nullptr },				// IRQ pin mode only: IRQPushPull=1, CRCIEn=1
+		{ REG_OP_WRITE,			CommandReg,		PCD_Idle, 0, nullptr },			// Stop any active command.
+		{ REG_OP_WRITE,			DivIrqReg,		0x04, 0, nullptr },				// Clear the CRCIRq interrupt request bit
+		{ REG_OP_WRITE,			FIFOLevelReg,	0x80, 0, nullptr },				// FlushBuffer = 1, FIFO initialization
+		{ REG_OP_WRITE_BUFFER,	FIFODataReg,	0, length, data },	// Write data to the FIFO
+		{ REG_OP_WRITE,			CommandReg,		PCD_CalcCRC, 0, nullptr }		// Start the calculation
+	};
+	const byte first = irqMode ? 0 : 2;
+	_irqPending = false;
+	PCD_RunRegisterSequence(&start[first], sizeof(start) / sizeof(start[0]) - first);
 	
 	// Wait for the CRC calculation to complete. Check for the register to
-	// indicate that the CRC calculation is complete in a loop. If the
-	// calculation is not indicated as complete in ~90ms, then time out
-	// the operation.
-	const uint32_t deadline = millis() + 89;
+	// indicate that the CRC calculation is complete in a loop. The coprocessor
+	// needs a few μs even for a full FIFO, so if the calculation is not indicated
+	// as complete in ~5ms, then time out the operation.
+	// In IRQ pin mode the register is only checked after the pin asserted.
+	const uint32_t deadline = millis() + 5;
 
 	do {
+		if (irqMode) {
+			if (!PCD_WaitForIrq(deadline)) {
+				break;
+			}
+			_irqPending = false;
+		}
 		// DivIrqReg[7..0] bits are: Set2 reserved reserved MfinActIRq reserved CRCIRq reserved reserved
 		byte n = PCD_ReadRegister(DivIrqReg);
 		if (n & 0x04) {									// CRCIRq bit set - calculation done
-			PCD_WriteRegister(CommandReg, PCD_Idle);	// Stop calculating CRC for new content in the FIFO.
-			// Transfer the result from the registers to the result buffer
-			result[0] = PCD_ReadRegister(CRCResultRegL);
-			result[1] = PCD_ReadRegister(CRCResultRegH);
-			return STATUS_OK;
+			// Stop calculating CRC for new content in the FIFO and
+			// transfer the result from the registers to the result buffer.
+			const PCD_RegisterOp finish[] = {
+				{ REG_OP_WRITE,	CommandReg,		PCD_Idle, 0, nullptr },
+				{ REG_OP_READ,	CRCResultRegL,	0, 0, &result[0] },
+				{ REG_OP_READ,	CRCResultRegH,	0, 0, &result[1] }
+			};
+			PCD_RunRegisterSequence(finish, sizeof(finish) / sizeof(finish[0]));
+			return MFRC522_TELEMETRY_END(TELEMETRY_CRC, STATUS_OK);
+		}
+		if (!irqMode) {
+			yield();
 		}
-		yield();
 	}
 	while (static_cast<uint32_t> (millis()) < deadline);
 
-	// 89ms passed and nothing happened. Communication with the MFRC522 might be down.
-	return STATUS_TIMEOUT;
+	// 5ms passed and nothing happened. Communication with the MFRC522 might be down.
+	return MFRC522_TELEMETRY_END(TELEMETRY_CRC, STATUS_TIMEOUT);
+#endif
 } // End PCD_CalculateCRC()
 
+/**
+ * Prepares a frame in buffer[0..*length-1] to be sent with CRC_A.
+ * With hardware CRC the MFRC522 appends the CRC_A on transmission, otherwise it is calculated
+ * and stored in buffer[*length..*length+1]. The buffer must have room for these 2 bytes.
+ * In MFRC522_CRC_HARDWARE mode this enables TxCRCEn/RxCRCEn, so the response comes back without CRC_A.
+ * 
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PCD_AppendCRC(	byte *buffer,	///< In: The frame. Out: The frame followed by CRC_A, unless the MFRC522 appends it.
+											byte *length	///< In: Number of bytes in the frame. Out: Number of bytes to send.
+										) {
+#if MFRC522_CRC_MODE == MFRC522_CRC_HARDWARE
+	PCD_SetHardwareCRC(true);
+#endif
+	if (_hardwareCRC) {
+		return STATUS_OK;
+	}
+	MFRC522::StatusCode result = PCD_CalculateCRC(buffer, *length, &buffer[*length]);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	*length += 2;
+	return STATUS_OK;
+} // End PCD_AppendCRC()
+
+/**
+ * Switches CRC_A generation on transmission (TxCRCEn) and checking on reception (RxCRCEn) on or off together.
+ * Only writes TxModeReg and RxModeReg if the state changes. The bit rates set by PCD_SetBitRates() are kept.
+ */
+void MFRC522::PCD_SetHardwareCRC(bool enabled	///< True => TxCRCEn=1 and RxCRCEn=1
+								) {
+	if (enabled == _hardwareCRC) {
+		return;
+	}
+	const byte value = enabled ? 0x80 : 0x00;
+	const PCD_RegisterOp ops[] = {
+		{ REG_OP_WRITE,	TxModeReg,	(byte)(value | (_txSpeed << 4)), 0, nullptr },
+		{ REG_OP_WRITE,	RxModeReg,	(byte)(value | (_rxSpeed << 4)), 0, nullptr }
+	};
+	PCD_RunRegisterSequence(ops, sizeof(ops) / sizeof(ops[0]));
+	_hardwareCRC = enabled;
+} // End PCD_SetHardwareCRC()
+
+/**
+ * Sets the bit rates of both directions, keeping TxCRCEn and RxCRCEn. The modulation pause is narrowed
+ * with the transmit bit rate, it must end within the first half of the bit (ModWidthReg, AN10834 values).
+ */
+void MFRC522::PCD_SetBitRates(byte txSpeed,	///< PCD to PICC: 0 = 106 kBd, 1 = 212 kBd, 2 = 424 kBd, 3 = 848 kBd
+							  byte rxSpeed	///< PICC to PCD, same coding
+							  ) {
+	static const byte modWidth[4] = { 0x26, 0x15, 0x0A, 0x05 };
+	_txSpeed = txSpeed & 0x03;
+	_rxSpeed = rxSpeed & 0x03;
+	const byte crc = _hardwareCRC ? 0x80 : 0x00;
+	const PCD_RegisterOp ops[] = {
+		{ REG_OP_WRITE,	TxModeReg,		(byte)(crc | (_txSpeed << 4)), 0, nullptr },
+		{ REG_OP_WRITE,	RxModeReg,		(byte)(crc | (_rxSpeed << 4)), 0, nullptr },
+		{ REG_OP_WRITE,	ModWidthReg,	modWidth[_txSpeed], 0, nullptr }
+	};
+	PCD_RunRegisterSequence(ops, sizeof(ops) / sizeof(ops[0]));
+} // End PCD_SetBitRates()
+
+/**
+ * Sets 106 kBd, the default modulation width and software CRC_A, as expected by REQA, WUPA and anticollision.
+ */
+void MFRC522::PCD_ResetModulation() {
+	const PCD_RegisterOp reset[] = {
+		{ REG_OP_WRITE,	TxModeReg,		0x00, 0, nullptr },		// Reset baud rates
+		{ REG_OP_WRITE,	RxModeReg,		0x00, 0, nullptr },
+		{ REG_OP_WRITE,	ModWidthReg,	0x26, 0, nullptr }		// Reset ModWidthReg
+	};
+	PCD_RunRegisterSequence(reset, sizeof(reset) / sizeof(reset[0]));
+	_hardwareCRC = false;
+	_txSpeed = 0;
+	_rxSpeed = 0;
+} // End PCD_ResetModulation()
+
+/**
+ * Sets the receive timeout of the next command started by PCD_CommunicateWithPICC().
+ * The commands after it use TIMEOUT_DEFAULT again.
+ */
+void MFRC522::PCD_SetCommandTimeout(uint32_t timeoutMicros	///< Time in μs from the end of the transmission until the command times out, eg TIMEOUT_HLTA.
+									) {
+	_commandTimeout = timeoutMicros;
+} // End PCD_SetCommandTimeout()
+
+/**
+ * Adds the timer register writes for a timeout to ops[].
+ * f_timer = 13.56 MHz / (2*TPreScaler+1). TPreScaler = 169 gives 25μs steps up to 1.6s, longer
+ * timeouts (ISO-DEP FWI 13 and 14) use TPreScaler = 4095, ie 604μs steps up to 39s.
+ * Registers that already hold the value are skipped.
+ * 
+ * @return The number of entries added to ops[], at most 4.
+ */
+byte MFRC522::PCD_PrepareTimer(	uint32_t timeoutMicros,	///< Time in μs from the end of the transmission until TimerIRq.
+								PCD_RegisterOp *ops		///< Out: Room for 4 register operations.
+								) {
+	uint16_t prescaler = 0x0A9;
+	uint32_t reload = (timeoutMicros + 24) / 25;
+	if (reload > 0xFFFF) {
+		prescaler = 0xFFF;
+		reload = min((timeoutMicros + 603) / 604, (uint32_t)0xFFFF);
+	}
+	if (reload == 0) {
+		reload = 1;
+	}
+	
+	byte count = 0;
+	if (prescaler != _timerPrescaler) {
+		ops[count++] = { REG_OP_WRITE, TModeReg,		(byte)(0x80 | (prescaler >> 8)), 0, nullptr };	// TAuto=1, TPrescaler_Hi
+		ops[count++] = { REG_OP_WRITE, TPrescalerReg,	(byte)(prescaler & 0xFF), 0, nullptr };
+		_timerPrescaler = prescaler;
+	}
+	if (reload != _timerReload) {
+		ops[count++] = { REG_OP_WRITE, TReloadRegH,		(byte)(reload >> 8), 0, nullptr };
+		ops[count++] = { REG_OP_WRITE, TReloadRegL,		(byte)(reload & 0xFF), 0, nullptr };
+		_timerReload = reload;
+	}
+	return count;
+} // End PCD_PrepareTimer()
+
 
 /////////////////////////////////////////////////////////////////////////////////////
 // Functions for manipulating the MFRC522
@@ -198,9 +568,8 @@ MFRC522::StatusCode MFRC522::PCD_CalculateCRC(	byte *data,		///< In: Pointer to
 void MFRC522::PCD_Init() {
 	bool hardReset = false;
 
-	// Set the chipSelectPin as digital output, do not select the slave yet
-	pinMode(_chipSelectPin, OUTPUT);
-	digitalWrite(_chipSelectPin, HIGH);
+	// Set up the host interface, for SPI the chipSelectPin as digital output, do not select the slave yet
+	_transport.begin(_chipSelectPin);
 	
 	// If a valid pin number has been set, pull device out of power down / reset state.
 	if (_resetPowerDownPin != UNUSED_PIN) {
@@ -215,6 +584,7 @@ void MFRC522::PCD_Init() {
 			// Section 8.8.2 in the datasheet says the oscillator start-up time is the start up time of the crystal + 37,74μs. Let us be generous: 50ms.
 			delay(50);
 			hardReset = true;
+			PCD_ShadowInvalidate();
 		}
 	}
 
@@ -222,23 +592,28 @@ void MFRC522::PCD_Init() {
 		PCD_Reset();
 	}
 	
-	// Reset baud rates
-	PCD_WriteRegister(TxModeReg, 0x00);
-	PCD_WriteRegister(RxModeReg, 0x00);
-	// Reset ModWidthReg
-	PCD_WriteRegister(ModWidthReg, 0x26);
-
 	// When communicating with a PICC we need a timeout if something goes wrong.
 	// f_timer = 13.56 MHz / (2*TPreScaler+1) where TPreScaler = [TPrescaler_Hi:TPrescaler_Lo].
 	// TPrescaler_Hi are the four low bits in TModeReg. TPrescaler_Lo is TPrescalerReg.
-	PCD_WriteRegister(TModeReg, 0x80);			// TAuto=1; timer starts automatically at the end of the transmission in all communication modes at all speeds
-	PCD_WriteRegister(TPrescalerReg, 0xA9);		// TPreScaler = TModeReg[3..0]:TPrescalerReg, ie 0x0A9 = 169 => f_timer=40kHz, ie a timer period of 25μs.
-	PCD_WriteRegister(TReloadRegH, 0x03);		// Reload timer with 0x3E8 = 1000, ie 25ms before timeout.
-	PCD_WriteRegister(TReloadRegL, 0xE8);
-	
-	PCD_WriteRegister(TxASKReg, 0x40);		// Default 0x00. Force a 100 % ASK modulation independent of the ModGsPReg register setting
-	PCD_WriteRegister(ModeReg, 0x3D);		// Default 0x3F. Set the preset value for the CRC coprocessor for the CalcCRC command to 0x6363 (ISO 14443-3 part 6.2.4)
-	PCD_AntennaOn();						// Enable the antenna driver pins TX1 and TX2 (they were disabled by the reset)
+	const PCD_RegisterOp config[] = {
+		{ REG_OP_WRITE,	TxModeReg,		0x00, 0, nullptr },		// Reset baud rates
+		{ REG_OP_WRITE,	RxModeReg,		0x00, 0, nullptr },
+		{ REG_OP_WRITE,	ModWidthReg,	0x26, 0, nullptr },		// Reset ModWidthReg
+		{ REG_OP_WRITE,	TModeReg,		0x80, 0, nullptr },		// TAuto=1; timer starts automatically at the end of the transmission in all communication modes at all speeds
+		{ REG_OP_WRITE,	TPrescalerReg,	0xA9, 0, nullptr },		// TPreScaler = TModeReg[3..0]:TPrescalerReg, ie 0x0A9 = 169 => f_timer=40kHz, ie a timer period of 25μs.
+		{ REG_OP_WRITE,	TReloadRegH,	0x03, 0, nullptr },		// Reload timer with 0x3E8 = 1000, ie 25ms before timeout.
+		{ REG_OP_WRITE,	TReloadRegL,	0xE8, 0, nullptr },
+		{ REG_OP_WRITE,	TxASKReg,		0x40, 0, nullptr },		// Default 0x00. Force a 100 % ASK modulation independent of the ModGsPReg register setting
+		{ REG_OP_WRITE,	ModeReg,		0x3D, 0, nullptr },		// Default 0x3F. Set the preset value for the CRC coprocessor for the CalcCRC command to 0x6363 (ISO 14443-3 part 6.2.4)
+		{ REG_OP_SET_BITS, TxControlReg, 0x03, 0, nullptr }		// Enable the antenna driver pins TX1 and TX2 (they were disabled by the reset)
+	};
+	PCD_RunRegisterSequence(config, sizeof(config) / sizeof(config[0]));
+	_hardwareCRC = false;
+	_txSpeed = 0;
+	_rxSpeed = 0;
+	_commandTimeout = TIMEOUT_DEFAULT;
+	_timerPrescaler = 0x0A9;
+	_timerReload = 0x3E8;
 } // End PCD_Init()
 
 /**
@@ -266,6 +641,7 @@ void MFRC522::PCD_Init(	byte chipSelectPin,		///< Arduino pin connected to MFRC5
  */
 void MFRC522::PCD_Reset() {
 	PCD_WriteRegister(CommandReg, PCD_SoftReset);	// Issue the SoftReset command.
+	PCD_ShadowInvalidate();							// All registers are back at their reset values.
 	// The datasheet does not mention how long the SoftRest command takes to complete.
 	// But the MFRC522 might have been in soft power-down mode (triggered by bit 4 of CommandReg) 
 	// Section 8.8.2 in the datasheet says the oscillator start-up time is the start up time of the crystal + 37,74μs. Let us be generous: 50ms.
@@ -406,6 +782,103 @@ bool MFRC522::PCD_PerformSelfTest() {
 	return true;
 } // End PCD_PerformSelfTest()
 
+/**
+ * Switches command completion from polling ComIrqReg/DivIrqReg to the MFRC522 IRQ pin.
+ * 
+ * PCD_CommunicateWithPICC() and PCD_CalculateCRC() program ComIEnReg/DivIEnReg for the interrupt
+ * sources they wait for, and then yield() (or idle sleep if MFRC522_IRQ_SLEEP is defined on AVR)
+ * until the pin asserts. The register is read once per interrupt instead of continuously.
+ * The IRQ output is configured push-pull and active low, so no external pull-up is required.
+ * 
+ * @return false if the pin cannot raise an external interrupt or all IRQ_SLOTS are in use. Polling stays active then.
+ */
+bool MFRC522::PCD_EnableIrqPin(	byte irqPin		///< Arduino pin connected to MFRC522's IRQ output (Pin 23). Must support attachInterrupt().
+								) {
+	static void (* const handlers[IRQ_SLOTS])() = {
+		PCD_IrqHandler<0>, PCD_IrqHandler<1>, PCD_IrqHandler<2>, PCD_IrqHandler<3>
+	};
+	
+	if (digitalPinToInterrupt(irqPin) == NOT_AN_INTERRUPT) {
+		return false;
+	}
+	PCD_DisableIrqPin();
+	
+	// Find a free interrupt handler.
+	byte slot = 0;
+	while (slot < IRQ_SLOTS && _irqOwners[slot] != nullptr) {
+		slot++;
+	}
+	if (slot == IRQ_SLOTS) {
+		return false;
+	}
+	_irqOwners[slot] = this;
+	_irqSlot = slot;
+	_irqPin = irqPin;
+	_irqPending = false;
+	
+	pinMode(irqPin, INPUT_PULLUP);
+	attachInterrupt(digitalPinToInterrupt(irqPin), handlers[slot], FALLING);
+	return true;
+} // End PCD_EnableIrqPin()
+
+/**
+ * Returns to polling ComIrqReg/DivIrqReg for command completion and releases the IRQ pin.
+ */
+void MFRC522::PCD_DisableIrqPin() {
+	if (_irqPin == UNUSED_PIN) {
+		return;
+	}
+	detachInterrupt(digitalPinToInterrupt(_irqPin));
+	_irqOwners[_irqSlot] = nullptr;
+	_irqPin = UNUSED_PIN;
+	
+	// Stop driving the IRQ output.
+	PCD_WriteRegister(ComIEnReg, 0x00);
+	PCD_WriteRegister(DivIEnReg, 0x00);
+} // End PCD_DisableIrqPin()
+
+/**
+ * Interrupt handler for one of the IRQ_SLOTS. Only flags the owning instance, all SPI traffic happens in PCD_WaitForIrq()'s caller.
+ */
+template <byte slot>
+void MFRC522::PCD_IrqHandler() {
+	MFRC522 *owner = _irqOwners[slot];
+	if (owner != nullptr) {
+		owner->_irqPending = true;
+	}
+} // End PCD_IrqHandler()
+
+/**
+ * Waits until the IRQ pin asserted or the deadline passed.
+ * The caller clears _irqPending once it has read the interrupt request registers.
+ * 
+ * @return true if the IRQ pin asserted, false if the deadline passed first.
+ */
+bool MFRC522::PCD_WaitForIrq(	uint32_t deadline	///< millis() value at which to give up.
+							) {
+	while (!_irqPending) {
+		if (static_cast<uint32_t> (millis()) >= deadline) {
+			return false;
+		}
+#if defined(MFRC522_IRQ_SLEEP) && defined(__AVR__)
+		// Idle sleep keeps timer0 (and so millis()) and the external interrupts running.
+		// sei() takes effect after the next instruction, so an IRQ arriving after the check still wakes sleep_cpu().
+		set_sleep_mode(SLEEP_MODE_IDLE);
+		cli();
+		if (!_irqPending) {
+			sleep_enable();
+			sei();
+			sleep_cpu();
+			sleep_disable();
+		}
+		sei();
+#else
+		yield();
+#endif
+	}
+	return true;
+} // End PCD_WaitForIrq()
+
 /////////////////////////////////////////////////////////////////////////////////////
 // Power control
 /////////////////////////////////////////////////////////////////////////////////////
@@ -474,51 +947,116 @@ MFRC522::StatusCode MFRC522::PCD_CommunicateWithPICC(	byte command,		///< The co
 														byte rxAlign,		///< In: Defines the bit position in backData[0] for the first bit received. Default 0.
 														bool checkCRC		///< In: True => The last two bytes of the response is assumed to be a CRC_A that must be validated.
 									 ) {
+	PCD_StartCommunication(command, waitIRq, sendData, sendLen, backData, backLen, validBits, rxAlign, checkCRC);
+	MFRC522::StatusCode result;
+	while ((result = PCD_PollCommunication()) == STATUS_PENDING) {
+		PCD_WaitForPoll();
+	}
+	return result;
+} // End PCD_CommunicateWithPICC()
+
+/**
+ * Transfers data to the MFRC522 FIFO and starts a command, without waiting for it to complete.
+ * Call PCD_PollCommunication() until it stops returning STATUS_PENDING. The buffers must stay valid until then.
+ * 
+ * @return STATUS_PENDING, the command is running.
+ */
+MFRC522::StatusCode MFRC522::PCD_StartCommunication(	byte command,		///< The command to execute. One of the PCD_Command enums.
+														byte waitIRq,		///< The bits in the ComIrqReg register that signals successful completion of the command.
+														byte *sendData,		///< Pointer to the data to transfer to the FIFO.
+														byte sendLen,		///< Number of bytes to transfer to the FIFO.
+														byte *backData,		///< nullptr or pointer to buffer if data should be read back after executing the command.
+														byte *backLen,		///< In: Max number of bytes to write to *backData. Out: The number of bytes returned.
+														byte *validBits,	///< In/Out: The number of valid bits in the last byte. 0 for 8 valid bits.
+														byte rxAlign,		///< In: Defines the bit position in backData[0] for the first bit received. Default 0.
+														bool checkCRC		///< In: True => The last two bytes of the response is assumed to be a CRC_A that must be validated.
+									 ) {
 	// Prepare values for BitFramingReg
 	byte txLastBits = validBits ? *validBits : 0;
 	byte bitFraming = (rxAlign << 4) + txLastBits;		// RxAlign = BitFramingReg[6..4]. TxLastBits = BitFramingReg[2..0]
 	
-	PCD_WriteRegister(CommandReg, PCD_Idle);			// Stop any active command.
-	PCD_WriteRegister(ComIrqReg, 0x7F);					// Clear all seven interrupt request bits
-	PCD_WriteRegister(FIFOLevelReg, 0x80);				// FlushBuffer = 1, FIFO initialization
-	PCD_WriteRegister(FIFODataReg, sendLen, sendData);	// Write sendData to the FIFO
-	PCD_WriteRegister(BitFramingReg, bitFraming);		// Bit adjustments
-	PCD_WriteRegister(CommandReg, command);				// Execute the command
+	// The timeout applies to this command only.
+	const uint32_t timeoutMicros = _commandTimeout;
+	_commandTimeout = TIMEOUT_DEFAULT;
+	
+	// Program the timer, load the FIFO and start the command in one SPI transaction.
+	// We wrote BitFramingReg ourselves, so StartSend can be set without reading it back first.
+	const bool irqMode = (_irqPin != UNUSED_PIN);
+	PCD_RegisterOp start[13];
+	byte count = 0;
+	if (irqMode) {
+		start[count++] = { REG_OP_WRITE,		ComIEnReg,		(byte)(0x80 | waitIRq | 0x01), 0, nullptr };	// IRqInv=1 (IRQ active low), waitIRq sources and TimerIEn
+		start[count++] = { REG_OP_WRITE,		DivIEnReg,		0x80, 0, nullptr };							// IRQPushPull=1, CRCIEn=0
+	}
+	count += PCD_PrepareTimer(timeoutMicros, &start[count]);
+	start[count++] = { REG_OP_WRITE,			CommandReg,		PCD_Idle, 0, nullptr };						// Stop any active command.
+	start[count++] = { REG_OP_WRITE,			ComIrqReg,		0x7F, 0, nullptr };							// Clear all seven interrupt request bits
+	start[count++] = { REG_OP_WRITE,			FIFOLevelReg,	0x80, 0, nullptr };							// FlushBuffer = 1, FIFO initialization
+	start[count++] = { REG_OP_WRITE_BUFFER,		FIFODataReg,	0, sendLen, sendData };			// Write sendData to the FIFO
+	start[count++] = { REG_OP_WRITE,			BitFramingReg,	bitFraming, 0, nullptr };					// Bit adjustments
+	start[count++] = { REG_OP_WRITE,			CommandReg,		command, 0, nullptr };						// Execute the command
 	if (command == PCD_Transceive) {
-		PCD_SetRegisterBitMask(BitFramingReg, 0x80);	// StartSend=1, transmission of data starts
+		start[count++] = { REG_OP_WRITE,		BitFramingReg,	(byte)(bitFraming | 0x80), 0, nullptr };	// StartSend=1, transmission of data starts
 	}
+	_irqPending = false;
+	PCD_RunRegisterSequence(start, count);
 	
 	// In PCD_Init() we set the TAuto flag in TModeReg. This means the timer
 	// automatically starts when the PCD stops transmitting.
-	//
-	// Wait here for the command to complete. The bits specified in the
-	// `waitIRq` parameter define what bits constitute a completed command.
-	// When they are set in the ComIrqReg register, then the command is
-	// considered complete. If the command is not indicated as complete in
-	// ~36ms, then consider the command as timed out.
-	const uint32_t deadline = millis() + 36;
-	bool completed = false;
+	// If the command is not indicated as complete within the timeout plus
+	// 11ms for transmission, PCD_PollCommunication() considers it timed out.
+	_transfer.waitIRq = waitIRq;
+	_transfer.backData = backData;
+	_transfer.backLen = backLen;
+	_transfer.validBits = validBits;
+	_transfer.rxAlign = rxAlign;
+	_transfer.checkCRC = checkCRC;
+	_transfer.deadline = millis() + timeoutMicros / 1000 + 11;
+	return STATUS_PENDING;
+} // End PCD_StartCommunication()
 
-	do {
-		byte n = PCD_ReadRegister(ComIrqReg);	// ComIrqReg[7..0] bits are: Set1 TxIRq RxIRq IdleIRq HiAlertIRq LoAlertIRq ErrIRq TimerIRq
-		if (n & waitIRq) {					// One of the interrupts that signal success has been set.
-			completed = true;
-			break;
-		}
-		if (n & 0x01) {						// Timer interrupt - nothing received in 25ms
-			return STATUS_TIMEOUT;
+/**
+ * Checks once whether the command started by PCD_StartCommunication() has completed, and if so
+ * transfers the data back from the FIFO. The bits specified in the `waitIRq` parameter define
+ * what bits constitute a completed command.
+ * In IRQ pin mode the MFRC522 is only read after the pin asserted, which also happens on TimerIRq,
+ * so polling costs no SPI traffic while the PICC is busy.
+ *
+ * @return STATUS_PENDING while the command runs, then STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PCD_PollCommunication() {
+	const bool irqMode = (_irqPin != UNUSED_PIN);
+	const bool expired = static_cast<uint32_t> (millis()) >= _transfer.deadline;
+	if (irqMode) {
+		if (!_irqPending && !expired) {
+			return STATUS_PENDING;
 		}
-		yield();
+		_irqPending = false;
 	}
-	while (static_cast<uint32_t> (millis()) < deadline);
-
-	// 36ms and nothing happened. Communication with the MFRC522 might be down.
-	if (!completed) {
-		return STATUS_TIMEOUT;
+	byte n = PCD_ReadRegister(ComIrqReg);	// ComIrqReg[7..0] bits are: Set1 TxIRq RxIRq IdleIRq HiAlertIRq LoAlertIRq ErrIRq TimerIRq
+	if (!(n & _transfer.waitIRq)) {			// None of the interrupts that signal success has been set.
+		if ((n & 0x01) || expired) {		// Timer interrupt - nothing received within the timeout. Or the deadline
+			return STATUS_TIMEOUT;			// passed and nothing happened: communication with the MFRC522 might be down.
+		}
+		return STATUS_PENDING;
 	}
 	
+	byte *backData = _transfer.backData;
+	byte *backLen = _transfer.backLen;
+	byte *validBits = _transfer.validBits;
+	
+	// Fetch the error flags, FIFO level and RxLastBits in one burst read.
+	byte errorRegValue;		// ErrorReg[7..0] bits are: WrErr TempErr reserved BufferOvfl CollErr CRCErr ParityErr ProtocolErr
+	byte fifoLevel;
+	byte controlRegValue;
+	const PCD_RegisterOp status[] = {
+		{ REG_OP_READ,	ErrorReg,		0, 0, &errorRegValue },
+		{ REG_OP_READ,	FIFOLevelReg,	0, 0, &fifoLevel },			// Number of bytes in the FIFO
+		{ REG_OP_READ,	ControlReg,		0, 0, &controlRegValue }
+	};
+	PCD_RunRegisterSequence(status, sizeof(status) / sizeof(status[0]));
+	
 	// Stop now if any errors except collisions were detected.
-	byte errorRegValue = PCD_ReadRegister(ErrorReg); // ErrorReg[7..0] bits are: WrErr TempErr reserved BufferOvfl CollErr CRCErr ParityErr ProtocolErr
 	if (errorRegValue & 0x13) {	 // BufferOvfl ParityErr ProtocolErr
 		return STATUS_ERROR;
 	}
@@ -527,13 +1065,13 @@ MFRC522::StatusCode MFRC522::PCD_CommunicateWithPICC(	byte command,		///< The co
 	
 	// If the caller wants data back, get it from the MFRC522.
 	if (backData && backLen) {
-		byte n = PCD_ReadRegister(FIFOLevelReg);	// Number of bytes in the FIFO
+		byte n = fifoLevel & 0x7F;	// FIFOLevelReg[6..0] is the number of bytes in the FIFO.
 		if (n > *backLen) {
 			return STATUS_NO_ROOM;
 		}
 		*backLen = n;											// Number of bytes returned
-		PCD_ReadRegister(FIFODataReg, n, backData, rxAlign);	// Get received data from FIFO
-		_validBits = PCD_ReadRegister(ControlReg) & 0x07;		// RxLastBits[2:0] indicates the number of valid bits in the last received byte. If this value is 000b, the whole byte is valid.
+		PCD_ReadRegister(FIFODataReg, n, backData, _transfer.rxAlign);	// Get received data from FIFO
+		_validBits = controlRegValue & 0x07;					// RxLastBits[2:0] indicates the number of valid bits in the last received byte. If this value is 000b, the whole byte is valid.
 		if (validBits) {
 			*validBits = _validBits;
 		}
@@ -545,11 +1083,18 @@ MFRC522::StatusCode MFRC522::PCD_CommunicateWithPICC(	byte command,		///< The co
 	}
 	
 	// Perform CRC_A validation if requested.
-	if (backData && backLen && checkCRC) {
+	if (backData && backLen && _transfer.checkCRC) {
 		// In this case a MIFARE Classic NAK is not OK.
 		if (*backLen == 1 && _validBits == 4) {
 			return STATUS_MIFARE_NACK;
 		}
+		// With RxCRCEn the MFRC522 has checked and removed the CRC_A already.
+		if (_hardwareCRC) {
+			if ((errorRegValue & 0x04) || _validBits != 0) {	// CRCErr
+				return STATUS_CRC_WRONG;
+			}
+			return STATUS_OK;
+		}
 		// We need at least the CRC_A value and all 8 bits of the last byte must be received.
 		if (*backLen < 2 || _validBits != 0) {
 			return STATUS_CRC_WRONG;
@@ -566,7 +1111,188 @@ MFRC522::StatusCode MFRC522::PCD_CommunicateWithPICC(	byte command,		///< The co
 	}
 	
 	return STATUS_OK;
-} // End PCD_CommunicateWithPICC()
+} // End PCD_PollCommunication()
+
+/**
+ * Waits between two PCD_PollCommunication() calls of a blocking function:
+ * until the IRQ pin asserts or the deadline passes in IRQ pin mode, one yield() otherwise.
+ */
+void MFRC522::PCD_WaitForPoll() {
+	if (_irqPin != UNUSED_PIN) {
+		PCD_WaitForIrq(_transfer.deadline);
+	} else {
+		yield();
+	}
+} // End PCD_WaitForPoll()
+
+/**
+ * Transceives a frame of any length, for ISO/IEC 14443-4 blocks up to FSD/FSC = 256 bytes.
+ * The frame is sendHead followed by sendData. Up to FIFO_SIZE bytes are loaded before StartSend, the rest is
+ * written while the frame is on the air, whenever the FIFO has run down to STREAM_WATER_LEVEL bytes (LoAlert).
+ * The answer is read whenever the FIFO has filled up to FIFO_SIZE - STREAM_WATER_LEVEL bytes (HiAlert) and
+ * after RxIRq; its first backHeadLen bytes go into backHead, the rest into backData.
+ * At 106 kBd a byte takes 85μs on the air, so each refill or drain has about 1.3ms.
+ * CRC_A is always done by the MFRC522 (TxCRCEn and RxCRCEn). Uses the timeout set by PCD_SetCommandTimeout().
+ * In IRQ pin mode the alert interrupts wake the host, otherwise it polls FIFOLevelReg.
+ * 
+ * @return STATUS_OK on success, STATUS_NO_ROOM if the answer does not fit, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PCD_TransceiveStream(	const byte *sendHead,	///< Start of the frame, eg PCB and CID.
+													byte sendHeadLen,		///< Number of bytes in sendHead, at most FIFO_SIZE.
+													const byte *sendData,	///< Rest of the frame, eg the INF field.
+													uint16_t sendLen,		///< Number of bytes in sendData.
+													byte *backHead,			///< Buffer for the first backHeadLen bytes of the answer.
+													byte backHeadLen,		///< Answers shorter than this fail with STATUS_ERROR.
+													byte *backData,			///< Buffer for the rest of the answer.
+													uint16_t *backLen		///< In: Size of backData. Out: The number of bytes stored in backData.
+								 ) {
+	PCD_SetHardwareCRC(true);
+	const uint32_t timeoutMicros = _commandTimeout;
+	_commandTimeout = TIMEOUT_DEFAULT;
+	const bool irqMode = (_irqPin != UNUSED_PIN);
+	const uint16_t backCapacity = *backLen;
+	*backLen = 0;
+	
+	// Load the FIFO and start the command in one SPI transaction, as PCD_StartCommunication() does.
+	const byte firstLen = (byte)min((uint16_t)(FIFO_SIZE - sendHeadLen), sendLen);
+	uint16_t sent = firstLen;
+	PCD_RegisterOp start[15];
+	byte count = 0;
+	if (irqMode) {
+		// IRqInv=1, RxIEn, IdleIEn, TimerIEn and LoAlertIEn while there is more to send, HiAlertIEn after that.
+		start[count++] = { REG_OP_WRITE,		ComIEnReg,		(byte)(0xB1 | (sent < sendLen ? 0x04 : 0x08)), 0, nullptr };
+		start[count++] = { REG_OP_WRITE,		DivIEnReg,		0x80, 0, nullptr };
+	}
+	count += PCD_PrepareTimer(timeoutMicros, &start[count]);
+	start[count++] = { REG_OP_WRITE,			CommandReg,		PCD_Idle, 0, nullptr };
+	start[count++] = { REG_OP_WRITE,			ComIrqReg,		0x7F, 0, nullptr };
+	start[count++] = { REG_OP_WRITE,			FIFOLevelReg,	0x80, 0, nullptr };
+	start[count++] = { REG_OP_WRITE,			WaterLevelReg,	STREAM_WATER_LEVEL, 0, nullptr };
+	if (sendHeadLen > 0) {
+		start[count++] = { REG_OP_WRITE_BUFFER,	FIFODataReg,	0, sendHeadLen, const_cast<byte *>(sendHead) };
+	}
+	if (firstLen > 0) {
+		start[count++] = { REG_OP_WRITE_BUFFER,	FIFODataReg,	0, firstLen, const_cast<byte *>(sendData) };
+	}
+	start[count++] = { REG_OP_WRITE,			BitFramingReg,	0x00, 0, nullptr };
+	start[count++] = { REG_OP_WRITE,			CommandReg,		PCD_Transceive, 0, nullptr };
+	start[count++] = { REG_OP_WRITE,			BitFramingReg,	0x80, 0, nullptr };		// StartSend
+	_irqPending = false;
+	PCD_RunRegisterSequence(start, count);
+	
+	// The timer only covers the wait for the answer. Like PCD_StartCommunication() allow 11ms more, plus the air time of both frames.
+	const uint32_t deadline = millis() + timeoutMicros / 1000 + 11 + (sendHeadLen + sendLen + backHeadLen + backCapacity) / 8;
+	uint16_t received = 0;	// Bytes of the answer read so far, head included
+	for (;;) {
+		byte irq;
+		byte level;
+		const PCD_RegisterOp poll[] = {
+			{ REG_OP_WRITE,	ComIrqReg,		0x0C, 0, nullptr },		// Clear HiAlertIRq and LoAlertIRq, so the next alert asserts the IRQ pin again
+			{ REG_OP_READ,	ComIrqReg,		0, 0, &irq },
+			{ REG_OP_READ,	FIFOLevelReg,	0, 0, &level }
+		};
+		_irqPending = false;
+		PCD_RunRegisterSequence(irqMode ? poll : poll + 1, irqMode ? 3 : 2);
+		level &= 0x7F;
+		
+		bool moved = false;
+		if (sent < sendLen) {
+			if (irq & 0x40) {		// TxIRq: the FIFO ran empty and the frame ended before all data was sent.
+				return STATUS_ERROR;
+			}
+			if (level <= STREAM_WATER_LEVEL) {
+				const byte chunk = (byte)min((uint16_t)(FIFO_SIZE - level), (uint16_t)(sendLen - sent));
+				PCD_RegisterOp refill[2];
+				byte ops = 0;
+				refill[ops++] = { REG_OP_WRITE_BUFFER, FIFODataReg, 0, chunk, const_cast<byte *>(sendData + sent) };
+				sent += chunk;
+				if (irqMode && sent == sendLen) {
+					refill[ops++] = { REG_OP_WRITE, ComIEnReg, 0xB9, 0, nullptr };	// From now on wake up on HiAlert
+				}
+				PCD_RunRegisterSequence(refill, ops);
+				moved = true;
+			}
+		} else if (irq & 0x30) {	// RxIRq or IdleIRq: the rest of the answer is in the FIFO.
+			break;
+		} else if (irq & 0x01) {	// TimerIRq: nothing received within the timeout.
+			return STATUS_TIMEOUT;
+		} else if ((irq & 0x40) && level >= FIFO_SIZE - STREAM_WATER_LEVEL) {	// Only after TxIRq, before that the FIFO holds the end of the frame sent
+			PCD_StreamRead(level, backHead, backHeadLen, backData, backCapacity, &received);
+			moved = true;
+		}
+		
+		if (!moved) {
+			if (static_cast<uint32_t> (millis()) >= deadline) {
+				return STATUS_TIMEOUT;
+			}
+			if (irqMode) {
+				PCD_WaitForIrq(deadline);
+			} else {
+				yield();
+			}
+		}
+	}
+	
+	byte errorRegValue;
+	byte fifoLevel;
+	byte controlRegValue;
+	const PCD_RegisterOp status[] = {
+		{ REG_OP_READ,	ErrorReg,		0, 0, &errorRegValue },
+		{ REG_OP_READ,	FIFOLevelReg,	0, 0, &fifoLevel },
+		{ REG_OP_READ,	ControlReg,		0, 0, &controlRegValue }
+	};
+	PCD_RunRegisterSequence(status, sizeof(status) / sizeof(status[0]));
+	if (errorRegValue & 0x13) {		// BufferOvfl ParityErr ProtocolErr
+		return STATUS_ERROR;
+	}
+	PCD_StreamRead(fifoLevel & 0x7F, backHead, backHeadLen, backData, backCapacity, &received);
+	if (errorRegValue & 0x08) {		// CollErr
+		return STATUS_COLLISION;
+	}
+	if ((errorRegValue & 0x04) || (controlRegValue & 0x07)) {	// CRCErr, or the last byte is incomplete
+		return STATUS_CRC_WRONG;
+	}
+	if (received < backHeadLen) {
+		return STATUS_ERROR;
+	}
+	if (received - backHeadLen > backCapacity) {
+		*backLen = backCapacity;
+		return STATUS_NO_ROOM;
+	}
+	*backLen = received - backHeadLen;
+	return STATUS_OK;
+} // End PCD_TransceiveStream()
+
+/**
+ * Reads count bytes of an answer from the FIFO for PCD_TransceiveStream(). The bytes go into backHead until
+ * it is full, then into backData. Anything beyond backCapacity is read and dropped.
+ */
+void MFRC522::PCD_StreamRead(	byte count,				///< Number of bytes to read from the FIFO.
+								byte *backHead,			///< Buffer for the first backHeadLen bytes.
+								byte backHeadLen,		///< Size of backHead.
+								byte *backData,			///< Buffer for the rest.
+								uint16_t backCapacity,	///< Size of backData.
+								uint16_t *received		///< In/Out: The number of bytes of the answer read so far.
+								) {
+	byte scratch[16];
+	while (count > 0) {
+		byte chunk;
+		byte *target;
+		if (*received < backHeadLen) {
+			chunk = (byte)min((uint16_t)count, (uint16_t)(backHeadLen - *received));
+			target = backHead + *received;
+		} else if (*received - backHeadLen < backCapacity) {
+			chunk = (byte)min((uint16_t)count, (uint16_t)(backCapacity - (*received - backHeadLen)));
+			target = backData + (*received - backHeadLen);
+		} else {
+			chunk = min(count, (byte)sizeof(scratch));
+			target = scratch;
+		}
+		PCD_ReadRegister(FIFODataReg, chunk, target);
+		*received += chunk;
+		count -= chunk;
+	}
+} // End PCD_StreamRead()
 
 /**
  * Transmits a REQuest command, Type A. Invites PICCs in state IDLE to go to READY and prepare for anticollision or selection. 7 bit frame.
@@ -602,22 +1328,7 @@ MFRC522::StatusCode MFRC522::PICC_REQA_or_WUPA(	byte command, 		///< The command
 												byte *bufferATQA,	///< The buffer to store the ATQA (Answer to request) in
 												byte *bufferSize	///< Buffer size, at least two bytes. Also number of bytes returned if STATUS_OK.
 											) {
-	byte validBits;
-	MFRC522::StatusCode status;
-	
-	if (bufferATQA == nullptr || *bufferSize < 2) {	// The ATQA response is 2 bytes long.
-		return STATUS_NO_ROOM;
-	}
-	PCD_ClearRegisterBitMask(CollReg, 0x80);		// ValuesAfterColl=1 => Bits received after collision are cleared.
-	validBits = 7;									// For REQA and WUPA we need the short frame format - transmit only 7 bits of the last (and only) byte. TxLastBits = BitFramingReg[2..0]
-	status = PCD_TransceiveData(&command, 1, bufferATQA, bufferSize, &validBits);
-	if (status != STATUS_OK) {
-		return status;
-	}
-	if (*bufferSize != 2 || validBits != 0) {		// ATQA must be exactly 16 bits.
-		return STATUS_ERROR;
-	}
-	return STATUS_OK;
+	return PCD_Finish(PICC_StartREQA_or_WUPA(command, bufferATQA, bufferSize));
 } // End PICC_REQA_or_WUPA()
 
 /**
@@ -640,6 +1351,18 @@ MFRC522::StatusCode MFRC522::PICC_REQA_or_WUPA(	byte command, 		///< The command
 MFRC522::StatusCode MFRC522::PICC_Select(	Uid *uid,			///< Pointer to Uid struct. Normally output, but can also be used to supply a known UID.
 											byte validBits		///< The number of known UID bits supplied in *uid. Normally 0. If set you must also supply uid->size.
 										 ) {
+	MFRC522_TELEMETRY_BEGIN();
+	return MFRC522_TELEMETRY_END(TELEMETRY_SELECT, PICC_SelectCascade(uid, validBits));
+} // End PICC_Select()
+
+/**
+ * The SELECT/ANTICOLLISION loop of PICC_Select().
+ * 
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PICC_SelectCascade(	Uid *uid,			///< Pointer to Uid struct. Normally output, but can also be used to supply a known UID.
+													byte validBits		///< The number of known UID bits supplied in *uid. Normally 0. If set you must also supply uid->size.
+												 ) {
 	bool uidComplete;
 	bool selectDone;
 	bool useCascadeTag;
@@ -749,19 +1472,20 @@ MFRC522::StatusCode MFRC522::PICC_Select(	Uid *uid,			///< Pointer to Uid struct
 				buffer[1] = 0x70; // NVB - Number of Valid Bits: Seven whole bytes
 				// Calculate BCC - Block Check Character
 				buffer[6] = buffer[2] ^ buffer[3] ^ buffer[4] ^ buffer[5];
-				// Calculate CRC_A
-				result = PCD_CalculateCRC(buffer, 7, &buffer[7]);
+				// Add CRC_A
+				bufferUsed		= 7;
+				result = PCD_AppendCRC(buffer, &bufferUsed);
 				if (result != STATUS_OK) {
 					return result;
 				}
 				txLastBits		= 0; // 0 => All 8 bits are valid.
-				bufferUsed		= 9;
 				// Store response in the last 3 bytes of buffer (BCC and CRC_A - not needed after tx)
 				responseBuffer	= &buffer[6];
 				responseLength	= 3;
 			}
 			else { // This is an ANTICOLLISION.
 				//Serial.print(F("ANTICOLLISION: currentLevelKnownBits=")); Serial.println(currentLevelKnownBits, DEC);
+				PCD_SetHardwareCRC(false); // Anticollision frames carry no CRC_A.
 				txLastBits		= currentLevelKnownBits % 8;
 				count			= currentLevelKnownBits / 8;	// Number of whole bytes in the UID part.
 				index			= 2 + count;					// Number of whole bytes: SEL + NVB + UIDs
@@ -772,12 +1496,12 @@ MFRC522::StatusCode MFRC522::PICC_Select(	Uid *uid,			///< Pointer to Uid struct
 				responseLength	= sizeof(buffer) - index;
 			}
 			
-			// Set bit adjustments
-			rxAlign = txLastBits;											// Having a separate variable is overkill. But it makes the next line easier to read.
-			PCD_WriteRegister(BitFramingReg, (rxAlign << 4) + txLastBits);	// RxAlign = BitFramingReg[6..4]. TxLastBits = BitFramingReg[2..0]
+			// Set bit adjustments. PCD_CommunicateWithPICC() writes them to BitFramingReg as part of its start sequence.
+			rxAlign = txLastBits;
 			
-			// Transmit the buffer and receive the response.
-			result = PCD_TransceiveData(buffer, bufferUsed, responseBuffer, &responseLength, &txLastBits, rxAlign);
+			// Transmit the buffer and receive the response. The CRC_A of the SAK is validated.
+			PCD_SetCommandTimeout(TIMEOUT_ACTIVATION);
+			result = PCD_TransceiveData(buffer, bufferUsed, responseBuffer, &responseLength, &txLastBits, rxAlign, currentLevelKnownBits >= 32);
 			if (result == STATUS_COLLISION) { // More than one PICC in the field => collision.
 				byte valueOfCollReg = PCD_ReadRegister(CollReg); // CollReg[7..0] bits are: ValuesAfterColl reserved CollPosNotValid CollPos[4:0]
 				if (valueOfCollReg & 0x20) { // CollPosNotValid
@@ -823,17 +1547,9 @@ MFRC522::StatusCode MFRC522::PICC_Select(	Uid *uid,			///< Pointer to Uid struct
 		}
 		
 		// Check response SAK (Select Acknowledge)
-		if (responseLength != 3 || txLastBits != 0) { // SAK must be exactly 24 bits (1 byte + CRC_A).
+		if (responseLength != (_hardwareCRC ? 1 : 3) || txLastBits != 0) { // SAK must be exactly 24 bits (1 byte + CRC_A), the MFRC522 removes the CRC_A with RxCRCEn.
 			return STATUS_ERROR;
 		}
-		// Verify CRC_A - do our own calculation and store the control in buffer[2..3] - those bytes are not needed anymore.
-		result = PCD_CalculateCRC(responseBuffer, 1, &buffer[2]);
-		if (result != STATUS_OK) {
-			return result;
-		}
-		if ((buffer[2] != responseBuffer[1]) || (buffer[3] != responseBuffer[2])) {
-			return STATUS_CRC_WRONG;
-		}
 		if (responseBuffer[0] & 0x04) { // Cascade bit set - UID not complete yes
 			cascadeLevel++;
 		}
@@ -847,39 +1563,109 @@ MFRC522::StatusCode MFRC522::PICC_Select(	Uid *uid,			///< Pointer to Uid struct
 	uid->size = 3 * cascadeLevel + 1;
 
 	return STATUS_OK;
-} // End PICC_Select()
+} // End PICC_SelectCascade()
 
 /**
- * Instructs a PICC in state ACTIVE(*) to go to state HALT.
- *
+ * Wakes up a PICC with a known UID, eg one that was halted after an earlier PICC_Select(), and selects it again.
+ * WUPA reaches cards in state IDLE and HALT. The cached UID is sent in one SELECT per cascade level, so there
+ * are no ANTICOLLISION frames and no collision handling: 2 frames for a single size UID instead of 3.
+ * If no PICC answers the SELECT, eg because a different card is in the field now, the PICCs are woken up
+ * again and selected with full anticollision. Compare *uid with the old UID if it must be the same card.
+ * 
  * @return STATUS_OK on success, STATUS_??? otherwise.
- */ 
-MFRC522::StatusCode MFRC522::PICC_HaltA() {
+ */
+MFRC522::StatusCode MFRC522::PICC_Reselect(	Uid *uid	///< Pointer to Uid struct. Input: the UID of the PICC to select. Output: the UID of the PICC selected.
+										) {
+	byte bufferATQA[2];
+	byte bufferSize = sizeof(bufferATQA);
 	MFRC522::StatusCode result;
-	byte buffer[4];
 	
-	// Build command buffer
-	buffer[0] = PICC_CMD_HLTA;
-	buffer[1] = 0;
-	// Calculate CRC_A
-	result = PCD_CalculateCRC(buffer, 2, &buffer[2]);
-	if (result != STATUS_OK) {
+	PCD_StopCrypto1();								// A halted MIFARE Classic PICC left its Crypto1 session
+	PCD_ResetModulation();
+	result = PICC_WakeupA(bufferATQA, &bufferSize);
+	if (result != STATUS_OK && result != STATUS_COLLISION) {
 		return result;
 	}
-	
-	// Send the command.
-	// The standard says:
-	//		If the PICC responds with any modulation during a period of 1 ms after the end of the frame containing the
-	//		HLTA command, this response shall be interpreted as 'not acknowledge'.
-	// We interpret that this way: Only STATUS_TIMEOUT is a success.
-	result = PCD_TransceiveData(buffer, sizeof(buffer), nullptr, 0);
-	if (result == STATUS_TIMEOUT) {
-		return STATUS_OK;
+	if (uid->size == 4 || uid->size == 7 || uid->size == 10) {
+		if (PICC_Select(uid, uid->size * 8) == STATUS_OK) {
+			return STATUS_OK;
+		}
+		// The PICCs that did not match went back to IDLE or HALT.
+		bufferSize = sizeof(bufferATQA);
+		result = PICC_WakeupA(bufferATQA, &bufferSize);
+		if (result != STATUS_OK && result != STATUS_COLLISION) {
+			return result;
+		}
 	}
-	if (result == STATUS_OK) { // That is ironically NOT ok in this case ;-)
-		return STATUS_ERROR;
+	return PICC_Select(uid);
+} // End PICC_Reselect()
+
+/**
+ * Enumerates the UIDs of all PICCs in state IDLE with one binary tree walk of the anticollision.
+ * Within a cascade level only ANTICOLLISION frames are sent, so the PICCs stay in READY: at a collision
+ * the walk takes the 0 branch and comes back for the 1 branch later, a complete UID CLn is a leaf.
+ * A leaf with the cascade tag is selected to walk the next cascade level, which sends the other PICCs
+ * back to IDLE; they are woken up again with REQA before the walk goes on.
+ * The walk ends with HLTA, which returns the READY PICCs to IDLE. The SAK is not known yet: select the
+ * PICCs one by one with PICC_InventorySelect(), which also sets uid->sak.
+ * A branch that cannot be walked, eg because the SELECT of its cascade tag fails, is skipped and the walk goes on;
+ * its error is returned at the end. uids then holds the PICCs of the other branches.
+ * 
+ * @return STATUS_OK on success, STATUS_NO_ROOM if there are more than capacity PICCs (uids holds the first ones),
+ * STATUS_??? if a branch was skipped or the walk could not go on (uids holds the PICCs found).
+ */
+MFRC522::StatusCode MFRC522::PICC_Inventory(	Uid *uids,		///< Array to store the UIDs in
+												byte capacity,	///< Number of entries in uids
+												byte *count		///< Out: the number of UIDs stored
+											) {
+	byte bufferATQA[2];
+	byte bufferSize = sizeof(bufferATQA);
+	MFRC522::StatusCode result;
+	Uid path;
+	
+	*count = 0;
+	PCD_ResetModulation();
+	result = PICC_RequestA(bufferATQA, &bufferSize);
+	if (result != STATUS_OK && result != STATUS_COLLISION) {
+		return result;
 	}
+	PCD_ClearRegisterBitMask(CollReg, 0x80);		// ValuesAfterColl=1 => Bits received after collision are cleared.
+	result = PICC_InventoryLevel(1, &path, uids, capacity, count);
+	PICC_HaltA();
 	return result;
+} // End PICC_Inventory()
+
+/**
+ * Selects a PICC found by PICC_Inventory(): REQA, then one SELECT per cascade level with the known UID.
+ * PICCs already halted stay in HALT, the others that do not match go back to IDLE.
+ * 
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PICC_InventorySelect(	Uid *uid	///< Pointer to Uid struct from PICC_Inventory(). uid->sak is set on success.
+												) {
+	byte bufferATQA[2];
+	byte bufferSize = sizeof(bufferATQA);
+	MFRC522::StatusCode result;
+	
+	if (uid->size != 4 && uid->size != 7 && uid->size != 10) {
+		return STATUS_INVALID;
+	}
+	PCD_StopCrypto1();								// The previous PICC may have left a Crypto1 session
+	PCD_ResetModulation();
+	result = PICC_RequestA(bufferATQA, &bufferSize);
+	if (result != STATUS_OK && result != STATUS_COLLISION) {
+		return result;
+	}
+	return PICC_Select(uid, uid->size * 8);
+} // End PICC_InventorySelect()
+
+/**
+ * Instructs a PICC in state ACTIVE(*) to go to state HALT.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */ 
+MFRC522::StatusCode MFRC522::PICC_HaltA() {
+	return PCD_Finish(PICC_StartHaltA());
 } // End PICC_HaltA()
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -903,25 +1689,7 @@ MFRC522::StatusCode MFRC522::PCD_Authenticate(byte command,		///< PICC_CMD_MF_AU
 											MIFARE_Key *key,	///< Pointer to the Crypteo1 key to use (6 bytes)
 											Uid *uid			///< Pointer to Uid struct. The first 4 bytes of the UID is used.
 											) {
-	byte waitIRq = 0x10;		// IdleIRq
-	
-	// Build command buffer
-	byte sendData[12];
-	sendData[0] = command;
-	sendData[1] = blockAddr;
-	for (byte i = 0; i < MF_KEY_SIZE; i++) {	// 6 key bytes
-		sendData[2+i] = key->keyByte[i];
-	}
-	// Use the last uid bytes as specified in http://cache.nxp.com/documents/application_note/AN10927.pdf
-	// section 3.2.5 "MIFARE Classic Authentication".
-	// The only missed case is the MF1Sxxxx shortcut activation,
-	// but it requires cascade tag (CT) byte, that is not part of uid.
-	for (byte i = 0; i < 4; i++) {				// The last 4 bytes of the UID
-		sendData[8+i] = uid->uidByte[i+uid->size-4];
-	}
-	
-	// Start the authentication.
-	return PCD_CommunicateWithPICC(PCD_MFAuthent, waitIRq, &sendData[0], sizeof(sendData));
+	return PCD_Finish(PCD_StartAuthenticate(command, blockAddr, key, uid));
 } // End PCD_Authenticate()
 
 /**
@@ -946,6 +1714,7 @@ void MFRC522::PCD_StopCrypto1() {
  * 
  * The buffer must be at least 18 bytes because a CRC_A is also returned.
  * Checks the CRC_A before returning STATUS_OK.
+ * With MFRC522_CRC_HARDWARE the MFRC522 checks and removes the CRC_A, so only the 16 data bytes are returned.
  * 
  * @return STATUS_OK on success, STATUS_??? otherwise.
  */
@@ -953,24 +1722,7 @@ MFRC522::StatusCode MFRC522::MIFARE_Read(	byte blockAddr, 	///< MIFARE Classic:
 											byte *buffer,		///< The buffer to store the data in
 											byte *bufferSize	///< Buffer size, at least 18 bytes. Also number of bytes returned if STATUS_OK.
 										) {
-	MFRC522::StatusCode result;
-	
-	// Sanity check
-	if (buffer == nullptr || *bufferSize < 18) {
-		return STATUS_NO_ROOM;
-	}
-	
-	// Build command buffer
-	buffer[0] = PICC_CMD_MF_READ;
-	buffer[1] = blockAddr;
-	// Calculate CRC_A
-	result = PCD_CalculateCRC(buffer, 2, &buffer[2]);
-	if (result != STATUS_OK) {
-		return result;
-	}
-	
-	// Transmit the buffer and receive the response, validate CRC_A.
-	return PCD_TransceiveData(buffer, 4, buffer, bufferSize, nullptr, 0, true);
+	return PCD_Finish(MIFARE_StartRead(blockAddr, buffer, bufferSize));
 } // End MIFARE_Read()
 
 /**
@@ -988,30 +1740,7 @@ MFRC522::StatusCode MFRC522::MIFARE_Write(	byte blockAddr, ///< MIFARE Classic:
 											byte *buffer,	///< The 16 bytes to write to the PICC
 											byte bufferSize	///< Buffer size, must be at least 16 bytes. Exactly 16 bytes are written.
 										) {
-	MFRC522::StatusCode result;
-	
-	// Sanity check
-	if (buffer == nullptr || bufferSize < 16) {
-		return STATUS_INVALID;
-	}
-	
-	// Mifare Classic protocol requires two communications to perform a write.
-	// Step 1: Tell the PICC we want to write to block blockAddr.
-	byte cmdBuffer[2];
-	cmdBuffer[0] = PICC_CMD_MF_WRITE;
-	cmdBuffer[1] = blockAddr;
-	result = PCD_MIFARE_Transceive(cmdBuffer, 2); // Adds CRC_A and checks that the response is MF_ACK.
-	if (result != STATUS_OK) {
-		return result;
-	}
-	
-	// Step 2: Transfer the data
-	result = PCD_MIFARE_Transceive(buffer, bufferSize); // Adds CRC_A and checks that the response is MF_ACK.
-	if (result != STATUS_OK) {
-		return result;
-	}
-	
-	return STATUS_OK;
+	return PCD_Finish(MIFARE_StartWrite(blockAddr, buffer, bufferSize));
 } // End MIFARE_Write()
 
 /**
@@ -1037,13 +1766,90 @@ MFRC522::StatusCode MFRC522::MIFARE_Ultralight_Write(	byte page, 		///< The page
 	memcpy(&cmdBuffer[2], buffer, 4);
 	
 	// Perform the write
-	result = PCD_MIFARE_Transceive(cmdBuffer, 6); // Adds CRC_A and checks that the response is MF_ACK.
+	result = PCD_MIFARE_Transceive(cmdBuffer, 6, false, TIMEOUT_MIFARE_WRITE); // Adds CRC_A and checks that the response is MF_ACK.
 	if (result != STATUS_OK) {
 		return result;
 	}
 	return STATUS_OK;
 } // End MIFARE_Ultralight_Write()
 
+/**
+ * Reads the pages startPage to endPage of a NTAG21x or MIFARE Ultralight EV1 PICC with one FAST_READ command.
+ * At most FAST_READ_MAX_PAGES pages per call, the whole answer must fit into the FIFO.
+ * 
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::MIFARE_Ultralight_FastRead(	byte startPage,		///< The first page to return data from.
+															byte endPage,		///< The last page to return data from.
+															byte *buffer,		///< The buffer to store the data in
+															byte *bufferSize	///< Buffer size, at least 4 bytes per page + 2 bytes CRC_A. Also number of bytes returned if STATUS_OK, including the CRC_A unless the MFRC522 removed it.
+														) {
+	// Sanity check
+	if (endPage < startPage || endPage - startPage >= FAST_READ_MAX_PAGES) {
+		return STATUS_INVALID;
+	}
+	const byte expected = (endPage - startPage + 1) * 4 + 2;
+	if (buffer == nullptr || *bufferSize < expected) {
+		return STATUS_NO_ROOM;
+	}
+	
+	// Build command buffer
+	buffer[0] = PICC_CMD_UL_FAST_READ;
+	buffer[1] = startPage;
+	buffer[2] = endPage;
+	byte sendLen = 3;
+	MFRC522::StatusCode result = PCD_AppendCRC(buffer, &sendLen);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	
+	// Transmit the buffer and receive the response, validate CRC_A.
+	// The answer takes about 90μs per page on the air, the receive timeout only runs until its first bit.
+	PCD_SetCommandTimeout(TIMEOUT_MIFARE);
+	result = PCD_TransceiveData(buffer, sendLen, buffer, bufferSize, nullptr, 0, true);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	// A NAK is reported as STATUS_MIFARE_NACK. The MFRC522 has removed the CRC_A if RxCRCEn is set.
+	if (*bufferSize != expected - (_hardwareCRC ? 2 : 0)) {
+		return STATUS_ERROR;
+	}
+	return STATUS_OK;
+} // End MIFARE_Ultralight_FastRead()
+
+/**
+ * Reads the version information of a NTAG21x or MIFARE Ultralight EV1 PICC.
+ * buffer[2] is the product type (0x03 Ultralight, 0x04 NTAG), buffer[6] the storage size:
+ * 0x0F for NTAG213, 0x11 for NTAG215 and 0x13 for NTAG216.
+ * Other PICCs do not know the command and go back to IDLE.
+ * 
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::MIFARE_Ultralight_GetVersion(	byte *buffer,		///< The buffer to store the 8 bytes in
+															byte *bufferSize	///< Buffer size, at least 10 bytes. Also number of bytes returned if STATUS_OK.
+														) {
+	// Sanity check
+	if (buffer == nullptr || *bufferSize < 10) {
+		return STATUS_NO_ROOM;
+	}
+	
+	buffer[0] = PICC_CMD_UL_GET_VERSION;
+	byte sendLen = 1;
+	MFRC522::StatusCode result = PCD_AppendCRC(buffer, &sendLen);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	PCD_SetCommandTimeout(TIMEOUT_MIFARE);
+	result = PCD_TransceiveData(buffer, sendLen, buffer, bufferSize, nullptr, 0, true);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	if (*bufferSize != (_hardwareCRC ? 8 : 10)) {
+		return STATUS_ERROR;
+	}
+	return STATUS_OK;
+} // End MIFARE_Ultralight_GetVersion()
+
 /**
  * MIFARE Decrement subtracts the delta from the value of the addressed block, and stores the result in a volatile memory.
  * For MIFARE Classic only. The sector containing the block must be authenticated before calling this function.
@@ -1131,7 +1937,7 @@ MFRC522::StatusCode MFRC522::MIFARE_Transfer(	byte blockAddr ///< The block (0-0
 	// Tell the PICC we want to transfer the result into block blockAddr.
 	cmdBuffer[0] = PICC_CMD_MF_TRANSFER;
 	cmdBuffer[1] = blockAddr;
-	result = PCD_MIFARE_Transceive(	cmdBuffer, 2); // Adds CRC_A and checks that the response is MF_ACK.
+	result = PCD_MIFARE_Transceive(	cmdBuffer, 2, false, TIMEOUT_MIFARE_WRITE); // Adds CRC_A and checks that the response is MF_ACK.
 	if (result != STATUS_OK) {
 		return result;
 	}
@@ -1198,37 +2004,34 @@ MFRC522::StatusCode MFRC522::MIFARE_SetValue(byte blockAddr, int32_t value) {
 /**
  * Authenticate with a NTAG216.
  * 
- * Only for NTAG216. First implemented by Gargantuanman.
+ * PWD_AUTH of NTAG213/215/216 and MIFARE Ultralight EV1. First implemented by Gargantuanman.
  * 
  * @param[in]   passWord   password.
- * @param[in]   pACK       result success???.
+ * @param[out]  pACK       2 byte password acknowledge (PACK) returned by the PICC.
  * @return STATUS_OK on success, STATUS_??? otherwise.
  */
 MFRC522::StatusCode MFRC522::PCD_NTAG216_AUTH(byte* passWord, byte pACK[]) //Authenticate with 32bit password
 {
-	// TODO: Fix cmdBuffer length and rxlength. They really should match.
-	//       (Better still, rxlength should not even be necessary.)
-
 	MFRC522::StatusCode result;
 	byte				cmdBuffer[18]; // We need room for 16 bytes data and 2 bytes CRC_A.
 	
-	cmdBuffer[0] = 0x1B; //Comando de autentificacion
+	cmdBuffer[0] = PICC_CMD_UL_PWD_AUTH; //Comando de autentificacion
 	
 	for (byte i = 0; i<4; i++)
 		cmdBuffer[i+1] = passWord[i];
 	
-	result = PCD_CalculateCRC(cmdBuffer, 5, &cmdBuffer[5]);
+	byte sendLen = 5;
+	result = PCD_AppendCRC(cmdBuffer, &sendLen);
 	
 	if (result!=STATUS_OK) {
 		return result;
 	}
 	
 	// Transceive the data, store the reply in cmdBuffer[]
-	byte waitIRq		= 0x30;	// RxIRq and IdleIRq
-//	byte cmdBufferSize	= sizeof(cmdBuffer);
-	byte validBits		= 0;
-	byte rxlength		= 5;
-	result = PCD_CommunicateWithPICC(PCD_Transceive, waitIRq, cmdBuffer, 7, cmdBuffer, &rxlength, &validBits);
+	// With the CRC_A check a wrong password (4 bit NAK) is STATUS_MIFARE_NACK instead of a garbled PACK.
+	byte rxlength		= sizeof(cmdBuffer);
+	PCD_SetCommandTimeout(TIMEOUT_MIFARE);
+	result = PCD_TransceiveData(cmdBuffer, sendLen, cmdBuffer, &rxlength, nullptr, 0, true);
 	
 	pACK[0] = cmdBuffer[0];
 	pACK[1] = cmdBuffer[1];
@@ -1253,44 +2056,687 @@ MFRC522::StatusCode MFRC522::PCD_NTAG216_AUTH(byte* passWord, byte pACK[]) //Aut
  */
 MFRC522::StatusCode MFRC522::PCD_MIFARE_Transceive(	byte *sendData,		///< Pointer to the data to transfer to the FIFO. Do NOT include the CRC_A.
 													byte sendLen,		///< Number of bytes in sendData.
-													bool acceptTimeout	///< True => A timeout is also success
+													bool acceptTimeout,	///< True => A timeout is also success
+													uint32_t timeoutMicros	///< Receive timeout in μs, TIMEOUT_MIFARE_WRITE for commands that write the EEPROM.
 												) {
-	MFRC522::StatusCode result;
-	byte cmdBuffer[18]; // We need room for 16 bytes data and 2 bytes CRC_A.
+	return PCD_Finish(PCD_StartMifareTransceive(sendData, sendLen, acceptTimeout, timeoutMicros));
+} // End PCD_MIFARE_Transceive()
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Non-blocking commands
+/////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Starts REQA or WUPA without waiting for the ATQA. See PICC_REQA_or_WUPA().
+ * bufferATQA and bufferSize must stay valid until PCD_Poll() returns the result.
+ * 
+ * @return STATUS_PENDING if the command was started, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PICC_StartREQA_or_WUPA(	byte command, 		///< The command to send - PICC_CMD_REQA or PICC_CMD_WUPA
+														byte *bufferATQA,	///< The buffer to store the ATQA (Answer to request) in
+														byte *bufferSize	///< Buffer size, at least two bytes. Also number of bytes returned if STATUS_OK.
+													) {
+	if (bufferATQA == nullptr || *bufferSize < 2) {	// The ATQA response is 2 bytes long.
+		return STATUS_NO_ROOM;
+	}
+	if (!PCD_AsyncBegin(ASYNC_REQA_OR_WUPA)) {
+		return STATUS_INTERNAL_ERROR;
+	}
+	PCD_SetHardwareCRC(false);						// Short frames and the ATQA carry no CRC_A.
+	PCD_ClearRegisterBitMask(CollReg, 0x80);		// ValuesAfterColl=1 => Bits received after collision are cleared.
+	_async.frame[0] = command;
+	_async.validBits = 7;							// For REQA and WUPA we need the short frame format - transmit only 7 bits of the last (and only) byte. TxLastBits = BitFramingReg[2..0]
+	_async.data = bufferATQA;
+	_async.dataSize = bufferSize;
+	PCD_SetCommandTimeout(TIMEOUT_ACTIVATION);
+	return PCD_StartCommunication(PCD_Transceive, 0x30, _async.frame, 1, bufferATQA, bufferSize, &_async.validBits);
+} // End PICC_StartREQA_or_WUPA()
+
+/**
+ * Starts the REQA of PICC_IsNewCardPresent() without waiting.
+ * PCD_Poll() returns STATUS_OK or STATUS_COLLISION if a PICC in state IDLE answered.
+ * 
+ * @return STATUS_PENDING if the command was started, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PICC_StartIsNewCardPresent() {
+	if (PCD_IsBusy()) {
+		return STATUS_INTERNAL_ERROR;
+	}
+	PCD_ResetModulation();
+	// The ATQA is not passed on, it lands at the end of the frame buffer.
+	_async.replyLength = 2;
+	return PICC_StartREQA_or_WUPA(PICC_CMD_REQA, _async.frame + sizeof(_async.frame) - 2, &_async.replyLength);
+} // End PICC_StartIsNewCardPresent()
+
+/**
+ * Starts HLTA without waiting. See PICC_HaltA().
+ * 
+ * @return STATUS_PENDING if the command was started, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PICC_StartHaltA() {
+	if (!PCD_AsyncBegin(ASYNC_HALT)) {
+		return STATUS_INTERNAL_ERROR;
+	}
+	_async.frame[0] = PICC_CMD_HLTA;
+	_async.frame[1] = 0;
+	_async.frameLength = 2;
+	MFRC522::StatusCode result = PCD_AppendCRC(_async.frame, &_async.frameLength);
+	if (result != STATUS_OK) {
+		return PCD_AsyncDone(result);
+	}
+	// The standard says:
+	//		If the PICC responds with any modulation during a period of 1 ms after the end of the frame containing the
+	//		HLTA command, this response shall be interpreted as 'not acknowledge'.
+	// We interpret that this way: Only STATUS_TIMEOUT is a success.
+	// The timer is set to that 1 ms, instead of waiting the default 25 ms for an answer that never comes.
+	PCD_SetCommandTimeout(TIMEOUT_HLTA);
+	return PCD_StartCommunication(PCD_Transceive, 0x30, _async.frame, _async.frameLength);
+} // End PICC_StartHaltA()
+
+/**
+ * Starts the MFAuthent command without waiting. See PCD_Authenticate().
+ * The key and UID are copied, they need not stay valid.
+ * 
+ * @return STATUS_PENDING if the command was started, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PCD_StartAuthenticate(	byte command,		///< PICC_CMD_MF_AUTH_KEY_A or PICC_CMD_MF_AUTH_KEY_B
+													byte blockAddr, 	///< The block number. See numbering in the comments in the .h file.
+													MIFARE_Key *key,	///< Pointer to the Crypteo1 key to use (6 bytes)
+													Uid *uid			///< Pointer to Uid struct. The first 4 bytes of the UID is used.
+												) {
+	if (!PCD_AsyncBegin(ASYNC_AUTHENTICATE)) {
+		return STATUS_INTERNAL_ERROR;
+	}
+	byte waitIRq = 0x10;		// IdleIRq
+	
+	// Build command buffer
+	byte *sendData = _async.frame;
+	sendData[0] = command;
+	sendData[1] = blockAddr;
+	for (byte i = 0; i < MF_KEY_SIZE; i++) {	// 6 key bytes
+		sendData[2+i] = key->keyByte[i];
+	}
+	// Use the last uid bytes as specified in http://cache.nxp.com/documents/application_note/AN10927.pdf
+	// section 3.2.5 "MIFARE Classic Authentication".
+	// The only missed case is the MF1Sxxxx shortcut activation,
+	// but it requires cascade tag (CT) byte, that is not part of uid.
+	for (byte i = 0; i < 4; i++) {				// The last 4 bytes of the UID
+		sendData[8+i] = uid->uidByte[i+uid->size-4];
+	}
 	
+	// Start the authentication.
+	PCD_SetCommandTimeout(TIMEOUT_MIFARE);
+	return PCD_StartCommunication(PCD_MFAuthent, waitIRq, sendData, 12);
+} // End PCD_StartAuthenticate()
+
+/**
+ * Starts a MIFARE read without waiting. See MIFARE_Read().
+ * buffer and bufferSize must stay valid until PCD_Poll() returns the result.
+ * 
+ * @return STATUS_PENDING if the command was started, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::MIFARE_StartRead(	byte blockAddr, 	///< MIFARE Classic: The block (0-0xff) number. MIFARE Ultralight: The first page to return data from.
+												byte *buffer,		///< The buffer to store the data in
+												byte *bufferSize	///< Buffer size, at least 18 bytes. Also number of bytes returned if STATUS_OK.
+											) {
+	// Sanity check
+	if (buffer == nullptr || *bufferSize < 18) {
+		return STATUS_NO_ROOM;
+	}
+	if (!PCD_AsyncBegin(ASYNC_READ)) {
+		return STATUS_INTERNAL_ERROR;
+	}
+	
+	// Build command buffer
+	buffer[0] = PICC_CMD_MF_READ;
+	buffer[1] = blockAddr;
+	byte sendLen = 2;
+	// Add CRC_A
+	MFRC522::StatusCode result = PCD_AppendCRC(buffer, &sendLen);
+	if (result != STATUS_OK) {
+		return PCD_AsyncDone(result);
+	}
+	
+	// Transmit the buffer and receive the response, validate CRC_A.
+	PCD_SetCommandTimeout(TIMEOUT_MIFARE);
+	return PCD_StartCommunication(PCD_Transceive, 0x30, buffer, sendLen, buffer, bufferSize, nullptr, 0, true);
+} // End MIFARE_StartRead()
+
+/**
+ * Starts a MIFARE write without waiting. See MIFARE_Write().
+ * Both steps of the write run from PCD_Poll(). buffer must stay valid until PCD_Poll() returns the result.
+ * 
+ * @return STATUS_PENDING if the command was started, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::MIFARE_StartWrite(	byte blockAddr, ///< MIFARE Classic: The block (0-0xff) number. MIFARE Ultralight: The page (2-15) to write to.
+												byte *buffer,	///< The 16 bytes to write to the PICC
+												byte bufferSize	///< Buffer size, must be at least 16 bytes. Exactly 16 bytes are written.
+											) {
+	// Sanity check
+	if (buffer == nullptr || bufferSize < 16) {
+		return STATUS_INVALID;
+	}
+	if (!PCD_AsyncBegin(ASYNC_WRITE)) {
+		return STATUS_INTERNAL_ERROR;
+	}
+	
+	// Mifare Classic protocol requires two communications to perform a write.
+	// Step 1: Tell the PICC we want to write to block blockAddr. Step 2 follows in PCD_AsyncStep().
+	_async.frame[0] = PICC_CMD_MF_WRITE;
+	_async.frame[1] = blockAddr;
+	_async.frameLength = 2;
+	_async.data = buffer;
+	_async.acceptTimeout = false;
+	MFRC522::StatusCode result = PCD_StartMifareFrame(TIMEOUT_MIFARE);
+	return (result == STATUS_PENDING) ? result : PCD_AsyncDone(result);
+} // End MIFARE_StartWrite()
+
+/**
+ * Starts a MIFARE command that is answered with a 4 bit ACK, without waiting. See PCD_MIFARE_Transceive().
+ * sendData is copied, it need not stay valid.
+ * 
+ * @return STATUS_PENDING if the command was started, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PCD_StartMifareTransceive(	byte *sendData,		///< Pointer to the data to transfer to the FIFO. Do NOT include the CRC_A.
+														byte sendLen,		///< Number of bytes in sendData.
+														bool acceptTimeout,	///< True => A timeout is also success
+														uint32_t timeoutMicros	///< Receive timeout in μs, TIMEOUT_MIFARE_WRITE for commands that write the EEPROM.
+													) {
 	// Sanity check
 	if (sendData == nullptr || sendLen > 16) {
 		return STATUS_INVALID;
 	}
+	if (!PCD_AsyncBegin(ASYNC_MIFARE_TRANSCEIVE)) {
+		return STATUS_INTERNAL_ERROR;
+	}
+	memcpy(_async.frame, sendData, sendLen);
+	_async.frameLength = sendLen;
+	_async.acceptTimeout = acceptTimeout;
+	MFRC522::StatusCode result = PCD_StartMifareFrame(timeoutMicros);
+	return (result == STATUS_PENDING) ? result : PCD_AsyncDone(result);
+} // End PCD_StartMifareTransceive()
+
+/**
+ * Runs the command started by one of the non-blocking functions: PICC_StartREQA_or_WUPA(), PICC_StartHaltA(),
+ * PCD_StartAuthenticate(), MIFARE_StartRead(), MIFARE_StartWrite() or PCD_StartMifareTransceive().
+ * Each call does at most a few register accesses and returns, multi-step commands move on to their next step.
+ * Call it from loop() until it stops returning STATUS_PENDING. The callback set with PCD_SetCompletionCallback()
+ * is called with the same result just before.
+ * Do not call other functions that talk to the MFRC522 while a command is pending.
+ * 
+ * @return STATUS_PENDING while the command runs, then its result. The result of the last command if none is running.
+ */
+MFRC522::StatusCode MFRC522::PCD_Poll() {
+	if (_async.command == ASYNC_IDLE) {
+		return _async.result;
+	}
+	MFRC522::StatusCode result = PCD_PollCommunication();
+	if (result == STATUS_PENDING) {
+		return STATUS_PENDING;
+	}
+	result = PCD_AsyncStep(result);
+	if (result == STATUS_PENDING) {
+		return STATUS_PENDING;
+	}
+	return PCD_AsyncDone(result);
+} // End PCD_Poll()
+
+/**
+ * Returns true while a command started by one of the non-blocking functions runs.
+ */
+bool MFRC522::PCD_IsBusy() const {
+	return _async.command != ASYNC_IDLE;
+} // End PCD_IsBusy()
+
+/**
+ * Stops the command started by one of the non-blocking functions, eg when the sketch no longer needs its result.
+ * The MFRC522 goes idle, the callback is not called. Crypto1 stays on if an authentication had already completed.
+ */
+void MFRC522::PCD_Abort() {
+	if (_async.command == ASYNC_IDLE) {
+		return;
+	}
+	PCD_WriteRegister(CommandReg, PCD_Idle);	// Stop any active command.
+	_async.command = ASYNC_IDLE;
+} // End PCD_Abort()
+
+/**
+ * Sets the function PCD_Poll() calls when a non-blocking command completes, or nullptr for none.
+ * It is not called for the blocking functions.
+ */
+void MFRC522::PCD_SetCompletionCallback(	CompletionCallback callback,	///< Called with this instance, the result and context.
+											void *context					///< Passed to callback unchanged.
+										) {
+	_async.callback = callback;
+	_async.context = context;
+} // End PCD_SetCompletionCallback()
+
+#ifdef MFRC522_TELEMETRY
+/////////////////////////////////////////////////////////////////////////////////////
+// Telemetry
+/////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Sets all telemetry counters to zero.
+ */
+void MFRC522::PCD_ResetTelemetry() {
+	memset(&_telemetry, 0, sizeof(_telemetry));
+} // End PCD_ResetTelemetry()
+
+/**
+ * Adds a finished command to the telemetry counters.
+ * Commands aborted with PCD_Abort() and Start functions that reject their arguments are not counted.
+ * 
+ * @return result
+ */
+MFRC522::StatusCode MFRC522::PCD_TelemetryRecord(	byte command,				///< One of the TelemetryCommand values.
+													const TelemetryMark &mark,	///< From PCD_TelemetryMark() when the command started.
+													StatusCode result			///< The result of the command.
+												) {
+	TelemetryCounters &counters = _telemetry.commands[command];
+	uint32_t elapsed = (uint32_t)micros() - mark.micros;
+	counters.calls++;
+	counters.spiBytes += _telemetry.spiBytes - mark.spiBytes;
+	counters.totalMicros += elapsed;
 	
-	// Copy sendData[] to cmdBuffer[] and add CRC_A
-	memcpy(cmdBuffer, sendData, sendLen);
-	result = PCD_CalculateCRC(cmdBuffer, sendLen, &cmdBuffer[sendLen]);
-	if (result != STATUS_OK) { 
+	const byte status = (result <= STATUS_CRC_WRONG) ? (byte)result : TELEMETRY_STATUSES - 1;
+	if (counters.results[status] != UINT16_MAX) {
+		counters.results[status]++;
+	}
+	byte bucket = 0;
+	while (elapsed > 1 && bucket < TELEMETRY_BUCKETS - 1) {
+		elapsed >>= 1;
+		bucket++;
+	}
+	if (counters.histogram[bucket] != UINT16_MAX) {
+		counters.histogram[bucket]++;
+	}
+	return result;
+} // End PCD_TelemetryRecord()
+
+/**
+ * Dumps the telemetry counters to Serial as CSV, one line per command class after a header line.
+ * total_us and spi_bytes are sums over all calls, h0..h15 the latency histogram, see TELEMETRY_BUCKETS.
+ */
+void MFRC522::PCD_DumpTelemetryToSerial() {
+	Serial.print(F("command,calls,ok,error,collision,timeout,no_room,internal,invalid,crc,nack,spi_bytes,total_us"));
+	for (byte i = 0; i < TELEMETRY_BUCKETS; i++) {
+		Serial.print(F(",h"));
+		Serial.print(i);
+	}
+	Serial.println();
+	for (byte command = 0; command < TELEMETRY_COMMANDS; command++) {
+		const TelemetryCounters &counters = _telemetry.commands[command];
+		switch (command) {
+			case TELEMETRY_REQA:	Serial.print(F("reqa"));	break;
+			case TELEMETRY_SELECT:	Serial.print(F("select"));	break;
+			case TELEMETRY_AUTH:	Serial.print(F("auth"));	break;
+			case TELEMETRY_READ:	Serial.print(F("read"));	break;
+			case TELEMETRY_WRITE:	Serial.print(F("write"));	break;
+			case TELEMETRY_HALT:	Serial.print(F("halt"));	break;
+			default:				Serial.print(F("crc"));		break;
+		}
+		Serial.print(',');
+		Serial.print(counters.calls);
+		for (byte i = 0; i < TELEMETRY_STATUSES; i++) {
+			Serial.print(',');
+			Serial.print(counters.results[i]);
+		}
+		Serial.print(',');
+		Serial.print(counters.spiBytes);
+		Serial.print(',');
+		Serial.print(counters.totalMicros);
+		for (byte i = 0; i < TELEMETRY_BUCKETS; i++) {
+			Serial.print(',');
+			Serial.print(counters.histogram[i]);
+		}
+		Serial.println();
+	}
+} // End PCD_DumpTelemetryToSerial()
+#endif
+
+/**
+ * Completes a command started by one of the non-blocking functions, for their blocking counterparts.
+ * Waits like PCD_CommunicateWithPICC(): on the IRQ pin if enabled, busy-polling otherwise.
+ * 
+ * @return The result of the command. started itself if it is not STATUS_PENDING.
+ */
+MFRC522::StatusCode MFRC522::PCD_Finish(	StatusCode started	///< The return value of the Start function.
+										) {
+	if (started != STATUS_PENDING) {
+		return started;
+	}
+	const CompletionCallback callback = _async.callback;
+	_async.callback = nullptr;
+	MFRC522::StatusCode result;
+	while ((result = PCD_Poll()) == STATUS_PENDING) {
+		PCD_WaitForPoll();
+	}
+	_async.callback = callback;
+	return result;
+} // End PCD_Finish()
+
+/**
+ * Claims the non-blocking command state.
+ * 
+ * @return false if another command is still pending.
+ */
+bool MFRC522::PCD_AsyncBegin(	byte command	///< One of the PCD_AsyncCommand values.
+							) {
+	if (_async.command != ASYNC_IDLE) {
+		return false;
+	}
+	_async.command = command;
+	_async.step = 0;
+#ifdef MFRC522_TELEMETRY
+	_async.telemetry = PCD_TelemetryMark();
+#endif
+	return true;
+} // End PCD_AsyncBegin()
+
+/**
+ * Ends the running non-blocking command and reports its result.
+ * 
+ * @return result
+ */
+MFRC522::StatusCode MFRC522::PCD_AsyncDone(	StatusCode result	///< The result of the command.
+										) {
+#ifdef MFRC522_TELEMETRY
+	// Indexed by PCD_AsyncCommand. TELEMETRY_COMMANDS: not counted.
+	static const byte telemetryCommands[] = {
+		TELEMETRY_COMMANDS, TELEMETRY_REQA, TELEMETRY_HALT, TELEMETRY_AUTH, TELEMETRY_READ, TELEMETRY_COMMANDS, TELEMETRY_WRITE
+	};
+	if (_async.command < sizeof(telemetryCommands) && telemetryCommands[_async.command] != TELEMETRY_COMMANDS) {
+		PCD_TelemetryRecord(telemetryCommands[_async.command], _async.telemetry, result);
+	}
+#endif
+	_async.command = ASYNC_IDLE;
+	_async.result = result;
+	if (_async.callback) {
+		_async.callback(this, result, _async.context);
+	}
+	return result;
+} // End PCD_AsyncDone()
+
+/**
+ * Sends _async.frame with CRC_A and expects a 4 bit MIFARE ACK in return, see PCD_AsyncMifareAck().
+ * The command is not ended on failure, the caller does that: a Start function or PCD_Poll().
+ * 
+ * @return STATUS_PENDING if the frame is on its way, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PCD_StartMifareFrame(	uint32_t timeoutMicros	///< Receive timeout in μs.
+												) {
+	MFRC522::StatusCode result = PCD_AppendCRC(_async.frame, &_async.frameLength);
+	if (result != STATUS_OK) {
 		return result;
 	}
-	sendLen += 2;
-	
-	// Transceive the data, store the reply in cmdBuffer[]
-	byte waitIRq = 0x30;		// RxIRq and IdleIRq
-	byte cmdBufferSize = sizeof(cmdBuffer);
-	byte validBits = 0;
-	result = PCD_CommunicateWithPICC(PCD_Transceive, waitIRq, cmdBuffer, sendLen, cmdBuffer, &cmdBufferSize, &validBits);
-	if (acceptTimeout && result == STATUS_TIMEOUT) {
+	// Transceive the data, store the reply in _async.frame
+	_async.replyLength = sizeof(_async.frame);
+	_async.validBits = 0;
+	PCD_SetCommandTimeout(timeoutMicros);
+	return PCD_StartCommunication(PCD_Transceive, 0x30, _async.frame, _async.frameLength, _async.frame, &_async.replyLength, &_async.validBits);
+} // End PCD_StartMifareFrame()
+
+/**
+ * Checks the reply to a frame sent with PCD_StartMifareFrame().
+ * 
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PCD_AsyncMifareAck(	StatusCode result	///< The result of the transceive.
+												) {
+	if (_async.acceptTimeout && result == STATUS_TIMEOUT) {
 		return STATUS_OK;
 	}
 	if (result != STATUS_OK) {
 		return result;
 	}
 	// The PICC must reply with a 4 bit ACK
-	if (cmdBufferSize != 1 || validBits != 4) {
+	if (_async.replyLength != 1 || _async.validBits != 4) {
 		return STATUS_ERROR;
 	}
-	if (cmdBuffer[0] != MF_ACK) {
+	if (_async.frame[0] != MF_ACK) {
 		return STATUS_MIFARE_NACK;
 	}
 	return STATUS_OK;
-} // End PCD_MIFARE_Transceive()
+} // End PCD_AsyncMifareAck()
+
+/**
+ * Evaluates the completed step of the running non-blocking command and starts its next step, if any.
+ * 
+ * @return STATUS_PENDING if another step was started, otherwise the result of the command.
+ */
+MFRC522::StatusCode MFRC522::PCD_AsyncStep(	StatusCode result	///< The result of the step's PCD_PollCommunication().
+										) {
+	switch (_async.command) {
+		case ASYNC_REQA_OR_WUPA:
+			if (result != STATUS_OK) {
+				return result;
+			}
+			if (*_async.dataSize != 2 || _async.validBits != 0) {		// ATQA must be exactly 16 bits.
+				return STATUS_ERROR;
+			}
+			return STATUS_OK;
+		
+		case ASYNC_HALT:
+			if (result == STATUS_TIMEOUT) {
+				return STATUS_OK;
+			}
+			if (result == STATUS_OK) { // That is ironically NOT ok in this case ;-)
+				return STATUS_ERROR;
+			}
+			return result;
+		
+		case ASYNC_MIFARE_TRANSCEIVE:
+			return PCD_AsyncMifareAck(result);
+		
+		case ASYNC_WRITE:
+			result = PCD_AsyncMifareAck(result);
+			if (result != STATUS_OK || _async.step == 1) {
+				return result;
+			}
+			// Step 2: Transfer the data
+			_async.step = 1;
+			memcpy(_async.frame, _async.data, 16);
+			_async.frameLength = 16;
+			return PCD_StartMifareFrame(TIMEOUT_MIFARE_WRITE);
+		
+		default:	// ASYNC_AUTHENTICATE, ASYNC_READ: the transceive result is the result.
+			return result;
+	}
+} // End PCD_AsyncStep()
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Inventory helpers
+/////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Sends one ANTICOLLISION frame with the known bits of the current cascade level and merges the answer.
+ * 
+ * @return STATUS_OK with all 40 bits (UID CLn and BCC) known, STATUS_COLLISION if PICCs disagree, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PICC_Anticollision(	byte command,		///< PICC_CMD_SEL_CL1, PICC_CMD_SEL_CL2 or PICC_CMD_SEL_CL3
+													byte *uidCl,		///< In: the known bits. Out: the known bits and the ones received. 5 bytes.
+													byte *knownBits		///< In: number of known bits, 0-31. Out: number of valid bits; with STATUS_COLLISION the next bit collided.
+												) {
+	byte buffer[9];					// SEL + NVB + UID CLn + BCC, room for the unused CRC_A
+	const byte wholeBytes = *knownBits / 8;
+	byte txLastBits = *knownBits % 8;
+	const byte index = 2 + wholeBytes;	// Number of whole bytes: SEL + NVB + UIDs
+	
+	buffer[0] = command;
+	buffer[1] = (index << 4) + txLastBits;		// NVB - Number of Valid Bits
+	memcpy(&buffer[2], uidCl, 5);
+	byte responseLength = sizeof(buffer) - index;
+	
+	PCD_SetHardwareCRC(false);					// Anticollision frames carry no CRC_A.
+	PCD_SetCommandTimeout(TIMEOUT_ACTIVATION);
+	// The answer starts in the middle of the byte with the last known bit, rxAlign merges it there.
+	MFRC522::StatusCode result = PCD_TransceiveData(buffer, index + (txLastBits ? 1 : 0), &buffer[index], &responseLength, &txLastBits, *knownBits % 8);
+	if (result == STATUS_COLLISION) {
+		byte valueOfCollReg = PCD_ReadRegister(CollReg); // CollReg[7..0] bits are: ValuesAfterColl reserved CollPosNotValid CollPos[4:0]
+		if (valueOfCollReg & 0x20) { // CollPosNotValid
+			return STATUS_COLLISION;
+		}
+		byte collisionPos = valueOfCollReg & 0x1F; // Values 0-31, 0 means bit 32. Counted from the first bit of the received frame's first byte.
+		if (collisionPos == 0) {
+			collisionPos = 32;
+		}
+		const byte validBits = wholeBytes * 8 + collisionPos - 1;
+		if (validBits < *knownBits || validBits >= 32) {
+			return STATUS_INTERNAL_ERROR;
+		}
+		memcpy(uidCl, &buffer[2], 5);
+		*knownBits = validBits;
+		return STATUS_COLLISION;
+	}
+	if (result != STATUS_OK) {
+		return result;
+	}
+	memcpy(uidCl, &buffer[2], 5);
+	if ((uidCl[0] ^ uidCl[1] ^ uidCl[2] ^ uidCl[3]) != uidCl[4]) {
+		return STATUS_ERROR;
+	}
+	*knownBits = 40;
+	return STATUS_OK;
+} // End PICC_Anticollision()
+
+/**
+ * Sends the SELECT for a complete UID CLn. Only the matching PICC answers and moves on, the others go back to IDLE.
+ * 
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PICC_SelectLevel(	byte command,		///< PICC_CMD_SEL_CL1, PICC_CMD_SEL_CL2 or PICC_CMD_SEL_CL3
+												const byte *uidCl,	///< UID CLn and BCC, 5 bytes.
+												byte *sak			///< Out: the SAK.
+											) {
+	byte buffer[9];
+	byte bufferUsed = 7;
+	buffer[0] = command;
+	buffer[1] = 0x70;		// NVB - Number of Valid Bits: Seven whole bytes
+	memcpy(&buffer[2], uidCl, 5);
+	MFRC522::StatusCode result = PCD_AppendCRC(buffer, &bufferUsed);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	byte responseLength = 3;
+	byte validBits = 0;
+	PCD_SetCommandTimeout(TIMEOUT_ACTIVATION);
+	result = PCD_TransceiveData(buffer, bufferUsed, &buffer[6], &responseLength, &validBits, 0, true);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	if (responseLength != (_hardwareCRC ? 1 : 3) || validBits != 0) { // SAK must be exactly 24 bits (1 byte + CRC_A)
+		return STATUS_ERROR;
+	}
+	*sak = buffer[6];
+	return STATUS_OK;
+} // End PICC_SelectLevel()
+
+/**
+ * Wakes up the PICCs that went back to IDLE during the walk and selects them down to cascade level.
+ * 
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PICC_InventoryReactivate(	byte cascadeLevel,	///< The level the walk continues on, 1-3.
+														const Uid *path		///< UID bytes of the cascade levels above.
+													) {
+	byte bufferATQA[2];
+	byte bufferSize = sizeof(bufferATQA);
+	MFRC522::StatusCode result = PICC_RequestA(bufferATQA, &bufferSize);
+	if (result != STATUS_OK && result != STATUS_COLLISION) {
+		return result;
+	}
+	for (byte level = 1; level < cascadeLevel; level++) {
+		byte uidCl[5] = { PICC_CMD_CT, path->uidByte[level * 3 - 3], path->uidByte[level * 3 - 2], path->uidByte[level * 3 - 1] };
+		uidCl[4] = uidCl[0] ^ uidCl[1] ^ uidCl[2] ^ uidCl[3];
+		byte sak;
+		result = PICC_SelectLevel(PICC_CMD_SEL_CL1 + 2 * (level - 1), uidCl, &sak);
+		if (result != STATUS_OK) {
+			return result;
+		}
+	}
+	return STATUS_OK;
+} // End PICC_InventoryReactivate()
+
+/**
+ * Walks the anticollision tree of one cascade level, see PICC_Inventory(). The PICCs of the level must be in READY.
+ * Collisions where the 0 branch was taken are kept as bits in a 32 bit mask, the walk backtracks to the deepest one.
+ * 
+ * @return STATUS_OK on success, STATUS_NO_ROOM if uids is full, STATUS_??? otherwise: the first error of a skipped
+ * branch once the others are walked, or at once if the PICCs cannot be woken up again.
+ */
+MFRC522::StatusCode MFRC522::PICC_InventoryLevel(	byte cascadeLevel,	///< 1-3
+													Uid *path,			///< In: UID bytes of the cascade levels above. Used as scratch below.
+													Uid *uids,			///< Array to append the UIDs to
+													byte capacity,		///< Number of entries in uids
+													byte *count			///< In/Out: the number of UIDs in uids
+												) {
+	const byte command = PICC_CMD_SEL_CL1 + 2 * (cascadeLevel - 1);
+	const byte uidIndex = 3 * (cascadeLevel - 1);	// The first index in uid->uidByte[] that is used in this cascade level.
+	byte uidCl[5] = { 0 };
+	byte knownBits = 0;
+	uint32_t pending = 0;	// Bit n set => the 1 branch at bit n of UID CLn is still to be walked.
+	MFRC522::StatusCode result;
+	MFRC522::StatusCode skipped = STATUS_OK;	// Error of the first branch that could not be walked
+	
+	for (;;) {
+		result = PICC_Anticollision(command, uidCl, &knownBits);
+		if (result == STATUS_COLLISION && knownBits < 32) {
+			// Take the 0 branch and come back for the 1 branch.
+			uidCl[knownBits / 8] &= ~(1 << (knownBits % 8));
+			pending |= (uint32_t)1 << knownBits;
+			knownBits++;
+			continue;
+		}
+		if (result == STATUS_OK) {
+			if (uidCl[0] == PICC_CMD_CT && cascadeLevel < 3) {
+				// A longer UID: select this branch and walk the next level.
+				byte sak;
+				memcpy(&path->uidByte[uidIndex], &uidCl[1], 3);
+				result = PICC_SelectLevel(command, uidCl, &sak);
+				if (result == STATUS_OK) {
+					result = PICC_InventoryLevel(cascadeLevel + 1, path, uids, capacity, count);
+				}
+				if (result == STATUS_NO_ROOM) {
+					return result;
+				}
+				if (result != STATUS_OK && skipped == STATUS_OK) {
+					skipped = result;
+				}
+				if (pending) {
+					result = PICC_InventoryReactivate(cascadeLevel, path);
+					if (result != STATUS_OK) {		// The other branches are out of reach
+						return result;
+					}
+				}
+			}
+			else {
+				if (*count == capacity) {
+					return STATUS_NO_ROOM;
+				}
+				Uid *uid = &uids[(*count)++];
+				memcpy(uid->uidByte, path->uidByte, uidIndex);
+				memcpy(&uid->uidByte[uidIndex], uidCl, 4);
+				uid->size = uidIndex + 4;
+				uid->sak = 0;
+			}
+		}
+		else if (result != STATUS_TIMEOUT) {	// A timeout is an empty branch, eg the PICC left the field.
+			return result;
+		}
+		if (!pending) {
+			return skipped;
+		}
+		// Backtrack to the deepest collision and take its 1 branch.
+		knownBits = 31;
+		while (!(pending & ((uint32_t)1 << knownBits))) {
+			knownBits--;
+		}
+		pending &= ~((uint32_t)1 << knownBits);
+		uidCl[knownBits / 8] |= 1 << (knownBits % 8);
+		knownBits++;
+	}
+} // End PICC_InventoryLevel()
 
 /**
  * Returns a __FlashStringHelper pointer to a status code name.
@@ -1308,6 +2754,7 @@ const __FlashStringHelper *MFRC522::GetStatusCodeName(MFRC522::StatusCode code	/
 		case STATUS_INTERNAL_ERROR:	return F("Internal error in the code. Should not happen.");
 		case STATUS_INVALID:		return F("Invalid argument.");
 		case STATUS_CRC_WRONG:		return F("The CRC_A does not match.");
+		case STATUS_PENDING:		return F("Command still running.");
 		case STATUS_MIFARE_NACK:	return F("A MIFARE PICC responded with NAK.");
 		default:					return F("Unknown error");
 	}
@@ -1926,11 +3373,7 @@ bool MFRC522::PICC_IsNewCardPresent() {
 	byte bufferATQA[2];
 	byte bufferSize = sizeof(bufferATQA);
 
-	// Reset baud rates
-	PCD_WriteRegister(TxModeReg, 0x00);
-	PCD_WriteRegister(RxModeReg, 0x00);
-	// Reset ModWidthReg
-	PCD_WriteRegister(ModWidthReg, 0x26);
+	PCD_ResetModulation();
 
 	MFRC522::StatusCode result = PICC_RequestA(bufferATQA, &bufferSize);
 	return (result == STATUS_OK || result == STATUS_COLLISION);
@@ -22,6 +22,40 @@
 #define MFRC522_SPICLOCK (4000000u)	// MFRC522 accept upto 10MHz, set to 4MHz.
 #endif
 
+// MFRC522_TRANSPORT selects the host interface at compile time, see MFRC522Transport.h:
+// MFRC522_TRANSPORT_SPI (default) or MFRC522_TRANSPORT_SPI_FAST.
+#include "MFRC522Transport.h"
+
+// How CRC_A is generated and checked for PICC frames:
+//   MFRC522_CRC_COPROCESSOR - CalcCRC command of the MFRC522, a FIFO round trip per CRC (default, original behaviour)
+//   MFRC522_CRC_TABLE       - 256 entry table in flash, computed on the MCU without SPI traffic
+//   MFRC522_CRC_HARDWARE    - TxCRCEn/RxCRCEn stay enabled from SELECT until the next REQA/WUPA; responses are returned without CRC_A
+#define MFRC522_CRC_COPROCESSOR	0
+#define MFRC522_CRC_TABLE		1
+#define MFRC522_CRC_HARDWARE	2
+#ifndef MFRC522_CRC_MODE
+#define MFRC522_CRC_MODE MFRC522_CRC_COPROCESSOR
+#endif
+
+// Define MFRC522_SHADOW_REGISTERS to keep a copy of the configuration registers the driver owns
+// (BitFramingReg, CollReg, TxModeReg, RxModeReg, ModWidthReg, TModeReg, Status2Reg).
+// PCD_SetRegisterBitMask()/PCD_ClearRegisterBitMask() on them become single writes and writes of the value
+// a register already holds are dropped. Do not use it if anything else writes these registers, eg a second bus master.
+
+// Define MFRC522_IRQ_SLEEP to put an AVR into idle sleep, instead of calling yield(), while waiting for the IRQ pin.
+// Only has an effect after PCD_EnableIrqPin().
+
+// Define MFRC522_TELEMETRY to count calls, results, latency and SPI bytes per command class (REQA/WUPA, SELECT,
+// authentication, READ, WRITE, HLTA, CRC), see PCD_GetTelemetry() and PCD_DumpTelemetryToSerial().
+// Costs about 440 bytes of RAM and a micros() call at the start and end of every counted command.
+#ifdef MFRC522_TELEMETRY
+#define MFRC522_TELEMETRY_BEGIN()				const TelemetryMark _telemetryMark = PCD_TelemetryMark()
+#define MFRC522_TELEMETRY_END(command, result)	PCD_TelemetryRecord((command), _telemetryMark, (result))
+#else
+#define MFRC522_TELEMETRY_BEGIN()
+#define MFRC522_TELEMETRY_END(command, result)	(result)
+#endif
+
 // Firmware data for self-test
 // Reference values based on firmware version
 // Hint: if needed, you can remove unused self-test data to save flash memory
@@ -79,8 +113,21 @@ class MFRC522 {
 public:
 	// Size of the MFRC522 FIFO
 	static constexpr byte FIFO_SIZE = 64;		// The FIFO is 64 bytes.
+	// Pages per MIFARE_Ultralight_FastRead(): the answer and its CRC_A must fit into the FIFO.
+	static constexpr byte FAST_READ_MAX_PAGES = (FIFO_SIZE - 2) / 4;
+	// WaterLevelReg for PCD_TransceiveStream(): refill at LoAlert (FIFO level <= 16), drain at HiAlert (free space <= 16).
+	static constexpr byte STREAM_WATER_LEVEL = 16;
 	// Default value for unused pin
 	static constexpr uint8_t UNUSED_PIN = UINT8_MAX;
+	// Number of MFRC522 instances that can use PCD_EnableIrqPin() at the same time
+	static constexpr byte IRQ_SLOTS = 4;
+	// Receive timeouts in μs per command class. The MFRC522 timer starts at the end of the transmission.
+	static constexpr uint32_t TIMEOUT_DEFAULT			= 25000;	// Set by PCD_Init(), used by commands without a class below.
+	static constexpr uint32_t TIMEOUT_ACTIVATION		= 300;		// REQA, WUPA, ANTICOLLISION, SELECT. The PICC answers after a fixed 1236/fc (91μs), ISO/IEC 14443-3 6.2.1.1.
+	static constexpr uint32_t TIMEOUT_HLTA				= 1000;		// ISO/IEC 14443-3 6.4.3: any answer within 1ms after HLTA is a NAK.
+	static constexpr uint32_t TIMEOUT_MIFARE			= 5000;		// MIFARE READ, authentication and the first step of WRITE and value commands.
+	static constexpr uint32_t TIMEOUT_MIFARE_WRITE		= 10000;	// MIFARE WRITE and TRANSFER, the ACK follows the EEPROM write.
+	static constexpr uint32_t TIMEOUT_ISO_DEP_ACTIVATION	= 5000;		// RATS and PPS: FWT_ACTIVATION = 65536/fc (4.8ms), ISO/IEC 14443-4 5.7.
 
 	// MFRC522 registers. Described in chapter 9 of the datasheet.
 	// When using SPI all addresses are shifted one bit left in the "SPI address byte" (section 8.1.2.3)
@@ -212,7 +259,11 @@ public:
 		PICC_CMD_MF_TRANSFER	= 0xB0,		// Writes the contents of the internal data register to a block.
 		// The commands used for MIFARE Ultralight (from http://www.nxp.com/documents/data_sheet/MF0ICU1.pdf, Section 8.6)
 		// The PICC_CMD_MF_READ and PICC_CMD_MF_WRITE can also be used for MIFARE Ultralight.
-		PICC_CMD_UL_WRITE		= 0xA2		// Writes one 4 byte page to the PICC.
+		PICC_CMD_UL_WRITE		= 0xA2,		// Writes one 4 byte page to the PICC.
+		// NTAG21x and MIFARE Ultralight EV1 only (from https://www.nxp.com/docs/en/data-sheet/NTAG213_215_216.pdf, Section 10)
+		PICC_CMD_UL_GET_VERSION	= 0x60,		// Returns 8 bytes: vendor, product type and storage size.
+		PICC_CMD_UL_FAST_READ	= 0x3A,		// Reads the pages from a start to an end address in one frame.
+		PICC_CMD_UL_PWD_AUTH	= 0x1B		// 32 bit password authentication, the PICC answers with the 16 bit PACK.
 	};
 	
 	// MIFARE constants that does not fit anywhere else
@@ -248,6 +299,7 @@ public:
 		STATUS_INTERNAL_ERROR	,	// Internal error in the code. Should not happen ;-)
 		STATUS_INVALID			,	// Invalid argument.
 		STATUS_CRC_WRONG		,	// The CRC_A does not match
+		STATUS_PENDING			,	// A non-blocking command is still running. See PCD_Poll().
 		STATUS_MIFARE_NACK		= 0xff	// A MIFARE PICC responded with NAK.
 	};
 	
@@ -262,7 +314,26 @@ public:
 	typedef struct {
 		byte		keyByte[MF_KEY_SIZE];
 	} MIFARE_Key;
-	
+
+	// Operations in a register sequence executed by PCD_RunRegisterSequence().
+	enum PCD_RegisterOpType : byte {
+		REG_OP_WRITE			,	// Write value to reg.
+		REG_OP_WRITE_BUFFER		,	// Write count bytes from values[] to reg, eg FIFODataReg.
+		REG_OP_READ				,	// Read reg into values[0]. Consecutive reads share one chip select assertion.
+		REG_OP_READ_BUFFER		,	// Read count bytes from reg into values[]. value is used as rxAlign.
+		REG_OP_SET_BITS			,	// Read-modify-write: set the bits given in value.
+		REG_OP_CLEAR_BITS			// Read-modify-write: clear the bits given in value.
+	};
+
+	// One step of a register sequence. Aggregate initialise as { type, reg, value, count, values }, every field spelled out.
+	typedef struct {
+		PCD_RegisterOpType	type;
+		PCD_Register		reg;
+		byte				value;		// Value to write, bit mask for the *_BITS ops or rxAlign for REG_OP_READ_BUFFER.
+		byte				count;		// Number of bytes for the *_BUFFER ops.
+		byte				*values;	// Source or destination buffer. Not used by REG_OP_WRITE and the *_BITS ops.
+	} PCD_RegisterOp;
+
 	// Member variables
 	Uid uid;								// Used by PICC_ReadCardSerial().
 	
@@ -282,6 +353,7 @@ public:
 	void PCD_ReadRegister(PCD_Register reg, byte count, byte *values, byte rxAlign = 0);
 	void PCD_SetRegisterBitMask(PCD_Register reg, byte mask);
 	void PCD_ClearRegisterBitMask(PCD_Register reg, byte mask);
+	void PCD_RunRegisterSequence(const PCD_RegisterOp *ops, byte count);
 	StatusCode PCD_CalculateCRC(byte *data, byte length, byte *result);
 	
 	/////////////////////////////////////////////////////////////////////////////////////
@@ -296,6 +368,8 @@ public:
 	byte PCD_GetAntennaGain();
 	void PCD_SetAntennaGain(byte mask);
 	bool PCD_PerformSelfTest();
+	bool PCD_EnableIrqPin(byte irqPin);
+	void PCD_DisableIrqPin();
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Power control functions
@@ -308,10 +382,16 @@ public:
 	/////////////////////////////////////////////////////////////////////////////////////
 	StatusCode PCD_TransceiveData(byte *sendData, byte sendLen, byte *backData, byte *backLen, byte *validBits = nullptr, byte rxAlign = 0, bool checkCRC = false);
 	StatusCode PCD_CommunicateWithPICC(byte command, byte waitIRq, byte *sendData, byte sendLen, byte *backData = nullptr, byte *backLen = nullptr, byte *validBits = nullptr, byte rxAlign = 0, bool checkCRC = false);
+	StatusCode PCD_StartCommunication(byte command, byte waitIRq, byte *sendData, byte sendLen, byte *backData = nullptr, byte *backLen = nullptr, byte *validBits = nullptr, byte rxAlign = 0, bool checkCRC = false);
+	StatusCode PCD_PollCommunication();
+	StatusCode PCD_TransceiveStream(const byte *sendHead, byte sendHeadLen, const byte *sendData, uint16_t sendLen, byte *backHead, byte backHeadLen, byte *backData, uint16_t *backLen);
 	StatusCode PICC_RequestA(byte *bufferATQA, byte *bufferSize);
 	StatusCode PICC_WakeupA(byte *bufferATQA, byte *bufferSize);
 	StatusCode PICC_REQA_or_WUPA(byte command, byte *bufferATQA, byte *bufferSize);
 	virtual StatusCode PICC_Select(Uid *uid, byte validBits = 0);
+	StatusCode PICC_Reselect(Uid *uid);
+	StatusCode PICC_Inventory(Uid *uids, byte capacity, byte *count);
+	StatusCode PICC_InventorySelect(Uid *uid);
 	StatusCode PICC_HaltA();
 
 	/////////////////////////////////////////////////////////////////////////////////////
@@ -322,6 +402,8 @@ public:
 	StatusCode MIFARE_Read(byte blockAddr, byte *buffer, byte *bufferSize);
 	StatusCode MIFARE_Write(byte blockAddr, byte *buffer, byte bufferSize);
 	StatusCode MIFARE_Ultralight_Write(byte page, byte *buffer, byte bufferSize);
+	StatusCode MIFARE_Ultralight_FastRead(byte startPage, byte endPage, byte *buffer, byte *bufferSize);
+	StatusCode MIFARE_Ultralight_GetVersion(byte *buffer, byte *bufferSize);
 	StatusCode MIFARE_Decrement(byte blockAddr, int32_t delta);
 	StatusCode MIFARE_Increment(byte blockAddr, int32_t delta);
 	StatusCode MIFARE_Restore(byte blockAddr);
@@ -330,10 +412,58 @@ public:
 	StatusCode MIFARE_SetValue(byte blockAddr, int32_t value);
 	StatusCode PCD_NTAG216_AUTH(byte *passWord, byte pACK[]);
 	
+	/////////////////////////////////////////////////////////////////////////////////////
+	// Non-blocking commands. Start one, then call PCD_Poll() until it stops returning STATUS_PENDING.
+	/////////////////////////////////////////////////////////////////////////////////////
+	typedef void (*CompletionCallback)(MFRC522 *reader, StatusCode status, void *context);
+	StatusCode PICC_StartREQA_or_WUPA(byte command, byte *bufferATQA, byte *bufferSize);
+	StatusCode PICC_StartIsNewCardPresent();
+	StatusCode PICC_StartHaltA();
+	StatusCode PCD_StartAuthenticate(byte command, byte blockAddr, MIFARE_Key *key, Uid *uid);
+	StatusCode MIFARE_StartRead(byte blockAddr, byte *buffer, byte *bufferSize);
+	StatusCode MIFARE_StartWrite(byte blockAddr, byte *buffer, byte bufferSize);
+	StatusCode PCD_StartMifareTransceive(byte *sendData, byte sendLen, bool acceptTimeout = false, uint32_t timeoutMicros = TIMEOUT_MIFARE);
+	StatusCode PCD_Poll();
+	bool PCD_IsBusy() const;
+	void PCD_Abort();
+	void PCD_SetCompletionCallback(CompletionCallback callback, void *context = nullptr);
+	
+#ifdef MFRC522_TELEMETRY
+	/////////////////////////////////////////////////////////////////////////////////////
+	// Telemetry, only with MFRC522_TELEMETRY
+	/////////////////////////////////////////////////////////////////////////////////////
+	enum TelemetryCommand : byte {
+		TELEMETRY_REQA		,	// PICC_REQA_or_WUPA() and everything built on it
+		TELEMETRY_SELECT	,	// PICC_Select(), anticollision included. MFRC522Extended also counts RATS and PPS here.
+		TELEMETRY_AUTH		,	// PCD_Authenticate()
+		TELEMETRY_READ		,	// MIFARE_Read()
+		TELEMETRY_WRITE		,	// MIFARE_Write(), both frames
+		TELEMETRY_HALT		,	// PICC_HaltA()
+		TELEMETRY_CRC		,	// PCD_CalculateCRC()
+		TELEMETRY_COMMANDS		// Number of entries
+	};
+	static constexpr byte TELEMETRY_BUCKETS = 16;	// Bucket i counts latencies of 2^i..2^(i+1)-1 μs. Bucket 0 includes 0μs, the last one is open ended.
+	static constexpr byte TELEMETRY_STATUSES = 9;	// STATUS_OK..STATUS_CRC_WRONG, then STATUS_MIFARE_NACK
+	typedef struct {
+		uint32_t calls;
+		uint32_t spiBytes;		// Bytes clocked over the host interface, address bytes and nested commands (eg the CRC of a WRITE) included
+		uint32_t totalMicros;
+		uint16_t results[TELEMETRY_STATUSES];		// Saturate at UINT16_MAX
+		uint16_t histogram[TELEMETRY_BUCKETS];		// Saturate at UINT16_MAX
+	} TelemetryCounters;
+	typedef struct {
+		TelemetryCounters commands[TELEMETRY_COMMANDS];
+		uint32_t spiBytes;		// All bytes since the last reset, including commands that are not counted above
+	} Telemetry;
+	const Telemetry &PCD_GetTelemetry() const { return _telemetry; }
+	void PCD_ResetTelemetry();
+	void PCD_DumpTelemetryToSerial();
+	
+#endif
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Support functions
 	/////////////////////////////////////////////////////////////////////////////////////
-	StatusCode PCD_MIFARE_Transceive(byte *sendData, byte sendLen, bool acceptTimeout = false);
+	StatusCode PCD_MIFARE_Transceive(byte *sendData, byte sendLen, bool acceptTimeout = false, uint32_t timeoutMicros = TIMEOUT_MIFARE);
 	// old function used too much memory, now name moved to flash; if you need char, copy from flash to memory
 	//const char *GetStatusCodeName(byte code);
 	static const __FlashStringHelper *GetStatusCodeName(StatusCode code);
@@ -364,8 +494,99 @@ public:
 	
 protected:
 	byte _chipSelectPin;		// Arduino pin connected to MFRC522's SPI slave select input (Pin 24, NSS, active low)
+	MFRC522Transport _transport;
 	byte _resetPowerDownPin;	// Arduino pin connected to MFRC522's reset and power down input (Pin 6, NRSTPD, active low)
+	byte _irqPin;				// Arduino pin connected to MFRC522's interrupt request output (Pin 23, IRQ), or UNUSED_PIN to poll.
+	byte _irqSlot;				// Index of this instance in _irqOwners[].
+	volatile bool _irqPending;	// Set by the interrupt handler when the IRQ pin asserts.
+	bool _hardwareCRC;			// TxCRCEn and RxCRCEn are set: the MFRC522 appends CRC_A to sent frames and checks and removes it from received ones.
+	byte _txSpeed;				// TxSpeed and RxSpeed as programmed, 0 for 106 kBd up to 3 for 848 kBd. Only an ISO/IEC 14443-4 PPS changes them.
+	byte _rxSpeed;
+	uint32_t _commandTimeout;	// Receive timeout in μs of the next PCD_CommunicateWithPICC().
+	uint16_t _timerPrescaler;	// TPrescaler and TReload as programmed in the MFRC522.
+	uint16_t _timerReload;
+#ifdef MFRC522_SHADOW_REGISTERS
+	static constexpr byte SHADOW_COUNT = 7;
+	byte _shadow[SHADOW_COUNT];	// Register values as last written, see shadowRegisters[] in MFRC522.cpp.
+	byte _shadowValid;			// Bit i set => _shadow[i] is known.
+#endif
+#ifdef MFRC522_TELEMETRY
+	typedef struct {
+		uint32_t micros;
+		uint32_t spiBytes;
+	} TelemetryMark;			// Start of a counted command
+	Telemetry _telemetry;
+	TelemetryMark PCD_TelemetryMark() const { return { (uint32_t)micros(), _telemetry.spiBytes }; }
+	StatusCode PCD_TelemetryRecord(byte command, const TelemetryMark &mark, StatusCode result);
+#endif
+	// State of the command started by PCD_StartCommunication(), finished by PCD_PollCommunication().
+	struct {
+		byte waitIRq;
+		byte *backData;
+		byte *backLen;
+		byte *validBits;
+		byte rxAlign;
+		bool checkCRC;
+		uint32_t deadline;		// millis() after which the command has timed out, even if the IRQ never came.
+	} _transfer;
+	// Non-blocking commands, the value of _async.command.
+	enum PCD_AsyncCommand : byte {
+		ASYNC_IDLE				,
+		ASYNC_REQA_OR_WUPA		,
+		ASYNC_HALT				,
+		ASYNC_AUTHENTICATE		,
+		ASYNC_READ				,
+		ASYNC_MIFARE_TRANSCEIVE	,
+		ASYNC_WRITE					// Two frames, _async.step is the one in flight.
+	};
+	// State of the command started by one of the non-blocking functions.
+	struct {
+		byte command;			// PCD_AsyncCommand
+		byte step;
+		byte frame[18];			// Frames that must outlive the Start function, and 4 bit ACK replies. 16 bytes + CRC_A.
+		byte frameLength;
+		byte replyLength;
+		byte validBits;
+		byte *data;				// Caller's buffer
+		byte *dataSize;
+		bool acceptTimeout;
+		StatusCode result;		// Result of the last command, returned by PCD_Poll() when idle.
+		CompletionCallback callback;
+		void *context;
+#ifdef MFRC522_TELEMETRY
+		TelemetryMark telemetry;	// Set by PCD_AsyncBegin()
+#endif
+	} _async;
+	static MFRC522 *_irqOwners[IRQ_SLOTS];
+	template <byte slot> static void PCD_IrqHandler();
+	bool PCD_WaitForIrq(uint32_t deadline);
+	void PCD_WaitForPoll();
+	void PCD_StreamRead(byte count, byte *backHead, byte backHeadLen, byte *backData, uint16_t backCapacity, uint16_t *received);
+	StatusCode PCD_Finish(StatusCode started);
+	bool PCD_AsyncBegin(byte command);
+	StatusCode PCD_AsyncDone(StatusCode result);
+	StatusCode PCD_AsyncStep(StatusCode result);
+	StatusCode PCD_StartMifareFrame(uint32_t timeoutMicros);
+	StatusCode PCD_AsyncMifareAck(StatusCode result);
+	StatusCode PICC_Anticollision(byte command, byte *uidCl, byte *knownBits);
+	StatusCode PICC_SelectLevel(byte command, const byte *uidCl, byte *sak);
+	StatusCode PICC_SelectCascade(Uid *uid, byte validBits);
+	StatusCode PICC_InventoryReactivate(byte cascadeLevel, const Uid *path);
+	StatusCode PICC_InventoryLevel(byte cascadeLevel, Uid *path, Uid *uids, byte capacity, byte *count);
 	StatusCode MIFARE_TwoStepHelper(byte command, byte blockAddr, int32_t data);
+	StatusCode PCD_AppendCRC(byte *buffer, byte *length);
+	void PCD_SetHardwareCRC(bool enabled);
+	void PCD_SetBitRates(byte txSpeed, byte rxSpeed);
+	void PCD_ResetModulation();
+	void PCD_SetCommandTimeout(uint32_t timeoutMicros);
+	byte PCD_PrepareTimer(uint32_t timeoutMicros, PCD_RegisterOp *ops);
+	bool PCD_ShadowGet(PCD_Register reg, byte *value);
+	bool PCD_ShadowPut(PCD_Register reg, byte value);
+	void PCD_ShadowInvalidate();
+
+	// Raw register access. Must be called between _transport.beginTransaction() and _transport.endTransaction().
+	void PCD_TransferWrite(PCD_Register reg, byte count, const byte *values);
+	void PCD_TransferRead(PCD_Register reg, byte count, byte *values, byte rxAlign);
 };
 
 #endif
@@ -31,6 +31,18 @@
 MFRC522::StatusCode MFRC522Extended::PICC_Select(	Uid *uid,			///< Pointer to Uid struct. Normally output, but can also be used to supply a known UID.
 											byte validBits		///< The number of known UID bits supplied in *uid. Normally 0. If set you must also supply uid->size.
 										 ) {
+	MFRC522_TELEMETRY_BEGIN();
+	return MFRC522_TELEMETRY_END(TELEMETRY_SELECT, PICC_SelectAndRequestATS(uid, validBits));
+} // End PICC_Select()
+
+/**
+ * The SELECT/ANTICOLLISION loop of PICC_Select(), followed by RATS and PPS for ISO/IEC 14443-4 PICCs.
+ * 
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522Extended::PICC_SelectAndRequestATS(	Uid *uid,			///< Pointer to Uid struct. Normally output, but can also be used to supply a known UID.
+														byte validBits		///< The number of known UID bits supplied in *uid. Normally 0. If set you must also supply uid->size.
+													 ) {
 	bool uidComplete;
 	bool selectDone;
 	bool useCascadeTag;
@@ -139,19 +151,20 @@ MFRC522::StatusCode MFRC522Extended::PICC_Select(	Uid *uid,			///< Pointer to Ui
 				buffer[1] = 0x70; // NVB - Number of Valid Bits: Seven whole bytes
 				// Calculate BCC - Block Check Character
 				buffer[6] = buffer[2] ^ buffer[3] ^ buffer[4] ^ buffer[5];
-				// Calculate CRC_A
-				result = PCD_CalculateCRC(buffer, 7, &buffer[7]);
+				// Add CRC_A
+				bufferUsed		= 7;
+				result = PCD_AppendCRC(buffer, &bufferUsed);
 				if (result != STATUS_OK) {
 					return result;
 				}
 				txLastBits		= 0; // 0 => All 8 bits are valid.
-				bufferUsed		= 9;
 				// Store response in the last 3 bytes of buffer (BCC and CRC_A - not needed after tx)
 				responseBuffer	= &buffer[6];
 				responseLength	= 3;
 			}
 			else { // This is an ANTICOLLISION.
 				//Serial.print(F("ANTICOLLISION: currentLevelKnownBits=")); Serial.println(currentLevelKnownBits, DEC);
+				PCD_SetHardwareCRC(false); // Anticollision frames carry no CRC_A.
 				txLastBits		= currentLevelKnownBits % 8;
 				count			= currentLevelKnownBits / 8;	// Number of whole bytes in the UID part.
 				index			= 2 + count;					// Number of whole bytes: SEL + NVB + UIDs
@@ -162,12 +175,12 @@ MFRC522::StatusCode MFRC522Extended::PICC_Select(	Uid *uid,			///< Pointer to Ui
 				responseLength	= sizeof(buffer) - index;
 			}
 			
-			// Set bit adjustments
-			rxAlign = txLastBits;											// Having a separate variable is overkill. But it makes the next line easier to read.
-			PCD_WriteRegister(BitFramingReg, (rxAlign << 4) + txLastBits);	// RxAlign = BitFramingReg[6..4]. TxLastBits = BitFramingReg[2..0]
+			// Set bit adjustments. PCD_CommunicateWithPICC() writes them to BitFramingReg as part of its start sequence.
+			rxAlign = txLastBits;
 			
-			// Transmit the buffer and receive the response.
-			result = PCD_TransceiveData(buffer, bufferUsed, responseBuffer, &responseLength, &txLastBits, rxAlign);
+			// Transmit the buffer and receive the response. The CRC_A of the SAK is validated.
+			PCD_SetCommandTimeout(TIMEOUT_ACTIVATION);
+			result = PCD_TransceiveData(buffer, bufferUsed, responseBuffer, &responseLength, &txLastBits, rxAlign, currentLevelKnownBits >= 32);
 			if (result == STATUS_COLLISION) { // More than one PICC in the field => collision.
 				byte valueOfCollReg = PCD_ReadRegister(CollReg); // CollReg[7..0] bits are: ValuesAfterColl reserved CollPosNotValid CollPos[4:0]
 				if (valueOfCollReg & 0x20) { // CollPosNotValid
@@ -212,17 +225,9 @@ MFRC522::StatusCode MFRC522Extended::PICC_Select(	Uid *uid,			///< Pointer to Ui
 		}
 		
 		// Check response SAK (Select Acknowledge)
-		if (responseLength != 3 || txLastBits != 0) { // SAK must be exactly 24 bits (1 byte + CRC_A).
+		if (responseLength != (_hardwareCRC ? 1 : 3) || txLastBits != 0) { // SAK must be exactly 24 bits (1 byte + CRC_A), the MFRC522 removes the CRC_A with RxCRCEn.
 			return STATUS_ERROR;
 		}
-		// Verify CRC_A - do our own calculation and store the control in buffer[2..3] - those bytes are not needed anymore.
-		result = PCD_CalculateCRC(responseBuffer, 1, &buffer[2]);
-		if (result != STATUS_OK) {
-			return result;
-		}
-		if ((buffer[2] != responseBuffer[1]) || (buffer[3] != responseBuffer[2])) {
-			return STATUS_CRC_WRONG;
-		}
 		if (responseBuffer[0] & 0x04) { // Cascade bit set - UID not complete yes
 			cascadeLevel++;
 		}
@@ -242,100 +247,22 @@ MFRC522::StatusCode MFRC522Extended::PICC_Select(	Uid *uid,			///< Pointer to Ui
 		Ats ats;
 		result = PICC_RequestATS(&ats);
 		if (result == STATUS_OK) {
-			// Check the ATS
-			if (ats.size > 0)
-			{
-				// TA1 has been transmitted?
-				// PPS must be supported...
-				if (ats.ta1.transmitted)
-				{
-					// TA1
-					//  8 | 7 | 6 | 5 | 4 | 3 | 2 | 1 | Description
-					// ---+---+---+---+---+---+---+---+------------------------------------------
-					//  0 | - | - | - | 0 | - | - | - | Different D for each direction supported
-					//  1 | - | - | - | 0 | - | - | - | Only same D for both direction supported
-					//  - | x | x | x | 0 | - | - | - | DS (Send D)
-					//  - | - | - | - | 0 | x | x | x | DR (Receive D)
-					//
-					// D to bitrate table
-					//  3 | 2 | 1 | Value
-					// ---+---+---+-----------------------------
-					//  1 | - | - | 848 kBaud is supported
-					//  - | 1 | - | 424 kBaud is supported
-					//  - | - | 1 | 212 kBaud is supported
-					//  0 | 0 | 0 | Only 106 kBaud is supported
-					//
-					// Note: 106 kBaud is always supported
-					//
-					// I have almost constant timeouts when changing speeds :(
-					// default never used, so only delarate
-					//TagBitRates ds = BITRATE_106KBITS; 
-					//TagBitRates dr = BITRATE_106KBITS;
-					TagBitRates ds;
-					TagBitRates dr;
-					
-					//// TODO Not working at 848 or 424
-					//if (ats.ta1.ds & 0x04) 
-					//{
-					//	ds = BITRATE_848KBITS;
-					//} 
-					//else if (ats.ta1.ds & 0x02)
-					//{
-					//	ds = BITRATE_424KBITS;
-					//}
-					//else if (ats.ta1.ds & 0x01)
-					//{
-					//	ds = BITRATE_212KBITS;
-					//}
-					//else 
-					//{
-					//	ds = BITRATE_106KBITS;
-					//}
-
-					if (ats.ta1.ds & 0x01)
-					{
-						ds = BITRATE_212KBITS;
-					}
-					else 
-					{
-						ds = BITRATE_106KBITS;
-					}
-
-					//// Not working at 848 or 424
-					//if (ats.ta1.dr & 0x04) 
-					//{
-					//	dr = BITRATE_848KBITS;
-					//} 
-					//else if (ats.ta1.dr & 0x02)
-					//{
-					//	dr = BITRATE_424KBITS;
-					//}
-					//else if (ats.ta1.dr & 0x01)
-					//{
-					//	dr = BITRATE_212KBITS;
-					//}
-					//else 
-					//{
-					//	dr = BITRATE_106KBITS;
-					//}
-
-					if (ats.ta1.dr & 0x01)
-					{
-						dr = BITRATE_212KBITS;
-					}
-					else
-					{
-						dr = BITRATE_106KBITS;
-					}
-
-					PICC_PPS(ds, dr);
-				}
+			// FSC, FWI and CID support are needed by the TCL_ functions
+			tag.ats = ats;
+			tag.blockNumber = false;
+			tag.sendBitRate = BITRATE_106KBITS;
+			tag.receiveBitRate = BITRATE_106KBITS;
+
+			// Faster bit rates only if asked for with PICC_SetMaxBitRate(). A failed PPS leaves both sides at 106 kBd,
+			// the PICC is still selected.
+			if (_maxBitRate != BITRATE_106KBITS) {
+				PICC_NegotiateBitRate(&tag);
 			}
 		}
 	}
 
 	return STATUS_OK;
-} // End PICC_Select()
+} // End PICC_SelectAndRequestATS()
 
 /**
  * Transmits a Request command for Answer To Select (ATS).
@@ -365,16 +292,18 @@ MFRC522::StatusCode MFRC522Extended::PICC_RequestATS(Ats *ats)
 	// ------------+-----+-----+-----+-----+-----+-----+-----+-----+-----+-----------
 	// FSD (bytes) |  16 |  24 |  32 |  40 |  48 |  64 |  96 | 128 | 256 | RFU > 256
 	//
-	bufferATS[1] = 0x50; // FSD=64, CID=0
+	bufferATS[1] = 0x80; // FSD=256, CID=0. Blocks stream through the FIFO, see PCD_TransceiveStream().
 
-	// Calculate CRC_A
-	result = PCD_CalculateCRC(bufferATS, 2, &bufferATS[2]);
+	// Add CRC_A
+	byte sendLen = 2;
+	result = PCD_AppendCRC(bufferATS, &sendLen);
 	if (result != STATUS_OK) {
 		return result;
 	}
 
 	// Transmit the buffer and receive the response, validate CRC_A.
-	result = PCD_TransceiveData(bufferATS, 4, bufferATS, &bufferSize, NULL, 0, true);
+	PCD_SetCommandTimeout(TIMEOUT_ISO_DEP_ACTIVATION);
+	result = PCD_TransceiveData(bufferATS, sendLen, bufferATS, &bufferSize, NULL, 0, true);
 	if (result != STATUS_OK) {
 		PICC_HaltA();
 	}
@@ -431,13 +360,9 @@ MFRC522::StatusCode MFRC522Extended::PICC_RequestATS(Ats *ats)
 			case 0x07:
 				ats->fsc = 128;
 				break;
-			case 0x08:
-				// This value cannot be hold by a byte
-				// The reason I ignore it is that MFRC255 FIFO is 64 bytes so this is not a possible value (or atleast it shouldn't)
-				//ats->fsc = 256;
-				break;
-				// TODO: What to do with RFU (Reserved for future use)?
 			default:
+				// 8 is 256 bytes. RFU values mean more, but 256 is the most we send in one frame.
+				ats->fsc = 256;
 				break;
 		}
 
@@ -469,7 +394,7 @@ MFRC522::StatusCode MFRC522Extended::PICC_RequestATS(Ats *ats)
 		else
 		{
 			// Defaults for TB1
-			ats->tb1.fwi = 0;	// TODO: Don't know the default for this!
+			ats->tb1.fwi = 4;	// The default value of FWI is 4 (FWT = 4.8ms), ISO/IEC 14443-4 5.2.5
 			ats->tb1.sfgi = 0;	// The default value of SFGI is 0 (meaning that the card does not need any particular SFGT)
 		}
 
@@ -510,7 +435,7 @@ MFRC522::StatusCode MFRC522Extended::PICC_RequestATS(Ats *ats)
 
 		// Defaults for TB1
 		ats->tb1.transmitted = false;
-		ats->tb1.fwi = 0;	// TODO: Don't know the default for this!
+		ats->tb1.fwi = 4;	// The default value of FWI is 4 (FWT = 4.8ms), ISO/IEC 14443-4 5.2.5
 		ats->tb1.sfgi = 0;	// The default value of SFGI is 0 (meaning that the card does not need any particular SFGT)
 
 		// Defaults for TC1
@@ -519,7 +444,7 @@ MFRC522::StatusCode MFRC522Extended::PICC_RequestATS(Ats *ats)
 		ats->tc1.supportsNAD = false;
 	}
 
-	memcpy(ats->data, bufferATS, bufferSize - 2);
+	memcpy(ats->data, bufferATS, bufferSize - (_hardwareCRC ? 0 : 2));
 
 	return result;
 } // End PICC_RequestATS()
@@ -541,22 +466,20 @@ MFRC522::StatusCode MFRC522Extended::PICC_PPS()
 	ppsBuffer[0] = 0xD0;	// CID is hardcoded as 0 in RATS
 	ppsBuffer[1] = 0x00;	// PPS0 indicates whether PPS1 is present
 
-	// Calculate CRC_A
-	result = PCD_CalculateCRC(ppsBuffer, 2, &ppsBuffer[2]);
+	// Add CRC_A
+	byte sendLen = 2;
+	result = PCD_AppendCRC(ppsBuffer, &sendLen);
 	if (result != STATUS_OK) {
 		return result;
 	}
 
 	// Transmit the buffer and receive the response, validate CRC_A.
-	result = PCD_TransceiveData(ppsBuffer, 4, ppsBuffer, &ppsBufferSize, NULL, 0, true);
+	PCD_SetCommandTimeout(TIMEOUT_ISO_DEP_ACTIVATION);
+	result = PCD_TransceiveData(ppsBuffer, sendLen, ppsBuffer, &ppsBufferSize, NULL, 0, true);
 	if (result == STATUS_OK)
 	{
 		// Enable CRC for T=CL
-		byte txReg = PCD_ReadRegister(TxModeReg) | 0x80;
-		byte rxReg = PCD_ReadRegister(RxModeReg) | 0x80;
-
-		PCD_WriteRegister(TxModeReg, txReg);
-		PCD_WriteRegister(RxModeReg, rxReg);
+		PCD_SetHardwareCRC(true);
 	}
 
 	return result;
@@ -572,10 +495,6 @@ MFRC522::StatusCode MFRC522Extended::PICC_PPS(TagBitRates sendBitRate,
 ) {
 	StatusCode result;
 
-	// TODO not used
-	//byte txReg = PCD_ReadRegister(TxModeReg) & 0x8F;
-	//byte rxReg = PCD_ReadRegister(RxModeReg) & 0x8F;
-
 	byte ppsBuffer[5];
 	byte ppsBufferSize = 5;
 	// Start byte: The start byte (PPS) consists of two parts:
@@ -584,67 +503,28 @@ MFRC522::StatusCode MFRC522Extended::PICC_PPS(TagBitRates sendBitRate,
 	ppsBuffer[0] = 0xD0;	// CID is hardcoded as 0 in RATS
 	ppsBuffer[1] = 0x11;	// PPS0 indicates whether PPS1 is present
 
-	// Bit 8 - Set to '0' as MFRC522 allows different bit rates for send and receive
-	// Bit 4 - Set to '0' as it is Reserved for future use.
-	//ppsBuffer[2] = (((sendBitRate & 0x03) << 4) | (receiveBitRate & 0x03)) & 0xE7;
-	ppsBuffer[2] = (((sendBitRate & 0x03) << 2) | (receiveBitRate & 0x03)) & 0xE7;
+	// PPS1: b8-b5 set to '0' (RFU), b4-b3 DSI (PICC to PCD), b2-b1 DRI (PCD to PICC), ISO/IEC 14443-4 5.3.3
+	ppsBuffer[2] = ((sendBitRate & 0x03) << 2) | (receiveBitRate & 0x03);
 
-	// Calculate CRC_A
-	result = PCD_CalculateCRC(ppsBuffer, 3, &ppsBuffer[3]);
+	// Add CRC_A
+	byte sendLen = 3;
+	result = PCD_AppendCRC(ppsBuffer, &sendLen);
 	if (result != STATUS_OK) {
 		return result;
 	}
 	
 	// Transmit the buffer and receive the response, validate CRC_A.
-	result = PCD_TransceiveData(ppsBuffer, 5, ppsBuffer, &ppsBufferSize, NULL, 0, true);
+	PCD_SetCommandTimeout(TIMEOUT_ISO_DEP_ACTIVATION);
+	result = PCD_TransceiveData(ppsBuffer, sendLen, ppsBuffer, &ppsBufferSize, NULL, 0, true);
 	if (result == STATUS_OK)
 	{
 		// Make sure it is an answer to our PPS
-		// We should receive our PPS byte and 2 CRC bytes
-		if ((ppsBufferSize == 3) && (ppsBuffer[0] == 0xD0)) {
-			byte txReg = PCD_ReadRegister(TxModeReg) & 0x8F;
-			byte rxReg = PCD_ReadRegister(RxModeReg) & 0x8F;
-
-			// Set bit rate and enable CRC for T=CL
-			txReg = (txReg & 0x8F) | ((receiveBitRate & 0x03) << 4) | 0x80;
-			rxReg = (rxReg & 0x8F) | ((sendBitRate & 0x03) << 4) | 0x80;
-			rxReg &= 0xF0; //Enforce although this should be set already
-
-			// From ConfigIsoType
-			//rxReg |= 0x06;
-
-			PCD_WriteRegister(TxModeReg, txReg);
-			PCD_WriteRegister(RxModeReg, rxReg);
-
-			// At 212kBps
-			switch (sendBitRate) {
-				case BITRATE_212KBITS:
-					{
-						//PCD_WriteRegister(ModWidthReg, 0x13);
-						PCD_WriteRegister(ModWidthReg, 0x15);
-					}
-					break;
-				case BITRATE_424KBITS:
-					{
-						PCD_WriteRegister(ModWidthReg, 0x0A);
-					}
-					break;
-				case BITRATE_848KBITS:
-					{
-						PCD_WriteRegister(ModWidthReg, 0x05);
-					}
-					break;
-				default:
-					{
-						PCD_WriteRegister(ModWidthReg, 0x26); // Default value
-					}
-					break;
-			}
-
-			//PCD_WriteRegister(RxThresholdReg, 0x84); // ISO-14443.4 Type A (default)
-			//PCD_WriteRegister(ControlReg, 0x10);
-			
-			delayMicroseconds(10);
+		// We should receive our PPS byte and 2 CRC bytes, unless the MFRC522 removed them already
+		if ((ppsBufferSize == (_hardwareCRC ? 1 : 3)) && (ppsBuffer[0] == 0xD0)) {
+			// The PICC answered at the old bit rate and switched after it. The PCD transmits at DR and receives at DS.
+			// Enable CRC for T=CL
+			_hardwareCRC = true;
+			PCD_SetBitRates(receiveBitRate, sendBitRate);
 		}
 		else 
 		{
@@ -655,204 +535,314 @@ MFRC522::StatusCode MFRC522Extended::PICC_PPS(TagBitRates sendBitRate,
 	return result;
 } // End PICC_PPS()
 
+/**
+ * Switches to the highest bit rates both the PICC (TA1 of the ATS) and PICC_SetMaxBitRate() allow, with a PPS.
+ * Must be the first command after RATS, the PICC only accepts a PPS there. The bit rates in use are stored in
+ * tag->sendBitRate and tag->receiveBitRate. If the PPS fails both sides stay at 106 kBd: the PICC only switches
+ * after it answered.
+ *
+ * @return STATUS_OK on success or if 106 kBd is the highest common rate, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522Extended::PICC_NegotiateBitRate(TagInfo *tag	///< Selected PICC, after PICC_RequestATS()
+														  ) {
+	tag->sendBitRate = BITRATE_106KBITS;
+	tag->receiveBitRate = BITRATE_106KBITS;
+	if (tag->ats.size == 0 || !tag->ats.ta1.transmitted) {
+		return STATUS_OK;	// Without TA1 the PICC only supports 106 kBd
+	}
+
+	// TA1 has one bit per bit rate and direction: 0x01 212 kBd, 0x02 424 kBd, 0x04 848 kBd. With sameD set
+	// both directions must use the same one.
+	byte dsSupported = tag->ats.ta1.ds & 0x07;
+	byte drSupported = tag->ats.ta1.dr & 0x07;
+	if (tag->ats.ta1.sameD) {
+		dsSupported &= drSupported;
+		drSupported = dsSupported;
+	}
+	TagBitRates ds = BITRATE_106KBITS;
+	TagBitRates dr = BITRATE_106KBITS;
+	for (byte rate = _maxBitRate; rate > BITRATE_106KBITS; rate--) {
+		if (ds == BITRATE_106KBITS && (dsSupported & (1 << (rate - 1)))) {
+			ds = (TagBitRates)rate;
+		}
+		if (dr == BITRATE_106KBITS && (drSupported & (1 << (rate - 1)))) {
+			dr = (TagBitRates)rate;
+		}
+	}
+	if (ds == BITRATE_106KBITS && dr == BITRATE_106KBITS) {
+		return STATUS_OK;
+	}
+
+	MFRC522::StatusCode result = PICC_PPS(ds, dr);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	tag->sendBitRate = ds;
+	tag->receiveBitRate = dr;
+	return STATUS_OK;
+} // End PICC_NegotiateBitRate()
+
 
 /////////////////////////////////////////////////////////////////////////////////////
 // Functions for communicating with ISO/IEC 14433-4 cards
 /////////////////////////////////////////////////////////////////////////////////////
 
-MFRC522::StatusCode MFRC522Extended::TCL_Transceive(PcbBlock *send, PcbBlock *back)
+/**
+ * Frame waiting time of the PICC: FWT = (256 * 16 / fc) * 2^FWI, plus ΔFWT = 49152 / fc (ISO/IEC 14443-4 7.2).
+ * FWI 15 is RFU and treated as the default 4.
+ *
+ * @return FWT in μs.
+ */
+uint32_t MFRC522Extended::TCL_FrameWaitingTime(TagInfo *tag)
 {
-	MFRC522::StatusCode result;
-	byte inBuffer[FIFO_SIZE];
-	byte inBufferSize = FIFO_SIZE;
-	byte outBuffer[send->inf.size + 5]; // PCB + CID + NAD + INF + EPILOGUE (CRC)
-	byte outBufferOffset = 1;
-	byte inBufferOffset = 1;
+	const byte fwi = (tag->ats.tb1.fwi < 15) ? tag->ats.tb1.fwi : 4;
+	return (302UL << fwi) + 3625;
+} // End TCL_FrameWaitingTime()
+
+/**
+ * Sets the prologue of a block: the PCB, the CID if the PICC supports it, and the current block number
+ * for I- and R-blocks. NAD is not supported. The INF field is left to the caller.
+ */
+void MFRC522Extended::TCL_PrepareBlock(TagInfo *tag, byte pcb, PcbBlock *block)
+{
+	if (tag->ats.tc1.supportsCID) {
+		pcb |= 0x08;
+	}
+	if ((pcb & 0xC0) != 0xC0 && tag->blockNumber) {
+		pcb |= 0x01;
+	}
+	block->prologue.pcb = pcb;
+	block->prologue.cid = 0x00;	// CID is curentlly hardcoded as 0x00
+	block->prologue.nad = 0x00;
+} // End TCL_PrepareBlock()
 
-	// Set the PCB byte
-	outBuffer[0] = send->prologue.pcb;
+/**
+ * Sends a block and receives the answer through PCD_TransceiveStream(), so both can be longer than the FIFO.
+ * The answer is expected with the same prologue fields (CID, NAD) as the block sent.
+ * back->inf.size is the size of back->inf.data on input and the length of the INF field on output.
+ *
+ * @return STATUS_OK on success, STATUS_MIFARE_NACK if the answer is an R(NAK), STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522Extended::TCL_TransceiveBlock(PcbBlock *send, PcbBlock *back, uint32_t timeoutMicros)
+{
+	byte head[3];
+	byte headLen = 0;
 
-	// Set the CID byte if available
+	// Set the PCB byte, and the CID and NAD bytes if available
+	head[headLen++] = send->prologue.pcb;
 	if (send->prologue.pcb & 0x08) {
-		outBuffer[outBufferOffset] = send->prologue.cid;
-		outBufferOffset++;
+		head[headLen++] = send->prologue.cid;
 	}
-
-	// Set the NAD byte if available
 	if (send->prologue.pcb & 0x04) {
-		outBuffer[outBufferOffset] = send->prologue.nad;
-		outBufferOffset++;
+		head[headLen++] = send->prologue.nad;
 	}
 
-	// Copy the INF field if available
-	if (send->inf.size > 0) {
-		memcpy(&outBuffer[outBufferOffset], send->inf.data, send->inf.size);
-		outBufferOffset += send->inf.size;
+	byte backHead[3];
+	uint16_t backLen = back->inf.size;
+	PCD_SetCommandTimeout(timeoutMicros);
+	MFRC522::StatusCode result = PCD_TransceiveStream(head, headLen, send->inf.data, send->inf.size, backHead, headLen, back->inf.data, &backLen);
+	if (result != STATUS_OK && result != STATUS_NO_ROOM) {
+		return result;
 	}
 
-	// Is the CRC enabled for transmission?
-	byte txModeReg = PCD_ReadRegister(TxModeReg);
-	if ((txModeReg & 0x80) != 0x80) {
-		// Calculate CRC_A
-		result = PCD_CalculateCRC(outBuffer, outBufferOffset, &outBuffer[outBufferOffset]);
-		if (result != STATUS_OK) {
-			return result;
-		}
-
-		outBufferOffset += 2;
+	// We want to turn the received prologue back into a PcbBlock
+	byte offset = 0;
+	back->prologue.pcb = backHead[offset++];
+	if (send->prologue.pcb & 0x08) {
+		back->prologue.cid = backHead[offset++];
 	}
-
-	// Transceive the block
-	result = PCD_TransceiveData(outBuffer, outBufferOffset, inBuffer, &inBufferSize);
+	if (send->prologue.pcb & 0x04) {
+		back->prologue.nad = backHead[offset++];
+	}
+	back->inf.size = (byte)backLen;
 	if (result != STATUS_OK) {
 		return result;
 	}
 
-	// We want to turn the received array back to a PcbBlock
-	back->prologue.pcb = inBuffer[0];
-
-	// CID byte is present?
-	if (send->prologue.pcb & 0x08) {
-		back->prologue.cid = inBuffer[inBufferOffset];
-		inBufferOffset++;
-	}
-
-	// NAD byte is present?
-	if (send->prologue.pcb & 0x04) {
-		back->prologue.nad = inBuffer[inBufferOffset];
-		inBufferOffset++;
+	// If the response is a R-Block check NACK
+	if (((back->prologue.pcb & 0xC0) == 0x80) && (back->prologue.pcb & 0x10)) {
+		return STATUS_MIFARE_NACK;
 	}
+	return STATUS_OK;
+} // End TCL_TransceiveBlock()
 
-	// Check if CRC is taken care of by MFRC522
-	byte rxModeReg = PCD_ReadRegister(TxModeReg);
-	if ((rxModeReg & 0x80) != 0x80) {
-		Serial.print("CRC is not taken care of by MFRC522: ");
-		Serial.println(rxModeReg, HEX);
+/**
+ * Sends a block and receives the answer, waiting up to the FWT given in the ATS of the selected PICC (tag).
+ */
+MFRC522::StatusCode MFRC522Extended::TCL_Transceive(PcbBlock *send, PcbBlock *back)
+{
+	return TCL_TransceiveBlock(send, back, TCL_FrameWaitingTime(&tag));
+} // End TCL_Transceive()
 
-		// Check the CRC
-		// We need at least the CRC_A value.
-		if ((int)(inBufferSize - inBufferOffset) < 2) {
-			return STATUS_CRC_WRONG;
+/**
+ * Sends a block and returns the answer of the PICC to it, an I-block or an R(ACK). On the way it handles:
+ *  - S(WTX): confirmed with the same WTXM, the next answer may then take FWT * WTXM (ISO/IEC 14443-4 7.3).
+ *  - A timeout or a broken answer: R(NAK), or R(ACK) while the PICC is chaining (receiving), is sent
+ *    instead, up to TCL_RETRIES times. The PICC repeats its last block or acknowledges its last I-block
+ *    with the other block number, ISO/IEC 14443-4 7.5.4.
+ * back->inf as for TCL_TransceiveBlock().
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522Extended::TCL_Exchange(TagInfo *tag, PcbBlock *send, PcbBlock *back, bool receiving)
+{
+	const uint32_t fwt = TCL_FrameWaitingTime(tag);
+	const uint32_t fwtMax = (302UL << 14) + 3625;	// FWI 14, the limit for FWT * WTXM as well
+	const byte backSize = back->inf.size;
+	uint32_t timeout = fwt;
+	byte retries = 0;
+	byte wtxm;
+	PcbBlock reply;
+	PcbBlock *block = send;
+
+	for (;;) {
+		back->inf.size = backSize;
+		MFRC522::StatusCode result = TCL_TransceiveBlock(block, back, timeout);
+		timeout = fwt;
+		if (result == STATUS_TIMEOUT || result == STATUS_CRC_WRONG || result == STATUS_ERROR || result == STATUS_COLLISION) {
+			if (retries++ >= TCL_RETRIES) {
+				return result;
+			}
+			TCL_PrepareBlock(tag, receiving ? 0xA2 : 0xB2, &reply);
+			reply.inf.size = 0;
+			reply.inf.data = NULL;
+			block = &reply;
+			continue;
 		}
-
-		// Verify CRC_A - do our own calculation and store the control in controlBuffer.
-		byte controlBuffer[2];
-		MFRC522::StatusCode status = PCD_CalculateCRC(inBuffer, inBufferSize - 2, controlBuffer);
-		if (status != STATUS_OK) {
-			return status;
+		if (result != STATUS_OK) {
+			return result;
 		}
 
-		if ((inBuffer[inBufferSize - 2] != controlBuffer[0]) || (inBuffer[inBufferSize - 1] != controlBuffer[1])) {
-			return STATUS_CRC_WRONG;
+		// S(WTX): the PICC needs more time. Its INF holds WTXM in bits 6..1.
+		if ((back->prologue.pcb & 0xF7) == 0xF2) {
+			wtxm = (back->inf.size > 0) ? (back->inf.data[0] & 0x3F) : 0;
+			if (wtxm == 0 || wtxm > 59) {
+				return STATUS_ERROR;
+			}
+			TCL_PrepareBlock(tag, 0xF2, &reply);
+			reply.inf.size = 1;
+			reply.inf.data = &wtxm;
+			block = &reply;
+			timeout = min(fwt * wtxm, fwtMax);
+			continue;
 		}
-
-		// Take away the CRC bytes
-		inBufferSize -= 2;
-	}
-
-	// Got more data?
-	if (inBufferSize > inBufferOffset) {
-		if ((inBufferSize - inBufferOffset) > back->inf.size) {
-			return STATUS_NO_ROOM;
+		if ((back->prologue.pcb & 0xC0) == 0xC0) {
+			return STATUS_ERROR;	// No other S-block is expected in answer to an I- or R-block
 		}
-
-		memcpy(back->inf.data, &inBuffer[inBufferOffset], inBufferSize - inBufferOffset);
-		back->inf.size = inBufferSize - inBufferOffset;
-	} else {
-		back->inf.size = 0;
+		return STATUS_OK;
 	}
+} // End TCL_Exchange()
 
-	// If the response is a R-Block check NACK
-	if (((inBuffer[0] & 0xC0) == 0x80) && (inBuffer[0] & 0x20)) {
-		return STATUS_MIFARE_NACK;
-	}
-	
-	return result;
-}
 /**
- * Send an I-Block (Application)
+ * Exchanges an APDU of any length with the selected ISO/IEC 14443-4 PICC.
+ * Command and response are split into chained I-blocks of at most FSC (sending) and FSD (receiving) bytes,
+ * ISO/IEC 14443-4 7.1.2. Each block of a chain is acknowledged with R(ACK), the block number toggles with
+ * every acknowledged block. S(WTX) and retransmissions are handled by TCL_Exchange(), and every block
+ * streams through the FIFO, see PCD_TransceiveStream().
+ *
+ * @return STATUS_OK on success, STATUS_NO_ROOM if the response does not fit, STATUS_??? otherwise.
  */
-MFRC522::StatusCode MFRC522Extended::TCL_Transceive(TagInfo *tag, byte *sendData, byte sendLen, byte *backData, byte *backLen)
+MFRC522::StatusCode MFRC522Extended::TCL_TransceiveApdu(TagInfo *tag,			///< The selected PICC, its ATS and block number.
+														const byte *sendData,	///< The command APDU.
+														uint16_t sendLen,		///< Length of the command APDU.
+														byte *backData,			///< Buffer for the response APDU. S(WTX) uses it as well, so it must not be empty.
+														uint16_t *backLen		///< In: Size of backData. Out: Length of the response APDU.
+														)
 {
 	MFRC522::StatusCode result;
+	const uint16_t backCapacity = *backLen;
+	*backLen = 0;
+
+	// PCB, CID and CRC_A take their share of the frame size.
+	const byte overhead = tag->ats.tc1.supportsCID ? 4 : 3;
+	const uint16_t maxInf = min(tag->ats.fsc, FSD) - overhead;
 
 	PcbBlock out;
 	PcbBlock in;
-	byte outBuffer[FIFO_SIZE];
-	byte outBufferSize = FIFO_SIZE;
-	byte totalBackLen = *backLen;
-
-	// This command sends an I-Block
-	out.prologue.pcb = 0x02;
-
-	if (tag->ats.tc1.supportsCID) {
-		out.prologue.pcb |= 0x08;
-		out.prologue.cid = 0x00;	// CID is curentlly hardcoded as 0x00
+	byte retries = 0;
+
+	// Send the command, chained if it is longer than one block.
+	uint16_t sent = 0;
+	for (;;) {
+		const uint16_t chunk = min((uint16_t)(sendLen - sent), maxInf);
+		const bool chaining = (sent + chunk < sendLen);
+		TCL_PrepareBlock(tag, chaining ? 0x12 : 0x02, &out);
+		out.inf.size = (byte)chunk;
+		out.inf.data = const_cast<byte *>(sendData + sent);
+		in.inf.data = backData;
+		in.inf.size = (byte)min(backCapacity, (uint16_t)0xFF);
+
+		result = TCL_Exchange(tag, &out, &in, false);
+		if (result != STATUS_OK) {
+			return result;
+		}
+		if ((in.prologue.pcb & 0xE6) == 0xA2) {	// R(ACK)
+			if ((bool)(in.prologue.pcb & 0x01) != tag->blockNumber) {
+				// The PICC did not get the block: send it again.
+				if (retries++ >= TCL_RETRIES) {
+					return STATUS_ERROR;
+				}
+				continue;
+			}
+			if (!chaining) {
+				return STATUS_ERROR;
+			}
+			tag->blockNumber = !tag->blockNumber;
+			sent += chunk;
+			retries = 0;
+			continue;
+		}
+		if (chaining) {
+			return STATUS_ERROR;	// Every block of a chain but the last is answered with R(ACK)
+		}
+		break;
 	}
 
-	// This command doe not support NAD
-	out.prologue.pcb &= 0xFB;
-	out.prologue.nad = 0x00;
-
-	// Set the block number
-	if (tag->blockNumber) {
-		out.prologue.pcb |= 0x01;
-	}
+	// Collect the response, acknowledging each chained I-block until the last one.
+	for (;;) {
+		if ((in.prologue.pcb & 0xE2) != 0x02) {
+			return STATUS_ERROR;	// Not an I-block
+		}
+		tag->blockNumber = !tag->blockNumber;
+		*backLen += in.inf.size;
+		if (!(in.prologue.pcb & 0x10)) {
+			return STATUS_OK;
+		}
+		if (*backLen >= backCapacity) {
+			return STATUS_NO_ROOM;
+		}
 
-	// Do we have data to send?
-	if (sendData && (sendLen > 0)) {
-		out.inf.size = sendLen;
-		out.inf.data = sendData;
-	} else {
+		TCL_PrepareBlock(tag, 0xA2, &out);
 		out.inf.size = 0;
 		out.inf.data = NULL;
+		in.inf.data = backData + *backLen;
+		in.inf.size = (byte)min((uint16_t)(backCapacity - *backLen), (uint16_t)0xFF);
+		result = TCL_Exchange(tag, &out, &in, true);
+		if (result != STATUS_OK) {
+			return result;
+		}
 	}
+} // End TCL_TransceiveApdu()
 
-	// Initialize the receiving data
-	// TODO Warning: Value escapes the local scope
-	in.inf.data = outBuffer;
-	in.inf.size = outBufferSize;
-
-	result = TCL_Transceive(&out, &in);
-	if (result != STATUS_OK) {
-		return result;
-	}
-
-	// Swap block number on success
-	tag->blockNumber = !tag->blockNumber;
-
-	if (backData && (*backLen > 0)) {
-		if (*backLen < in.inf.size)
-			return STATUS_NO_ROOM;
-
-		*backLen = in.inf.size;
-		memcpy(backData, in.inf.data, in.inf.size);
+/**
+ * Send an I-Block (Application)
+ * Byte lengths, see TCL_TransceiveApdu() for longer APDUs. Without backData the response is dropped,
+ * as long as it fits into FIFO_SIZE bytes.
+ */
+MFRC522::StatusCode MFRC522Extended::TCL_Transceive(TagInfo *tag, byte *sendData, byte sendLen, byte *backData, byte *backLen)
+{
+	byte dropped[FIFO_SIZE];
+	byte *buffer = dropped;
+	uint16_t length = sizeof(dropped);
+	if (backData && backLen && (*backLen > 0)) {
+		buffer = backData;
+		length = *backLen;
 	}
 
-	// Check chaining
-	if ((in.prologue.pcb & 0x10) == 0x00)
-		return result;
-
-	// Result is chained
-	// Send an ACK to receive more data
-	// TODO: Should be checked I've never needed to send an ACK
-	while (in.prologue.pcb & 0x10) {
-		byte ackData[FIFO_SIZE];
-		byte ackDataSize = FIFO_SIZE;
-
-		result = TCL_TransceiveRBlock(tag, true, ackData, &ackDataSize);
-		if (result != STATUS_OK)
-			return result;
-
-		if (backData && (*backLen > 0)) {
-			if ((*backLen + ackDataSize) > totalBackLen)
-				return STATUS_NO_ROOM;
-
-			memcpy(&(backData[*backLen]), ackData, ackDataSize);
-			*backLen += ackDataSize;
-		}
+	MFRC522::StatusCode result = TCL_TransceiveApdu(tag, sendData, sendLen, buffer, &length);
+	if (buffer == backData) {
+		*backLen = (byte)length;
 	}
-	
 	return result;
 } // End TCL_Transceive()
 
@@ -923,25 +913,28 @@ MFRC522::StatusCode MFRC522Extended::TCL_TransceiveRBlock(TagInfo *tag, bool ack
 MFRC522::StatusCode MFRC522Extended::TCL_Deselect(TagInfo *tag)
 {
 	MFRC522::StatusCode result;
-	byte outBuffer[4];
-	byte outBufferSize = 1;
-	byte inBuffer[FIFO_SIZE];
-	byte inBufferSize = FIFO_SIZE;
+	PcbBlock out;
+	PcbBlock in;
 
-	outBuffer[0] = 0xC2;
-	if (tag->ats.tc1.supportsCID)
-	{
-		outBuffer[0] |= 0x08;
-		outBuffer[1] = 0x00;  // CID is hardcoded
-		outBufferSize = 2;
-	}
+	TCL_PrepareBlock(tag, 0xC2, &out);
+	out.inf.size = 0;
+	out.inf.data = NULL;
+	in.inf.size = 0;
+	in.inf.data = NULL;
 
-	result = PCD_TransceiveData(outBuffer, outBufferSize, inBuffer, &inBufferSize);
+	// The PICC confirms with S(DESELECT) within FWT_DESELECT = 65536/fc, ISO/IEC 14443-4 8.
+	result = TCL_TransceiveBlock(&out, &in, TIMEOUT_ISO_DEP_ACTIVATION);
 	if (result != STATUS_OK) {
 		return result;
 	}
+	if ((in.prologue.pcb & 0xF7) != 0xC2) {
+		return STATUS_ERROR;
+	}
 
-	// TODO:Maybe do some checks? In my test it returns: CA 00 (Same data as I sent to my card)
+	// A deselected PICC is back at 106 kBd
+	PCD_SetBitRates(BITRATE_106KBITS, BITRATE_106KBITS);
+	tag->sendBitRate = BITRATE_106KBITS;
+	tag->receiveBitRate = BITRATE_106KBITS;
 
 	return result;
 } // End TCL_Deselect()
@@ -1103,11 +1096,7 @@ bool MFRC522Extended::PICC_IsNewCardPresent() {
 	byte bufferATQA[2];
 	byte bufferSize = sizeof(bufferATQA);
 
-	// Reset baud rates
-	PCD_WriteRegister(TxModeReg, 0x00);
-	PCD_WriteRegister(RxModeReg, 0x00);
-	// Reset ModWidthReg
-	PCD_WriteRegister(ModWidthReg, 0x26);
+	PCD_ResetModulation();
 
 	MFRC522::StatusCode result = PICC_RequestA(bufferATQA, &bufferSize);
 
@@ -1124,7 +1113,7 @@ bool MFRC522Extended::PICC_IsNewCardPresent() {
 
 		// Defaults for TB1
 		tag.ats.tb1.transmitted = false;
-		tag.ats.tb1.fwi = 0;	// TODO: Don't know the default for this!
+		tag.ats.tb1.fwi = 4;	// The default value of FWI is 4 (FWT = 4.8ms), ISO/IEC 14443-4 5.2.5
 		tag.ats.tb1.sfgi = 0;	// The default value of SFGI is 0 (meaning that the card does not need any particular SFGT)
 
 		// Defaults for TC1
@@ -1135,6 +1124,8 @@ bool MFRC522Extended::PICC_IsNewCardPresent() {
 		memset(tag.ats.data, 0, FIFO_SIZE - 2);
 
 		tag.blockNumber = false;
+		tag.sendBitRate = BITRATE_106KBITS;
+		tag.receiveBitRate = BITRATE_106KBITS;
 		return true;
 	}
 	return false;
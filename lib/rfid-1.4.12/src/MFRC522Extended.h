@@ -12,6 +12,11 @@
 class MFRC522Extended : public MFRC522 {
 		
 public:
+	// Frame size the PCD can receive, announced as FSDI 8 in RATS. PCD_TransceiveStream() is not limited by the FIFO.
+	static constexpr uint16_t FSD = 256;
+	// Retransmissions of a block after a timeout or a broken answer, ISO/IEC 14443-4 7.5.4.
+	static constexpr byte TCL_RETRIES = 2;
+
 	// ISO/IEC 14443-4 bit rates
 	enum TagBitRates : byte {
 		BITRATE_106KBITS = 0x00,
@@ -23,7 +28,7 @@ public:
 	// Structure to store ISO/IEC 14443-4 ATS
 	typedef struct {
 		byte size;
-		byte fsc;                 // Frame size for proximity card
+		uint16_t fsc;             // Frame size for proximity card, 16 to 256
 
 		struct {
 			bool transmitted;
@@ -56,6 +61,10 @@ public:
 
 		// For Block PCB
 		bool blockNumber;
+
+		// Bit rates in use, 106 kBd unless PICC_NegotiateBitRate() switched with a PPS
+		TagBitRates sendBitRate;	// DS, PICC to PCD
+		TagBitRates receiveBitRate;	// DR, PCD to PICC
 	} TagInfo;
 
 	// A struct used for passing PCB Block
@@ -77,9 +86,9 @@ public:
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Contructors
 	/////////////////////////////////////////////////////////////////////////////////////
-	MFRC522Extended() : MFRC522() {};
-	MFRC522Extended(uint8_t rst) : MFRC522(rst) {};
-	MFRC522Extended(uint8_t ss, uint8_t rst) : MFRC522(ss, rst) {};
+	MFRC522Extended() : MFRC522(), _maxBitRate(BITRATE_106KBITS) {};
+	MFRC522Extended(uint8_t rst) : MFRC522(rst), _maxBitRate(BITRATE_106KBITS) {};
+	MFRC522Extended(uint8_t ss, uint8_t rst) : MFRC522(ss, rst), _maxBitRate(BITRATE_106KBITS) {};
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Functions for communicating with PICCs
@@ -88,12 +97,15 @@ public:
 	StatusCode PICC_RequestATS(Ats *ats);
 	StatusCode PICC_PPS();	                                                  // PPS command without bitrate parameter
 	StatusCode PICC_PPS(TagBitRates sendBitRate, TagBitRates receiveBitRate); // Different D values
+	StatusCode PICC_NegotiateBitRate(TagInfo *tag);
+	void PICC_SetMaxBitRate(TagBitRates maxBitRate) { _maxBitRate = maxBitRate; } // PICC_Select() negotiates up to this rate, default 106 kBd (no PPS)
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Functions for communicating with ISO/IEC 14433-4 cards
 	/////////////////////////////////////////////////////////////////////////////////////
 	StatusCode TCL_Transceive(PcbBlock *send, PcbBlock *back);
 	StatusCode TCL_Transceive(TagInfo * tag, byte *sendData, byte sendLen, byte *backData = NULL, byte *backLen = NULL);
+	StatusCode TCL_TransceiveApdu(TagInfo *tag, const byte *sendData, uint16_t sendLen, byte *backData, uint16_t *backLen);
 	StatusCode TCL_TransceiveRBlock(TagInfo *tag, bool ack, byte *backData = NULL, byte *backLen = NULL);
 	StatusCode TCL_Deselect(TagInfo *tag);
 	
@@ -101,6 +113,7 @@ public:
 	// Support functions
 	/////////////////////////////////////////////////////////////////////////////////////
 	static PICC_Type PICC_GetType(TagInfo *tag);
+	static uint16_t PICC_BitRateKbps(TagBitRates bitRate) { return (uint16_t)106 << bitRate; } // 106, 212, 424 or 848
 	using MFRC522::PICC_GetType;// // make old PICC_GetType(byte sak) available, otherwise would be hidden by PICC_GetType(TagInfo *tag)
 
 	// Support functions for debuging
@@ -115,6 +128,15 @@ public:
 	/////////////////////////////////////////////////////////////////////////////////////
 	bool PICC_IsNewCardPresent() override; // overrride
 	bool PICC_ReadCardSerial() override; // overrride
+
+protected:
+	TagBitRates _maxBitRate;
+
+	StatusCode PICC_SelectAndRequestATS(Uid *uid, byte validBits);
+	uint32_t TCL_FrameWaitingTime(TagInfo *tag);
+	void TCL_PrepareBlock(TagInfo *tag, byte pcb, PcbBlock *block);
+	StatusCode TCL_TransceiveBlock(PcbBlock *send, PcbBlock *back, uint32_t timeoutMicros);
+	StatusCode TCL_Exchange(TagInfo *tag, PcbBlock *send, PcbBlock *back, bool receiving);
 };
 
 #endif
@@ -0,0 +1,173 @@
+/**
+ * Several MFRC522 on one SPI bus, driven round-robin. See MFRC522Pool.h.
+ */
+
+#include "MFRC522Pool.h"
+
+MFRC522Pool::MFRC522Pool() {
+	_count = 0;
+	_next = 0;
+	memset(&_stats, 0, sizeof(_stats));
+} // End constructor
+
+/**
+ * Adds an initialised reader to the pool.
+ *
+ * @return The index of the reader, used by the request functions and the callback. MAX_READERS if the pool is full.
+ */
+byte MFRC522Pool::add(	MFRC522 *reader	///< Reader with its own chip select pin, PCD_Init() already done.
+						) {
+	if (_count == MAX_READERS) {
+		return MAX_READERS;
+	}
+	Slot *slot = &_slots[_count];
+	slot->reader = reader;
+	slot->head = 0;
+	slot->queued = 0;
+	slot->running = false;
+	return _count++;
+} // End add()
+
+/**
+ * Appends a request to the queue of a reader. It starts once the requests before it completed.
+ *
+ * @return false if the queue is full or reader is not a valid index.
+ */
+bool MFRC522Pool::submit(	byte reader,			///< Index returned by add()
+							const Request &request	///< Copied, the buffer it points to must stay valid until the callback.
+						) {
+	if (reader >= _count) {
+		return false;
+	}
+	Slot *slot = &_slots[reader];
+	if (slot->queued == QUEUE_SIZE) {
+		return false;
+	}
+	slot->queue[(slot->head + slot->queued) % QUEUE_SIZE] = request;
+	slot->queued++;
+	return true;
+} // End submit()
+
+bool MFRC522Pool::detect(byte reader, Callback callback, void *context) {
+	const Request request = { OP_DETECT, 0, nullptr, nullptr, 0, callback, context };
+	return submit(reader, request);
+} // End detect()
+
+bool MFRC522Pool::authenticate(byte reader, byte blockAddr, MFRC522::MIFARE_Key *key, Callback callback, void *context, byte authCommand) {
+	const Request request = { OP_AUTHENTICATE, blockAddr, nullptr, key, authCommand, callback, context };
+	return submit(reader, request);
+} // End authenticate()
+
+bool MFRC522Pool::read(byte reader, byte blockAddr, byte *buffer, Callback callback, void *context) {
+	const Request request = { OP_READ, blockAddr, buffer, nullptr, 0, callback, context };
+	return submit(reader, request);
+} // End read()
+
+bool MFRC522Pool::write(byte reader, byte blockAddr, byte *buffer, Callback callback, void *context) {
+	const Request request = { OP_WRITE, blockAddr, buffer, nullptr, 0, callback, context };
+	return submit(reader, request);
+} // End write()
+
+bool MFRC522Pool::halt(byte reader, Callback callback, void *context) {
+	const Request request = { OP_HALT, 0, nullptr, nullptr, 0, callback, context };
+	return submit(reader, request);
+} // End halt()
+
+/**
+ * One round-robin pass. Each reader gets one step: its command in flight is polled, or the next
+ * request in its queue is started. The pass starts one reader further each time, so no reader is
+ * always served first. Call it from loop() until idle() returns true.
+ */
+void MFRC522Pool::run() {
+	_stats.passes++;
+	for (byte i = 0; i < _count; i++) {
+		const byte index = (_next + i) % _count;
+		Slot *slot = &_slots[index];
+		MFRC522::StatusCode status;
+		if (slot->running) {
+			status = slot->reader->PCD_Poll();
+		}
+		else if (slot->queued) {
+			slot->running = true;
+			status = start(slot);
+		}
+		else {
+			continue;
+		}
+		if (status != MFRC522::STATUS_PENDING) {
+			finish(index, status);
+		}
+	}
+	if (_count) {
+		_next = (_next + 1) % _count;
+	}
+} // End run()
+
+/**
+ * Returns true if no reader has a request queued or in flight.
+ */
+bool MFRC522Pool::idle() const {
+	for (byte i = 0; i < _count; i++) {
+		if (_slots[i].queued) {
+			return false;
+		}
+	}
+	return true;
+} // End idle()
+
+/**
+ * Starts the request at the head of the queue.
+ *
+ * @return STATUS_PENDING if it runs, otherwise its result.
+ */
+MFRC522::StatusCode MFRC522Pool::start(	Slot *slot	///< Reader with a queued request
+										) {
+	MFRC522 *reader = slot->reader;
+	const Request &request = slot->queue[slot->head];
+	switch (request.operation) {
+		case OP_DETECT:
+			return reader->PICC_StartIsNewCardPresent();
+		case OP_AUTHENTICATE:
+			return reader->PCD_StartAuthenticate(request.authCommand, request.blockAddr, request.key, &reader->uid);
+		case OP_READ:
+			slot->size = 18;
+			return reader->MIFARE_StartRead(request.blockAddr, request.buffer, &slot->size);
+		case OP_WRITE:
+			return reader->MIFARE_StartWrite(request.blockAddr, request.buffer, 16);
+		case OP_HALT:
+			return reader->PICC_StartHaltA();
+		default:
+			return MFRC522::STATUS_INVALID;
+	}
+} // End start()
+
+/**
+ * Completes the request at the head of the queue of a reader and calls its callback.
+ */
+void MFRC522Pool::finish(	byte index,					///< Index of the reader
+							MFRC522::StatusCode status	///< Result of the command
+						) {
+	Slot *slot = &_slots[index];
+	const Request request = slot->queue[slot->head];
+	slot->head = (slot->head + 1) % QUEUE_SIZE;
+	slot->queued--;
+	slot->running = false;
+	_stats.completed[index]++;
+
+	switch (request.operation) {
+		case OP_DETECT:
+			// Something answered: select it. The anticollision frames block the bus for a few ms.
+			if (status == MFRC522::STATUS_OK || status == MFRC522::STATUS_COLLISION) {
+				status = slot->reader->PICC_Select(&slot->reader->uid);
+			}
+			break;
+		case OP_HALT:
+			slot->reader->PCD_StopCrypto1();
+			break;
+		default:
+			break;
+	}
+	if (request.callback) {
+		request.callback(index, request.operation, status, request.context);
+	}
+} // End finish()
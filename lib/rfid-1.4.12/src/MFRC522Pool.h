@@ -0,0 +1,89 @@
+/**
+ * Several MFRC522 on one SPI bus, driven round-robin.
+ * Each reader has a small queue of requests. run() gives every reader one step per pass: poll the
+ * command in flight, or start the next request from its queue. The commands use the non-blocking
+ * functions of MFRC522, so while one reader waits for its PICC the bus serves the others.
+ * Only selecting a PICC (OP_DETECT) still blocks the bus for its anticollision frames.
+ */
+#ifndef MFRC522Pool_h
+#define MFRC522Pool_h
+
+#include <Arduino.h>
+#include "MFRC522.h"
+
+#ifndef MFRC522_POOL_READERS
+#define MFRC522_POOL_READERS 4		// Readers per pool
+#endif
+#ifndef MFRC522_POOL_QUEUE
+#define MFRC522_POOL_QUEUE 4		// Queued requests per reader
+#endif
+
+class MFRC522Pool {
+public:
+	static constexpr byte MAX_READERS = MFRC522_POOL_READERS;
+	static constexpr byte QUEUE_SIZE = MFRC522_POOL_QUEUE;
+
+	enum Operation : byte {
+		OP_DETECT			,	// REQA, then select the PICC into the reader's uid
+		OP_AUTHENTICATE		,	// MFAuthent with key for blockAddr, on the selected PICC
+		OP_READ				,	// 16 bytes from blockAddr into buffer, which must hold 18
+		OP_WRITE			,	// 16 bytes from buffer to blockAddr
+		OP_HALT					// HLTA and PCD_StopCrypto1()
+	};
+
+	// Called from run() when a request completes. reader is the index returned by add().
+	typedef void (*Callback)(byte reader, Operation operation, MFRC522::StatusCode status, void *context);
+
+	typedef struct {
+		Operation operation;
+		byte blockAddr;
+		byte *buffer;
+		MFRC522::MIFARE_Key *key;
+		byte authCommand;		// PICC_CMD_MF_AUTH_KEY_A or PICC_CMD_MF_AUTH_KEY_B
+		Callback callback;
+		void *context;
+	} Request;
+
+	typedef struct {
+		uint32_t passes;					// run() calls
+		uint16_t completed[MAX_READERS];	// Requests completed per reader
+	} Stats;
+
+	MFRC522Pool();
+
+	byte add(MFRC522 *reader);
+	byte size() const { return _count; }
+	MFRC522 *reader(byte index) const { return _slots[index].reader; }
+
+	bool submit(byte reader, const Request &request);
+	bool detect(byte reader, Callback callback, void *context = nullptr);
+	bool authenticate(byte reader, byte blockAddr, MFRC522::MIFARE_Key *key, Callback callback, void *context = nullptr, byte authCommand = MFRC522::PICC_CMD_MF_AUTH_KEY_A);
+	bool read(byte reader, byte blockAddr, byte *buffer, Callback callback, void *context = nullptr);
+	bool write(byte reader, byte blockAddr, byte *buffer, Callback callback, void *context = nullptr);
+	bool halt(byte reader, Callback callback, void *context = nullptr);
+
+	void run();
+	byte pending(byte reader) const { return _slots[reader].queued; }
+	bool idle() const;
+	const Stats &stats() const { return _stats; }
+
+protected:
+	struct Slot {
+		MFRC522 *reader;
+		Request queue[QUEUE_SIZE];	// Ring buffer, the head is the request in flight once running is set
+		byte head;
+		byte queued;
+		bool running;
+		byte size;					// Buffer size for MIFARE_StartRead()
+	};
+
+	MFRC522::StatusCode start(Slot *slot);
+	void finish(byte index, MFRC522::StatusCode status);
+
+	Slot _slots[MAX_READERS];
+	byte _count;
+	byte _next;		// First reader of the next pass
+	Stats _stats;
+};
+
+#endif
@@ -0,0 +1,174 @@
+/**
+ * Host interfaces of the MFRC522, selected at compile time with MFRC522_TRANSPORT.
+ *
+ * Each transport is a plain class with the same inline member functions. The driver holds one
+ * as a member of type MFRC522Transport, so every register access is resolved by the compiler,
+ * there is no virtual dispatch. Register addresses are passed as the PCD_Register values,
+ * ie already shifted for SPI (datasheet section 8.1.2.3).
+ *
+ *   begin(chipSelectPin)		Prepare the interface.
+ *   beginTransaction()			Claim the bus for a run of accesses, endTransaction() releases it.
+ *   write(reg, count, values)	Write count bytes to one register, eg FIFODataReg.
+ *   read(reg, count, values)	Read count bytes from one register.
+ *   readFirst(reg), readNext(reg), readLast()
+ *								Read a chain of different registers. On SPI each address byte clocks out
+ *								the value of the previous one (section 8.1.2.1), so the chain costs one chip select.
+ *
+ * The host-native build (env:native_emu) uses the SPI transports, HostNative's SPI.h connects them to the emulator.
+ * Included by MFRC522.h, which defines MFRC522_SPICLOCK.
+ */
+#ifndef MFRC522_TRANSPORT_H
+#define MFRC522_TRANSPORT_H
+
+#include <stdint.h>
+#include <Arduino.h>
+#include <SPI.h>
+
+#define MFRC522_TRANSPORT_SPI		0	// SPI library, chip select through digitalWrite(). The original behaviour.
+#define MFRC522_TRANSPORT_SPI_FAST	1	// SPI library, chip select through direct port writes on AVR.
+#ifndef MFRC522_TRANSPORT
+#define MFRC522_TRANSPORT MFRC522_TRANSPORT_SPI
+#endif
+
+/**
+ * Chip select through digitalWrite().
+ */
+class MFRC522PinSelect {
+public:
+	void begin(uint8_t chipSelectPin) {
+		_chipSelectPin = chipSelectPin;
+		pinMode(_chipSelectPin, OUTPUT);
+	}
+	void select() {
+		digitalWrite(_chipSelectPin, LOW);
+	}
+	void deselect() {
+		digitalWrite(_chipSelectPin, HIGH);
+	}
+
+private:
+	uint8_t _chipSelectPin;
+};
+
+/**
+ * Chip select written straight to the port register. digitalWrite() looks up the port and checks
+ * for PWM on every call, which takes a few μs on an ATmega2560, twice per register access.
+ * Other architectures fall back to digitalWrite().
+ */
+#if defined(__AVR__)
+class MFRC522PortSelect {
+public:
+	void begin(uint8_t chipSelectPin) {
+		_port = portOutputRegister(digitalPinToPort(chipSelectPin));
+		_mask = digitalPinToBitMask(chipSelectPin);
+		pinMode(chipSelectPin, OUTPUT);
+	}
+	// The port may be shared with pins changed by interrupt handlers, so the read-modify-write runs with interrupts off.
+	void select() {
+		const uint8_t oldSREG = SREG;
+		cli();
+		*_port &= ~_mask;
+		SREG = oldSREG;
+	}
+	void deselect() {
+		const uint8_t oldSREG = SREG;
+		cli();
+		*_port |= _mask;
+		SREG = oldSREG;
+	}
+
+private:
+	volatile uint8_t *_port;
+	uint8_t _mask;
+};
+#else
+typedef MFRC522PinSelect MFRC522PortSelect;
+#endif
+
+/**
+ * SPI host interface, datasheet section 8.1.2.
+ *
+ * Multi-byte accesses are the inner loop of every FIFO fill and drain, so they are clocked as one
+ * block instead of one SPI.transfer() call per byte: reads pre-fill the buffer with the repeated
+ * address byte and transfer it in place, writes on AVR feed SPDR directly. Both keep the next byte
+ * ready the moment SPIF is set, so the FIFO moves at close to the MFRC522_SPICLOCK line rate.
+ */
+template <class ChipSelect>
+class MFRC522SpiTransportBase {
+public:
+	void begin(uint8_t chipSelectPin) {
+		_chipSelect.begin(chipSelectPin);
+		_chipSelect.deselect();				// Do not select the slave yet
+	}
+	void beginTransaction() {
+		SPI.beginTransaction(SPISettings(MFRC522_SPICLOCK, MSBFIRST, SPI_MODE0));	// Set the settings to work with SPI bus
+	}
+	void endTransaction() {
+		SPI.endTransaction();					// Stop using the SPI bus
+	}
+	void write(uint8_t reg, uint8_t count, const uint8_t *values) {
+		_chipSelect.select();
+		SPI.transfer(reg);						// MSB == 0 is for writing. LSB is not used in address.
+#if defined(__AVR__)
+		// SPI.transfer() has no write-only block form. The shift register is free as soon as SPIF is set,
+		// so the next byte is fetched while the current one is on the wire.
+		if (count) {
+			SPDR = *values++;
+			while (--count) {
+				const uint8_t out = *values++;
+				while (!(SPSR & _BV(SPIF)));
+				SPDR = out;
+			}
+			while (!(SPSR & _BV(SPIF)));
+			(void)SPDR;							// Clear SPIF
+		}
+#else
+		uint8_t buffer[16];						// SPI.transfer(buffer, count) overwrites the buffer with what it receives.
+		while (count) {
+			const uint8_t chunk = (count < sizeof(buffer)) ? count : sizeof(buffer);
+			memcpy(buffer, values, chunk);
+			SPI.transfer(buffer, chunk);
+			values += chunk;
+			count -= chunk;
+		}
+#endif
+		_chipSelect.deselect();
+	}
+	void read(uint8_t reg, uint8_t count, uint8_t *values) {	// count must be at least 1
+		const uint8_t address = 0x80 | reg;		// MSB == 1 is for reading. LSB is not used in address.
+		memset(values, address, count - 1);		// Tell that we want to read the same address again for every byte but the last.
+		values[count - 1] = 0;					// Send 0 to stop reading.
+		_chipSelect.select();
+		SPI.transfer(address);					// Tell MFRC522 which address we want to read
+		SPI.transfer(values, count);			// In place, each byte sent is replaced by the value clocked out.
+		_chipSelect.deselect();
+	}
+	void readFirst(uint8_t reg) {
+		_chipSelect.select();
+		SPI.transfer(0x80 | reg);
+	}
+	uint8_t readNext(uint8_t reg) {
+		return SPI.transfer(0x80 | reg);		// Returns the value of the previous address.
+	}
+	uint8_t readLast() {
+		const uint8_t value = SPI.transfer(0);	// Send 0 to stop reading.
+		_chipSelect.deselect();
+		return value;
+	}
+
+private:
+	ChipSelect _chipSelect;
+};
+
+typedef MFRC522SpiTransportBase<MFRC522PinSelect> MFRC522SpiTransport;
+typedef MFRC522SpiTransportBase<MFRC522PortSelect> MFRC522FastSpiTransport;
+
+#if MFRC522_TRANSPORT == MFRC522_TRANSPORT_SPI
+typedef MFRC522SpiTransport MFRC522Transport;
+#elif MFRC522_TRANSPORT == MFRC522_TRANSPORT_SPI_FAST
+typedef MFRC522FastSpiTransport MFRC522Transport;
+#else
+#error "Unknown MFRC522_TRANSPORT"
+#endif
+
+#endif // MFRC522_TRANSPORT_H
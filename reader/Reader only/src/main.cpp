@@ -3,9 +3,10 @@
  * Example sketch to read ASCII data from specific blocks of a MIFARE Classic 1K card,
  * assuming the data format written by the "NFC Password Manager" script. (Corrected Version)
  * --------------------------------------------------------------------------------------------------------------------
- * Reads data sequentially from blocks defined in `userDataBlocks`, skipping the header.
- * Uses default Key A (0xFFFFFFFFFFFF) for authentication.
- * Prints the payload data as ASCII characters to the Serial Monitor.
+ * Reads data sequentially from the data blocks of the card's layout (MifareClassicLayout), skipping the header.
+ * Finds the key of every sector in a small key dictionary (Key A and Key B) and remembers per card which one
+ * worked, in RAM and EEPROM, so a card seen before authenticates each sector in one attempt.
+ * Prints the payload data as ASCII characters to the Serial Monitor; for a vault card, the entries of its directory.
  * @license Released into the public domain.
  *
  * Pinout based on common setups (adjust for your board):
@@ -20,6 +21,8 @@
  #include <SPI.h>
  #include <MFRC522.h>
  #include <Arduino.h> // Include Arduino core for min()
+ #include "MifareClassicLayout.h"
+ #include "MifareKeyResolver.h"
  
  // --- Pin Definitions (Using Arduino Mega defaults) ---
  #define RST_PIN 5   // Configurable, adjust to your setup
@@ -28,27 +31,41 @@
  // --- Component Initialization ---
  MFRC522 mfrc522(SS_PIN, RST_PIN); // Create MFRC522 instance
  
- // --- MIFARE Classic 1K Configuration (Copied from Password Manager Script) ---
- const byte NUM_TOTAL_BLOCKS = 64;
+ // --- MIFARE Classic Configuration (Copied from Password Manager Script) ---
+ // Block maps of Mini/1K/4K come from MifareClassicLayout, picked per card by PICC_GetType().
  const byte BLOCK_SIZE = 16;
- const byte userDataBlocks[] = {
-      1,  2,      4,  5,  6,      8,  9, 10,     12, 13, 14,     // Sectors 0-3
-     16, 17, 18,     20, 21, 22,     24, 25, 26,     28, 29, 30,     // Sectors 4-7
-     32, 33, 34,     36, 37, 38,     40, 41, 42,     44, 45, 46,     // Sectors 8-11
-     48, 49, 50,     52, 53, 54,     56, 57, 58,     60, 61, 62      // Sectors 12-15
- };
- // Using int for NUM_USER_DATA_BLOCKS derived from sizeof is okay
- const int NUM_USER_DATA_BLOCKS = sizeof(userDataBlocks) / sizeof(userDataBlocks[0]);
- const byte HEADER_SIZE = 3; // 1 byte type + 2 bytes length
+ const int NUM_USER_DATA_BLOCKS = MifareClassicLayout::CLASSIC_1K.dataBlocks; // A password record stays within the 1K area
+ const byte HEADER_SIZE = 4; // 1 byte type + 2 bytes length + 1 byte high-water mark
+ const byte LEGACY_HEADER_SIZE = 3; // Type + length, cards written before the high-water mark
+ const byte HEADER_FLAG_HWM = 0x80; // Set in the type byte of a HEADER_SIZE header
+ // Vault cards: block 0 holds the version and the number of directory entries, the directory follows in two copies
+ const byte DATA_TYPE_VAULT = 0x03;
+ const byte VAULT_VERSION = 2;
+ const byte VAULT_ENTRY_SIZE = 8; // Slot id, flags, label hash (2), first block, length (2), reserved
+ const byte VAULT_MAX_ENTRIES = 48;
+ const byte VAULT_LABEL_SIZE = 16; // Label including its NUL: the first block of every entry
+ const byte VAULT_FLAG_ENCRYPTED = 0x01; // Label and password are AES-128 encrypted
+ const byte SLOT_COUNT = 2; // Directory copies A and B
+ const byte SLOT_HEADER_SIZE = 8; // Sequence (2), data type, length (2), slot index, CRC-16 (2); the rest of the block is zero
  // MAX_PAYLOAD_SIZE can be int, its value won't overflow standard int
  const int MAX_PAYLOAD_SIZE = (NUM_USER_DATA_BLOCKS * BLOCK_SIZE) - HEADER_SIZE; // Max possible payload
  
- // --- NFC Key ---
- MFRC522::MIFARE_Key key; // Default Key A (set in setup)
+ // --- NFC Keys ---
+ // Tried per sector as Key A, then as Key B. The first one that opens a sector is cached for the card.
+ MFRC522::MIFARE_Key keyDictionary[] = {
+     {{0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}}, // Factory default
+     {{0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5}}, // MIFARE Application Directory, Key A of sector 0
+     {{0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7}}, // NFC Forum, Key A of the NDEF sectors
+     {{0x00, 0x00, 0x00, 0x00, 0x00, 0x00}}
+ };
+ const int KEY_CACHE_EEPROM_ADDRESS = 0; // MifareKeyResolver::EEPROM_SIZE bytes
+ MifareKeyResolver keyResolver(mfrc522, keyDictionary, sizeof(keyDictionary) / sizeof(keyDictionary[0]));
  
  // --- Helper Function Prototypes ---
  bool authenticateBlock(byte blockAddr);
  bool readBlockFromNfc(byte blockAddr, byte buffer[], byte bufferSize);
+ bool readUserBlock(int blockIndex, byte buffer[], byte &lastAuthenticatedSector);
+ bool printVault(const byte header[], int dataBlockCount);
  
  
  // =========================================================================
@@ -67,11 +84,11 @@
      delay(4);             // Optional delay, helps prevent issues on some boards
      mfrc522.PCD_DumpVersionToSerial(); // Show reader details
  
-     // Set the default MIFARE Key A (all FFs)
-     for (byte i = 0; i < 6; i++) {
-         key.keyByte[i] = 0xFF;
+     // Keys that worked on earlier cards, kept across resets
+     if (keyResolver.enablePersistence(KEY_CACHE_EEPROM_ADDRESS)) {
+         Serial.println(F("Key cache loaded from EEPROM."));
      }
-     Serial.println(F("Using Default Key A (0xFFFFFFFFFFFF)"));
+     Serial.print(F("Key dictionary: ")); Serial.print(sizeof(keyDictionary) / sizeof(keyDictionary[0])); Serial.println(F(" keys, as Key A and Key B"));
      Serial.println(F("Scan a card..."));
      Serial.println();
  }
@@ -117,11 +134,16 @@
          // Continue anyway, but the read might fail or be incorrect
      }
  
+     // Block map of the card's layout; cards of unknown type are read as a 1K.
+     MifareClassicLayout::Layout layout = MifareClassicLayout::layoutOf(piccType);
+     if (layout.sectors == 0) layout = MifareClassicLayout::CLASSIC_1K;
+     const int userDataBlockCount = min((int)layout.dataBlocks, NUM_USER_DATA_BLOCKS);
+
      // --- Attempt to read the data ---
      byte firstBlockBuffer[18]; // Buffer for reading the first block (needs 18 bytes for MIFARE_Read)
      byte tempBlockBuffer[18]; // Buffer for reading subsequent blocks
      uint16_t storedPayloadLength = 0; // Use uint16_t for length
-     byte firstUserBlockAddr = userDataBlocks[0]; // Should be block 1
+     byte firstUserBlockAddr = MifareClassicLayout::blockAt(0); // Should be block 1
  
      Serial.println(F("Attempting to read header from first user block..."));
  
@@ -148,9 +170,22 @@
          return;
      }
  
+     // A vault card holds no single payload: list its directory instead.
+     if ((firstBlockBuffer[0] & ~HEADER_FLAG_HWM) == DATA_TYPE_VAULT) {
+         printVault(firstBlockBuffer, layout.dataBlocks);
+         mfrc522.PICC_HaltA();
+         mfrc522.PCD_StopCrypto1();
+         Serial.println(F("Card Released. Waiting for next card..."));
+         Serial.println(F("*********************************************************************"));
+         Serial.println();
+         delay(2000);
+         return;
+     }
+
      // Parse the header to get the payload length (ignore data type byte 0)
      // Length is stored Little Endian (LSB first) in bytes 1 and 2
      storedPayloadLength = (uint16_t)(firstBlockBuffer[2] << 8) | firstBlockBuffer[1];
+     const byte headerSize = (firstBlockBuffer[0] & HEADER_FLAG_HWM) ? HEADER_SIZE : LEGACY_HEADER_SIZE;
  
      Serial.print(F("Header Found: Type=0x")); Serial.print(firstBlockBuffer[0], HEX);
      Serial.print(F(", Stored Payload Length=")); Serial.println(storedPayloadLength);
@@ -180,10 +215,10 @@
  
          // Print payload data from the first block (bytes after the header)
          // CORRECTED: Use uint16_t for comparison in min()
-         uint16_t bytesToPrintFromFirstBlock = min((uint16_t)(BLOCK_SIZE - HEADER_SIZE), storedPayloadLength);
+         uint16_t bytesToPrintFromFirstBlock = min((uint16_t)(BLOCK_SIZE - headerSize), storedPayloadLength);
          for (uint16_t i = 0; i < bytesToPrintFromFirstBlock; i++) { // Also use uint16_t for loop counter
-             if (isprint(firstBlockBuffer[HEADER_SIZE + i])) {
-                  Serial.print((char)firstBlockBuffer[HEADER_SIZE + i]);
+             if (isprint(firstBlockBuffer[headerSize + i])) {
+                  Serial.print((char)firstBlockBuffer[headerSize + i]);
              } else {
                   Serial.print('.'); // Replace non-printable chars with a dot
              }
@@ -192,9 +227,9 @@
  
          // Read and print data from subsequent user data blocks
          // CORRECTED: Loop condition compares uint16_t with uint16_t
-         for (int blockIndex = 1; blockIndex < NUM_USER_DATA_BLOCKS && bytesPrinted < storedPayloadLength; blockIndex++) {
-             byte currentBlockAddr = userDataBlocks[blockIndex];
-             byte currentSector = currentBlockAddr / 4;
+         for (int blockIndex = 1; blockIndex < userDataBlockCount && bytesPrinted < storedPayloadLength; blockIndex++) {
+             byte currentBlockAddr = MifareClassicLayout::blockAt(blockIndex);
+             byte currentSector = MifareClassicLayout::sectorOf(currentBlockAddr);
  
              // Authenticate if we've moved to a new sector
              if (currentSector != lastAuthenticatedSector) {
@@ -260,22 +295,23 @@
  // =========================================================================
  
  /**
-  * @brief Authenticates the sector containing the specified block address using Key A.
-  * Assumes 'key' and 'mfrc522' objects are globally accessible.
+  * @brief Authenticates the sector containing the specified block address with the key cached for this card,
+  * or the first key of keyDictionary that works.
+  * Assumes 'keyResolver' and 'mfrc522' objects are globally accessible.
   *
   * @param blockAddr The block address within the sector to authenticate.
   * @return true on success, false on failure.
   */
  bool authenticateBlock(byte blockAddr) {
-     byte sector = blockAddr / 4;
-     byte trailerBlock = sector * 4 + 3; // Calculate sector trailer block
+     byte sector = MifareClassicLayout::sectorOf(blockAddr);
+     byte trailerBlock = MifareClassicLayout::trailerOf(sector); // Last block of the sector, 4 or 16 blocks
      MFRC522::StatusCode status;
  
      // Uncomment for debugging authentication attempts
      // Serial.print(F("Authenticating sector ")); Serial.print(sector);
      // Serial.print(F(" (trailer block ")); Serial.print(trailerBlock); Serial.println(F(")..."));
  
-     status = mfrc522.PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, trailerBlock, &key, &(mfrc522.uid));
+     status = keyResolver.authenticate(sector, trailerBlock);
  
      if (status != MFRC522::STATUS_OK) {
          Serial.print(F("PCD_Authenticate() failed: "));
@@ -316,4 +352,108 @@
      // Uncomment for debugging read attempts
      // Serial.print(F("Successfully read block ")); Serial.println(blockAddr);
      return true;
- }
\ No newline at end of file
+ }
+
+ /**
+  * @brief Reads data block blockIndex of the card's layout, authenticating its sector unless it is lastAuthenticatedSector.
+  *
+  * @param blockIndex Index into the block map, 0 is the header block.
+  * @param buffer At least 18 bytes, see readBlockFromNfc().
+  * @param lastAuthenticatedSector Sector the session is authenticated for, updated here.
+  * @return true on success, false on failure.
+  */
+ bool readUserBlock(int blockIndex, byte buffer[], byte &lastAuthenticatedSector) {
+     const byte blockAddr = MifareClassicLayout::blockAt(blockIndex);
+     const byte sector = MifareClassicLayout::sectorOf(blockAddr);
+     if (sector != lastAuthenticatedSector) {
+         if (!authenticateBlock(blockAddr)) return false;
+         lastAuthenticatedSector = sector;
+     }
+     return readBlockFromNfc(blockAddr, buffer, 18);
+ }
+
+ // CRC-16/CCITT-FALSE, continued from crc, as the firmware computes it over a directory copy.
+ uint16_t crc16(uint16_t crc, const byte data[], uint16_t length) {
+     while (length--) {
+         crc ^= (uint16_t)(*data++) << 8;
+         for (byte bit = 0; bit < 8; bit++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+     }
+     return crc;
+ }
+
+ /**
+  * @brief Lists the entries of a vault card: slot id, length and label of each. The directory is in two copies, A and
+  * B, each a slot header block in front of its entries; the newer copy whose CRC matches is listed. Labels of
+  * encrypted entries are not shown, this sketch has no AES key. Sector 0 must be authenticated.
+  *
+  * @param header Block 0 of the user area.
+  * @param dataBlockCount Data blocks of the card's layout.
+  * @return true if a directory copy was listed, false otherwise.
+  */
+ bool printVault(const byte header[], int dataBlockCount) {
+     const byte capacity = header[5];
+     const byte directoryBlocks = (capacity * VAULT_ENTRY_SIZE + BLOCK_SIZE - 1) / BLOCK_SIZE;
+     const uint16_t directoryLength = capacity * VAULT_ENTRY_SIZE;
+     if (header[4] != VAULT_VERSION || capacity == 0 || capacity > VAULT_MAX_ENTRIES || 1 + SLOT_COUNT * (1 + directoryBlocks) > dataBlockCount) {
+         Serial.print(F("Vault card with an invalid header: version ")); Serial.print(header[4]);
+         Serial.print(F(", ")); Serial.print(capacity); Serial.println(F(" entries"));
+         return false;
+     }
+
+     // Header blocks of both copies; a copy is plausible if it is for its index, the vault and this directory size.
+     byte lastAuthenticatedSector = 0;
+     byte copyHeaders[SLOT_COUNT][18];
+     bool plausible[SLOT_COUNT];
+     for (byte copy = 0; copy < SLOT_COUNT; copy++) {
+         plausible[copy] = readUserBlock(1 + copy * (1 + directoryBlocks), copyHeaders[copy], lastAuthenticatedSector);
+         const byte *block = copyHeaders[copy];
+         plausible[copy] = plausible[copy] && block[5] == copy && block[2] == DATA_TYPE_VAULT && ((uint16_t)(block[4] << 8) | block[3]) == directoryLength;
+         for (byte i = SLOT_HEADER_SIZE; i < BLOCK_SIZE; i++) plausible[copy] = plausible[copy] && block[i] == 0;
+     }
+     const uint16_t sequenceA = (uint16_t)(copyHeaders[0][1] << 8) | copyHeaders[0][0];
+     const uint16_t sequenceB = (uint16_t)(copyHeaders[1][1] << 8) | copyHeaders[1][0];
+     const byte newer = (plausible[1] && (!plausible[0] || (int16_t)(sequenceB - sequenceA) > 0)) ? 1 : 0;
+
+     byte directory[VAULT_MAX_ENTRIES * VAULT_ENTRY_SIZE];
+     byte block[18];
+     for (byte n = 0; n < SLOT_COUNT; n++) {
+         const byte copy = n ? 1 - newer : newer;
+         if (!plausible[copy]) continue;
+         const byte *copyHeader = copyHeaders[copy];
+         bool complete = true;
+         for (byte i = 0; i < directoryBlocks && complete; i++) {
+             complete = readUserBlock(2 + copy * (1 + directoryBlocks) + i, block, lastAuthenticatedSector);
+             memcpy(directory + i * BLOCK_SIZE, block, min((uint16_t)BLOCK_SIZE, (uint16_t)(directoryLength - i * BLOCK_SIZE)));
+         }
+         if (!complete) continue;
+         const uint16_t crc = crc16(crc16(0xFFFF, copyHeader, 6), directory, directoryLength);
+         if (crc != ((uint16_t)(copyHeader[7] << 8) | copyHeader[6])) {
+             Serial.print(F("Directory ")); Serial.print((char)('A' + copy)); Serial.println(F(": CRC mismatch, write was cut short"));
+             continue;
+         }
+
+         byte count = 0;
+         for (byte position = 0; position < capacity; position++) if (directory[position * VAULT_ENTRY_SIZE] != 0) count++;
+         Serial.print(F("Vault card, ")); Serial.print(count); Serial.print(F("/")); Serial.print(capacity);
+         Serial.print(F(" entries (directory ")); Serial.print((char)('A' + copy)); Serial.print(F(", sequence "));
+         Serial.print((uint16_t)(copyHeader[1] << 8) | copyHeader[0]); Serial.println(F(")"));
+         for (byte position = 0; position < capacity; position++) {
+             const byte *entry = directory + position * VAULT_ENTRY_SIZE;
+             if (entry[0] == 0) continue;
+             const uint16_t length = (uint16_t)(entry[6] << 8) | entry[5];
+             Serial.print(F("  Slot id ")); Serial.print(entry[0]);
+             Serial.print(F(": block ")); Serial.print(entry[4]); Serial.print(F(", ")); Serial.print(length); Serial.print(F(" bytes, label "));
+             if (entry[1] & VAULT_FLAG_ENCRYPTED) {
+                 Serial.println(F("(encrypted)"));
+             } else if (entry[4] < dataBlockCount && readUserBlock(entry[4], block, lastAuthenticatedSector)) {
+                 for (byte i = 0; i < VAULT_LABEL_SIZE && block[i] != 0; i++) Serial.print(isprint(block[i]) ? (char)block[i] : '.');
+                 Serial.println();
+             } else {
+                 Serial.println(F("(unreadable)"));
+             }
+         }
+         return true;
+     }
+     Serial.println(F("Vault card: neither directory copy is valid."));
+     return false;
+ }
@@ -0,0 +1,143 @@
+// Duty-cycled card presence detection on top of MFRC522.
+#include "CardPresenceDetector.h"
+
+CardPresenceDetector::CardPresenceDetector(MFRC522 &reader, uint16_t periodMillis, byte burstLength,
+                                           IdleMode idleMode, byte settleMillis)
+    : _reader(reader), _periodMillis(periodMillis), _burstLength(burstLength ? burstLength : 1), _idleMode(idleMode),
+      _settleMillis(settleMillis), _state(STATE_STOPPED), _burstRequests(0), _request(MFRC522::STATUS_OK) {
+    resetStats();
+}
+
+void CardPresenceDetector::begin() {
+    if (_state != STATE_STOPPED) {
+        return;
+    }
+    _beganAt = micros();
+    _emptyAt = _beganAt;
+    _burstAt = _beganAt;
+    _fieldOnAt = _beganAt;
+    _stats.bursts++;
+    _burstRequests = 0;
+    startRequest();
+}
+
+// The first REQA of a burst also resets the modulation settings, as PICC_IsNewCardPresent() does.
+void CardPresenceDetector::startRequest() {
+    if (_burstRequests == 0) {
+        _request = _reader.PICC_StartIsNewCardPresent();
+    } else {
+        _atqaSize = sizeof(_atqa);
+        _request = _reader.PICC_StartREQA_or_WUPA(MFRC522::PICC_CMD_REQA, _atqa, &_atqaSize);
+    }
+    _burstRequests++;
+    _stats.requests++;
+    _state = STATE_REQUESTING;
+}
+
+/**
+ * @brief Advances the duty cycle by at most one step. Costs no SPI traffic while the field is off.
+ * @return true if a card answered. The reader then holds it in READY, the detector is stopped.
+ */
+bool CardPresenceDetector::poll() {
+    if (_state == STATE_STOPPED) {
+        begin();
+    }
+    const uint32_t now = micros();
+    switch (_state) {
+        case STATE_SLEEPING:
+            if (now - _burstAt >= _periodMillis * 1000UL) {
+                _burstAt = now;
+                _stats.bursts++;
+                fieldOn();
+                _state = STATE_SETTLING;
+            }
+            return false;
+        case STATE_SETTLING:
+            if (now - _fieldOnAt >= _settleMillis * 1000UL) {
+                _burstRequests = 0;
+                startRequest();
+            }
+            return false;
+        case STATE_REQUESTING: {
+            MFRC522::StatusCode status = _request;
+            if (status == MFRC522::STATUS_PENDING) {
+                status = _reader.PCD_Poll();
+                if (status == MFRC522::STATUS_PENDING) {
+                    return false;
+                }
+            }
+            if (status == MFRC522::STATUS_OK || status == MFRC522::STATUS_COLLISION) {
+                const uint32_t latency = now - _emptyAt;
+                _stats.detections++;
+                _stats.lastDetectMicros = latency;
+                _stats.totalDetectMicros += latency;
+                if (latency > _stats.maxDetectMicros) {
+                    _stats.maxDetectMicros = latency;
+                }
+                stop(now);
+                return true;
+            }
+            if (_burstRequests < _burstLength) {
+                startRequest();
+                return false;
+            }
+            // Nobody answered: field off until the next burst.
+            _emptyAt = now;
+            fieldOff(now);
+            _state = STATE_SLEEPING;
+            return false;
+        }
+        default:
+            return false;
+    }
+}
+
+void CardPresenceDetector::end() {
+    if (_state == STATE_STOPPED) {
+        return;
+    }
+    _reader.PCD_Abort();
+    if (_state == STATE_SLEEPING) {
+        fieldOn();
+    }
+    stop(micros());
+}
+
+// Leaves the field on. The time since it was switched on counts as RF-on time.
+void CardPresenceDetector::stop(uint32_t now) {
+    _stats.rfOnMicros += now - _fieldOnAt;
+    _stats.waitMicros += now - _beganAt;
+    _state = STATE_STOPPED;
+}
+
+void CardPresenceDetector::fieldOn() {
+    if (_idleMode == IDLE_SOFT_POWER_DOWN) {
+        _reader.PCD_SoftPowerUp();  // Returns once the oscillator runs; TxControlReg still has the antenna on
+    } else {
+        _reader.PCD_AntennaOn();
+    }
+    _fieldOnAt = micros();
+}
+
+void CardPresenceDetector::fieldOff(uint32_t now) {
+    _stats.rfOnMicros += now - _fieldOnAt;
+    if (_idleMode == IDLE_SOFT_POWER_DOWN) {
+        _reader.PCD_SoftPowerDown();
+    } else {
+        _reader.PCD_AntennaOff();
+    }
+}
+
+/**
+ * @brief Share of the waiting time with the field on, in 1/1000. Proportional to the average RF current.
+ */
+uint16_t CardPresenceDetector::rfDutyPermille() const {
+    if (_stats.waitMicros == 0) {
+        return 0;
+    }
+    return (uint16_t)(((uint64_t)_stats.rfOnMicros * 1000) / _stats.waitMicros);
+}
+
+uint32_t CardPresenceDetector::averageDetectMicros() const {
+    return _stats.detections ? _stats.totalDetectMicros / _stats.detections : 0;
+}
@@ -0,0 +1,77 @@
+// Retry policy and differential writes shared by the card sessions.
+#include "CardSession.h"
+
+/**
+ * @brief Decides whether a failed block or page operation is tried again, and brings the card back for it.
+ * Any error in an exchange sends the card back to IDLE (HALT if it was woken from there), so it is woken up and
+ * selected by its UID (PICC_Reselect(), no anticollision). The caller then authenticates again, for MIFARE Classic
+ * only the sector of the failed block, and resumes with that block.
+ * Argument and buffer errors are not retried, neither is a card that does not answer the reselect or has
+ * been swapped for another one.
+ */
+bool CardSession::recover(MFRC522 &reader, MFRC522::StatusCode status, byte attempt) {
+    if (status == MFRC522::STATUS_INVALID || status == MFRC522::STATUS_NO_ROOM || status == MFRC522::STATUS_INTERNAL_ERROR
+        || attempt + 1 >= _attempts) {
+        _retryStats.failures++;
+        return false;
+    }
+    _retryStats.retries++;
+    delay((uint32_t)_backoffMillis << attempt);
+    // A card that lost only the answer is still ACTIVE: the first WUPA sends it back to IDLE unanswered, the second wakes it.
+    const MFRC522::Uid previous = reader.uid;
+    for (byte i = 0; i < 2; i++) {
+        if (reader.PICC_Reselect(&reader.uid) != MFRC522::STATUS_OK) {
+            continue;
+        }
+        if (reader.uid.size == previous.size && memcmp(reader.uid.uidByte, previous.uidByte, previous.size) == 0) {
+            _retryStats.reselects++;
+            return true;
+        }
+        reader.PICC_HaltA();    // The fallback anticollision found another card
+        reader.uid = previous;
+        break;
+    }
+    _retryStats.failures++;
+    return false;
+}
+
+MFRC522::StatusCode CardSession::readStream(uint16_t offset, byte buffer[], uint16_t length, StreamHandler handler, void *context) {
+    MFRC522::StatusCode status = readRange(offset, buffer, length);
+    if (status == MFRC522::STATUS_OK) {
+        handler(length, context);
+    }
+    return status;
+}
+
+/**
+ * @brief Writes length bytes at offset, skipping every write unit (block or page) that already holds them.
+ * The card is read UPDATE_CHUNK bytes at a time to compare: a read is a fraction of the time of a write, which also
+ * waits for the EEPROM programming. Rewriting data that did not change costs only the reads.
+ */
+MFRC522::StatusCode CardSession::updateRange(uint16_t offset, const byte buffer[], uint16_t length, uint16_t *written) {
+    byte current[UPDATE_CHUNK];
+    const byte unit = writeUnit();
+    if (written) *written = 0;
+    while (length > 0) {
+        const uint16_t chunk = min((uint16_t)(UPDATE_CHUNK - offset % UPDATE_CHUNK), length);
+        MFRC522::StatusCode status = readRange(offset, current, chunk);
+        if (status != MFRC522::STATUS_OK) {
+            return status;
+        }
+        for (uint16_t position = 0; position < chunk; ) {
+            const uint16_t part = min((uint16_t)(unit - (offset + position) % unit), (uint16_t)(chunk - position));
+            if (memcmp(current + position, buffer + position, part) != 0) {
+                status = writeRange(offset + position, buffer + position, part);
+                if (status != MFRC522::STATUS_OK) {
+                    return status;
+                }
+                if (written) (*written)++;
+            }
+            position += part;
+        }
+        buffer += chunk;
+        offset += chunk;
+        length -= chunk;
+    }
+    return MFRC522::STATUS_OK;
+}
@@ -0,0 +1,226 @@
+// MIFARE Classic access on top of MFRC522 with authentication tracking.
+#include "MifareClassicSession.h"
+
+MifareClassicSession::MifareClassicSession(MFRC522 &reader, MFRC522::MIFARE_Key &key, const byte *blocks, byte blockCount,
+                                           MFRC522::PICC_Command authCommand, MifareKeyResolver *resolver)
+    : _reader(reader), _key(key), _blocks(blocks), _blockCount(blockCount), _authCommand(authCommand), _resolver(resolver), _sector(NO_SECTOR) {
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+MFRC522::StatusCode MifareClassicSession::begin() {
+    _sector = NO_SECTOR;
+    memset(&_stats, 0, sizeof(_stats));
+    resetRetryStats();
+    return MFRC522::STATUS_OK;
+}
+
+void MifareClassicSession::end() {
+    _reader.PICC_HaltA();
+    _reader.PCD_StopCrypto1();
+    _sector = NO_SECTOR;
+}
+
+/**
+ * @brief Authenticates the sector of blockAddr, unless its Crypto1 session is still open.
+ * A failed authentication leaves the card without a session (it goes back to IDLE). With a key resolver the
+ * card is selected again after every key that fails.
+ */
+MFRC522::StatusCode MifareClassicSession::authenticate(byte blockAddr) {
+    const byte sector = sectorOf(blockAddr);
+    if (sector == _sector) {
+        return MFRC522::STATUS_OK;
+    }
+    _stats.authentications++;
+    MFRC522::StatusCode status = _resolver ? _resolver->authenticate(sector, trailerOf(sector))
+                                           : _reader.PCD_Authenticate(_authCommand, trailerOf(sector), &_key, &_reader.uid);
+    _sector = (status == MFRC522::STATUS_OK) ? sector : NO_SECTOR;
+    return status;
+}
+
+// Any error in an encrypted exchange ends the Crypto1 session on the card. The block is tried again after
+// recover() selected the card again, with a new authentication of its sector.
+MFRC522::StatusCode MifareClassicSession::readBlock(byte blockAddr, byte buffer[18], byte firstAttempt) {
+    for (byte attempt = firstAttempt; ; attempt++) {
+        MFRC522::StatusCode status = authenticate(blockAddr);
+        if (status == MFRC522::STATUS_OK) {
+            byte size = 18;
+            status = _reader.MIFARE_Read(blockAddr, buffer, &size);
+            if (status == MFRC522::STATUS_OK) {
+                _stats.blockReads++;
+                return MFRC522::STATUS_OK;
+            }
+        }
+        _sector = NO_SECTOR;
+        if (!recover(_reader, status, attempt)) {
+            return status;
+        }
+    }
+}
+
+MFRC522::StatusCode MifareClassicSession::writeBlock(byte blockAddr, byte buffer[BLOCK_SIZE]) {
+    for (byte attempt = 0; ; attempt++) {
+        MFRC522::StatusCode status = authenticate(blockAddr);
+        if (status == MFRC522::STATUS_OK) {
+            status = _reader.MIFARE_Write(blockAddr, buffer, BLOCK_SIZE);
+            if (status == MFRC522::STATUS_OK) {
+                _stats.blockWrites++;
+                _stats.bytesWritten += BLOCK_SIZE;
+                return MFRC522::STATUS_OK;
+            }
+        }
+        _sector = NO_SECTOR;
+        if (!recover(_reader, status, attempt)) {
+            return status;
+        }
+    }
+}
+
+/**
+ * @brief Reads every block of a sector except the trailer, with one authentication.
+ * @param bufferSize Must hold (blocksIn(sector) - 1) * 16 bytes.
+ */
+MFRC522::StatusCode MifareClassicSession::readSector(byte sector, byte buffer[], uint16_t bufferSize) {
+    BusyTimer timer(_stats.busyMicros);
+    const byte dataBlocks = blocksIn(sector) - 1;
+    if (bufferSize < (uint16_t)dataBlocks * BLOCK_SIZE) {
+        return MFRC522::STATUS_NO_ROOM;
+    }
+    byte blockBuffer[18];
+    for (byte i = 0; i < dataBlocks; i++) {
+        MFRC522::StatusCode status = readBlock(firstBlockOf(sector) + i, blockBuffer);
+        if (status != MFRC522::STATUS_OK) {
+            return status;
+        }
+        memcpy(buffer + i * BLOCK_SIZE, blockBuffer, BLOCK_SIZE);
+        _stats.bytesRead += BLOCK_SIZE;
+    }
+    return MFRC522::STATUS_OK;
+}
+
+/**
+ * @brief Reads length bytes starting at offset of the logical address space.
+ */
+MFRC522::StatusCode MifareClassicSession::readRange(uint16_t offset, byte buffer[], uint16_t length) {
+    BusyTimer timer(_stats.busyMicros);
+    if ((uint32_t)offset + length > capacity()) {
+        return MFRC522::STATUS_INVALID;
+    }
+    byte blockBuffer[18];
+    while (length > 0) {
+        const byte index = offset / BLOCK_SIZE;
+        const byte skip = offset % BLOCK_SIZE;
+        const uint16_t chunk = min((uint16_t)(BLOCK_SIZE - skip), length);
+        MFRC522::StatusCode status = readBlock(blockAt(index), blockBuffer);
+        if (status != MFRC522::STATUS_OK) {
+            return status;
+        }
+        memcpy(buffer, blockBuffer + skip, chunk);
+        _stats.bytesRead += chunk;
+        buffer += chunk;
+        offset += chunk;
+        length -= chunk;
+    }
+    return MFRC522::STATUS_OK;
+}
+
+/**
+ * @brief readRange() that lets the caller work on the data while the card is still being read.
+ * Each block read is started with MIFARE_StartRead(), then handler runs on what the blocks before it brought, then
+ * the read is finished: the handler's work (eg decryption) overlaps the RF exchange instead of following it.
+ * A block whose read fails is read again as in readRange(), after recover().
+ */
+MFRC522::StatusCode MifareClassicSession::readStream(uint16_t offset, byte buffer[], uint16_t length, StreamHandler handler, void *context) {
+    BusyTimer timer(_stats.busyMicros);
+    if ((uint32_t)offset + length > capacity()) {
+        return MFRC522::STATUS_INVALID;
+    }
+    byte blockBuffer[18];
+    uint16_t received = 0;
+    while (received < length) {
+        const byte index = (offset + received) / BLOCK_SIZE;
+        const byte skip = (offset + received) % BLOCK_SIZE;
+        const uint16_t chunk = min((uint16_t)(BLOCK_SIZE - skip), (uint16_t)(length - received));
+        byte size = sizeof(blockBuffer);
+        MFRC522::StatusCode status = authenticate(blockAt(index));
+        if (status == MFRC522::STATUS_OK) {
+            status = _reader.MIFARE_StartRead(blockAt(index), blockBuffer, &size);
+        }
+        if (status == MFRC522::STATUS_PENDING) {
+            if (received > 0) {
+                handler(received, context);
+            }
+            while ((status = _reader.PCD_Poll()) == MFRC522::STATUS_PENDING) {
+                yield();
+            }
+        }
+        if (status == MFRC522::STATUS_OK) {
+            _stats.blockReads++;
+        } else {
+            _sector = NO_SECTOR;
+            if (!recover(_reader, status, 0) || (status = readBlock(blockAt(index), blockBuffer, 1)) != MFRC522::STATUS_OK) {
+                return status;
+            }
+        }
+        memcpy(buffer + received, blockBuffer + skip, chunk);
+        _stats.bytesRead += chunk;
+        received += chunk;
+    }
+    handler(received, context);
+    return MFRC522::STATUS_OK;
+}
+
+// Writes chunk bytes at skip into the block at index of the block map, keeping the rest of the block.
+MFRC522::StatusCode MifareClassicSession::writePart(byte index, byte skip, const byte buffer[], byte chunk) {
+    byte blockBuffer[18];
+    if (chunk < BLOCK_SIZE) {
+        MFRC522::StatusCode status = readBlock(blockAt(index), blockBuffer);
+        if (status != MFRC522::STATUS_OK) {
+            return status;
+        }
+        _stats.bytesRead += BLOCK_SIZE;
+    }
+    memcpy(blockBuffer + skip, buffer, chunk);
+    return writeBlock(blockAt(index), blockBuffer);
+}
+
+/**
+ * @brief Writes length bytes starting at offset of the logical address space.
+ * Blocks only partly covered by the range are read first, so the bytes around it are kept.
+ * Blocks in the sector that is still open, eg from a read just before, are written first,
+ * so that sector is not authenticated a second time. The others follow in address order.
+ */
+MFRC522::StatusCode MifareClassicSession::writeRange(uint16_t offset, const byte buffer[], uint16_t length) {
+    BusyTimer timer(_stats.busyMicros);
+    if ((uint32_t)offset + length > capacity()) {
+        return MFRC522::STATUS_INVALID;
+    }
+    const byte openSector = _sector;
+    const uint16_t end = offset + length;
+    for (byte pass = 0; pass < 2; pass++) {
+        uint16_t position = offset;
+        while (position < end) {
+            const byte index = position / BLOCK_SIZE;
+            const byte skip = position % BLOCK_SIZE;
+            const byte chunk = min((uint16_t)(BLOCK_SIZE - skip), (uint16_t)(end - position));
+            const bool inOpenSector = sectorOf(blockAt(index)) == openSector;
+            if (inOpenSector == (pass == 0)) {
+                MFRC522::StatusCode status = writePart(index, skip, buffer + (position - offset), chunk);
+                if (status != MFRC522::STATUS_OK) {
+                    return status;
+                }
+            }
+            position += chunk;
+        }
+    }
+    return MFRC522::STATUS_OK;
+}
+
+/**
+ * @brief Data bytes moved per second of session time, 0 before the first transfer.
+ */
+uint32_t MifareClassicSession::bytesPerSecond() const {
+    if (_stats.busyMicros == 0) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)(_stats.bytesRead + _stats.bytesWritten) * 1000000UL) / _stats.busyMicros);
+}
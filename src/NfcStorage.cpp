@@ -0,0 +1,751 @@
+// NFC user data area: MIFARE Classic / NTAG21x read/write helpers and the header + payload format.
+#include "NfcStorage.h"
+#include <AESLib.h>
+
+// --- MIFARE Classic keys: the one that worked per card and sector is tried first ---
+MifareKeyResolver keyResolver(mfrc522, keyDictionary, KEY_DICTIONARY_SIZE);
+
+// --- Card Sessions ---
+MifareClassicSession classicSession(mfrc522, key, MifareClassicLayout::blockMap(), MifareClassicLayout::CLASSIC_1K.dataBlocks, MFRC522::PICC_CMD_MF_AUTH_KEY_A, &keyResolver);
+static MifareClassicLayout::Layout classicLayout = MifareClassicLayout::CLASSIC_1K; // Of the current card
+NtagSession ntagSession(mfrc522, ntag_password);
+CardSession *cardSession = &classicSession;
+
+// --- Waiting for a card: REQA burst every 100 ms, MFRC522 in soft power-down in between ---
+CardPresenceDetector cardDetector(mfrc522);
+
+// --- Vault of the current card, see the Credential Vault section ---
+static VaultEntry vaultDirectory[VAULT_MAX_ENTRIES]; // By directory position
+static byte vaultCapacity = 0; // Directory entries of the open vault, 0 while none is open
+static byte vaultCount; // Used directory entries
+static byte vaultNextSlotId; // Where freeVaultSlotId() starts looking
+static uint16_t vaultSequence; // Of the current directory copy
+static byte vaultCopy; // Current directory copy, 0 for A
+static byte vaultStale; // Directory position where the other copy differs from the current one, 0xFF if not known
+
+// =========================================================================
+// NFC Card Interaction Functions (Unchanged)
+// =========================================================================
+// Starts the session for the type of the selected card: NTAG21x for SAK 0x00, MIFARE Classic otherwise, with the
+// block map of its layout (1K for unknown types).
+static bool beginSession() { vaultCapacity = 0; MFRC522::PICC_Type piccType = mfrc522.PICC_GetType(mfrc522.uid.sak); if (piccType == MFRC522::PICC_TYPE_MIFARE_UL) cardSession = &ntagSession; else { classicLayout = MifareClassicLayout::layoutOf(piccType); if (classicLayout.sectors == 0) classicLayout = MifareClassicLayout::CLASSIC_1K; classicSession.setBlocks(MifareClassicLayout::blockMap(), classicLayout.dataBlocks); cardSession = &classicSession; } MFRC522::StatusCode status = cardSession->begin(); if (status != MFRC522::STATUS_OK) { Serial.print(F("Card not supported: ")); Serial.println(mfrc522.GetStatusCodeName(status)); return false; } return true; }
+// Selects the card that answered the REQA and starts a session on it.
+static bool selectCard() { if (!mfrc522.PICC_ReadCardSerial()) { Serial.println("Failed to read card serial."); return false; } Serial.print(F("Card Found! UID:")); for (byte i = 0; i < mfrc522.uid.size; i++) { Serial.print(mfrc522.uid.uidByte[i] < 0x10 ? " 0" : " "); Serial.print(mfrc522.uid.uidByte[i], HEX); } Serial.println(); MFRC522::PICC_Type piccType = mfrc522.PICC_GetType(mfrc522.uid.sak); Serial.print(F("PICC type: ")); Serial.println(mfrc522.PICC_GetTypeName(piccType)); if (piccType != MFRC522::PICC_TYPE_MIFARE_MINI && piccType != MFRC522::PICC_TYPE_MIFARE_1K && piccType != MFRC522::PICC_TYPE_MIFARE_4K && piccType != MFRC522::PICC_TYPE_MIFARE_UL) { Serial.println(F("Warning: Card type not MIFARE Classic or NTAG.")); } return beginSession(); }
+bool initializeCardInteraction() { if (!mfrc522.PICC_IsNewCardPresent()) return false; return selectCard(); }
+
+// Time to detect and RF duty of the waits so far.
+static void printDetectStats() {
+    Serial.print(F("Detect: ")); Serial.print(cardDetector.stats().lastDetectMicros / 1000);
+    Serial.print(F(" ms, RF duty ")); Serial.print(cardDetector.rfDutyPermille()); Serial.println(F(" permille"));
+}
+
+/**
+ * @brief Non-blocking initializeCardInteraction() for loop(), duty-cycled by cardDetector.
+ * The field is only on for short REQA bursts while waiting; a card that answered is selected (blocking, ~2 ms).
+ */
+bool pollCardInteraction() {
+    if (!cardDetector.poll()) return false;
+    printDetectStats();
+    return selectCard();
+}
+void cancelCardInteraction() { cardDetector.end(); }
+
+/**
+ * @brief Batch mode for a stack of cards on the reader: one inventory of every card in the field, then select,
+ * process and halt each card in turn. Processed cards stay halted, so the next call only finds new ones.
+ * @param process Called with the card selected and cardSession started on it; returns true on success.
+ * @return Number of cards process succeeded on.
+ */
+byte processAllCards(bool (*process)(void *context), void *context) {
+    const uint32_t start = millis();
+    MFRC522::Uid uids[MAX_BATCH_CARDS];
+    byte count;
+    MFRC522::StatusCode status = mfrc522.PICC_Inventory(uids, MAX_BATCH_CARDS, &count);
+    // NO_ROOM: the others are left for the next call. Any other error leaves cards out, the ones found are processed.
+    if (status != MFRC522::STATUS_OK && status != MFRC522::STATUS_NO_ROOM) { Serial.print(F("Batch: inventory incomplete: ")); Serial.println(mfrc522.GetStatusCodeName(status)); }
+    byte done = 0;
+    for (byte i = 0; i < count; i++) {
+        if (mfrc522.PICC_InventorySelect(&uids[i]) != MFRC522::STATUS_OK) { Serial.println(F("Batch: card left the field.")); continue; }
+        mfrc522.uid = uids[i];
+        if (beginSession() && process(context)) done++;
+        finalizeCardInteraction();
+    }
+    const uint32_t elapsed = millis() - start;
+    Serial.print(F("Batch: ")); Serial.print(done); Serial.print(F("/")); Serial.print(count);
+    Serial.print(F(" cards, ")); Serial.print(elapsed ? (uint32_t)done * 60000UL / elapsed : 0); Serial.println(F(" cards/min"));
+    return done;
+}
+void finalizeCardInteraction() { cardSession->end(); Serial.println(F("")); }
+
+/**
+ * @brief Wakes up and selects the card of the last interaction again, eg after a prompt.
+ * Uses the cached UID (WUPA + SELECT, no anticollision). Fails if that card is gone; a different card is halted again.
+ */
+bool reconnectCardInteraction() {
+    MFRC522::Uid previous = mfrc522.uid;
+    if (mfrc522.PICC_Reselect(&mfrc522.uid) != MFRC522::STATUS_OK) return false;
+    if (mfrc522.uid.size != previous.size || memcmp(mfrc522.uid.uidByte, previous.uidByte, previous.size) != 0) {
+        Serial.println(F("Different card, scan again."));
+        mfrc522.PICC_HaltA();
+        mfrc522.uid = previous;
+        return false;
+    }
+    return beginSession();
+}
+
+// =========================================================================
+// NFC Low-Level Read/Write & Helpers (Unchanged)
+// =========================================================================
+bool isUserDataBlock(byte blockAddr) { return MifareClassicLayout::isDataBlock(classicLayout, blockAddr); }
+bool authenticateBlock(byte blockAddr) { MFRC522::StatusCode status = classicSession.authenticate(blockAddr); if (status != MFRC522::STATUS_OK) { Serial.print(F("Auth Error (Block ")); Serial.print(blockAddr); Serial.print(F("): ")); Serial.println(mfrc522.GetStatusCodeName(status)); return false; } return true; }
+bool readBlockFromNfc(byte blockAddr, byte buffer[], byte bufferSize) { if (bufferSize < 18) { Serial.println(F("Read buffer too small (<18)")); return false; } MFRC522::StatusCode status = mfrc522.MIFARE_Read(blockAddr, buffer, &bufferSize); if (status != MFRC522::STATUS_OK) { Serial.print(F("Read Error (Block ")); Serial.print(blockAddr); Serial.print(F("): ")); Serial.println(mfrc522.GetStatusCodeName(status)); return false; } return true; }
+bool writeBlockToNfc(byte blockAddr, byte buffer[], byte bufferSize) { if (bufferSize != BLOCK_SIZE) { Serial.print(F("Write Error: Buffer size must be ")); Serial.println(BLOCK_SIZE); return false; } if (!isUserDataBlock(blockAddr)) { Serial.print(F("Write Error: Attempt to write non-user block ")); Serial.println(blockAddr); return false; } MFRC522::StatusCode status = mfrc522.MIFARE_Write(blockAddr, buffer, BLOCK_SIZE); if (status != MFRC522::STATUS_OK) { Serial.print(F("Write Error (Block ")); Serial.print(blockAddr); Serial.print(F("): ")); Serial.println(mfrc522.GetStatusCodeName(status)); return false; } return true; }
+
+// =========================================================================
+// User Data Area Functions (MODIFIED for Encryption)
+// =========================================================================
+
+// Authentications (MIFARE Classic) or FAST_READ frames (NTAG), throughput and retries of the session on the current card so far.
+static void printSessionStats() {
+    Serial.print(F("Session: "));
+    if (cardSession == &ntagSession) { Serial.print(ntagSession.stats().fastReads); Serial.print(F(" FAST_READ, ")); }
+    else { Serial.print(classicSession.stats().authentications); Serial.print(F(" auth, ")); }
+    Serial.print(cardSession->bytesPerSecond()); Serial.print(F(" B/s"));
+    const CardSession::RetryStats &retries = cardSession->retryStats();
+    if (retries.retries > 0) { Serial.print(F(", ")); Serial.print(retries.retries); Serial.print(F(" retries, ")); Serial.print(retries.reselects); Serial.print(F(" reselects")); }
+    Serial.println();
+}
+
+// -------------------------------------------------------------------------
+// Slots: two copies of a record, A and B, each a header block followed by its payload blocks, after block 0. A write
+// goes to the slot that does not hold the current record and is committed by the write of its header block; the
+// newer slot whose CRC matches is the record. A write that is cut short leaves the other slot, and with it the
+// previous record, as it was. The vault directory is kept this way, see the Credential Vault section.
+// -------------------------------------------------------------------------
+struct RecordSlot {
+    uint16_t sequence; // Incremented by every write, compared with wraparound
+    byte type;
+    uint16_t length;
+    uint16_t crc; // Of the first six header bytes and the payload
+};
+
+// Offset of the header block of slot index, its payload follows.
+static uint16_t slotOffset(byte index, byte payloadBlocks) { return (1 + index * (1 + payloadBlocks)) * BLOCK_SIZE; }
+
+// CRC-16/CCITT-FALSE, continued from crc.
+static uint16_t crc16(uint16_t crc, const byte data[], uint16_t length) {
+    while (length--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (byte bit = 0; bit < 8; bit++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+// False if the block cannot be the header of slot index: another index, a payload longer than the slot or
+// reserved bytes that are not zero (a block that never held a slot header).
+static bool decodeSlotHeader(const byte block[], byte index, byte payloadBlocks, RecordSlot &slot) {
+    slot.sequence = (uint16_t)(block[1] << 8) | block[0];
+    slot.type = block[2];
+    slot.length = (uint16_t)(block[4] << 8) | block[3];
+    slot.crc = (uint16_t)(block[7] << 8) | block[6];
+    if (block[5] != index || slot.length > payloadBlocks * BLOCK_SIZE) return false;
+    for (byte i = SLOT_HEADER_SIZE; i < BLOCK_SIZE; i++) if (block[i] != 0) return false;
+    return true;
+}
+
+static void encodeSlotHeader(const RecordSlot &slot, byte index, const byte payload[], byte block[]) {
+    memset(block, 0, BLOCK_SIZE);
+    block[0] = (byte)(slot.sequence & 0xFF);
+    block[1] = (byte)(slot.sequence >> 8);
+    block[2] = slot.type;
+    block[3] = (byte)(slot.length & 0xFF);
+    block[4] = (byte)(slot.length >> 8);
+    block[5] = index;
+    const uint16_t crc = crc16(crc16(0xFFFF, block, 6), payload, slot.length);
+    block[6] = (byte)(crc & 0xFF);
+    block[7] = (byte)(crc >> 8);
+}
+
+// A payload as it is read: with checkCrc the CRC over the stored bytes, then decryption in place one AES block at a
+// time, each while the next card block is on the air (CardSession::readStream()). The plaintext is there when the
+// read returns.
+struct PayloadStream {
+    byte *data; // Start of the payload
+    uint16_t preloaded; // Bytes of data that were there before the read, eg from the header block
+    uint16_t done; // Bytes run through the CRC and, with decrypt, decrypted
+    uint16_t crc; // Continued only with checkCrc
+    bool checkCrc; // Only slots carry a CRC to verify
+    bool decrypt;
+};
+
+static void onPayloadRead(uint16_t received, void *context) {
+    PayloadStream &stream = *(PayloadStream *)context;
+    const uint16_t available = stream.preloaded + received;
+    const uint16_t end = stream.decrypt ? available / 16 * 16 : available;
+    if (stream.checkCrc) stream.crc = crc16(stream.crc, stream.data + stream.done, end - stream.done);
+    if (stream.decrypt) {
+        for (uint16_t i = stream.done; i < end; i += 16) aes128_dec_single(aes_key, stream.data + i);
+    }
+    stream.done = end;
+}
+
+/**
+ * @brief Finds the slot that holds the record: the newer of the two whose CRC matches the payload.
+ * @param headers Filled with the header blocks of both slots.
+ * @param payload Receives the payload of that slot.
+ * @return Slot index, -1 if payload is too small, -2 if neither slot is valid, -3 on a read error.
+ */
+static int findLiveSlot(byte payloadBlocks, byte headers[SLOT_COUNT][BLOCK_SIZE], RecordSlot &live, byte payload[], int capacity) {
+    RecordSlot slots[SLOT_COUNT];
+    bool plausible[SLOT_COUNT];
+    for (byte index = 0; index < SLOT_COUNT; index++) {
+        MFRC522::StatusCode status = cardSession->readRange(slotOffset(index, payloadBlocks), headers[index], BLOCK_SIZE);
+        if (status != MFRC522::STATUS_OK) { Serial.print(F("Read Error: Slot header: ")); Serial.println(mfrc522.GetStatusCodeName(status)); return -3; }
+        plausible[index] = decodeSlotHeader(headers[index], index, payloadBlocks, slots[index]);
+    }
+    const byte newer = (plausible[1] && (!plausible[0] || (int16_t)(slots[1].sequence - slots[0].sequence) > 0)) ? 1 : 0;
+    for (byte n = 0; n < SLOT_COUNT; n++) {
+        const byte index = n ? 1 - newer : newer;
+        const RecordSlot &slot = slots[index];
+        if (!plausible[index]) continue;
+        if ((int)slot.length > capacity) { Serial.println(F("Read Error: Buffer too small")); return -1; }
+        uint16_t crc = crc16(0xFFFF, headers[index], 6);
+        const uint16_t offset = slotOffset(index, payloadBlocks) + BLOCK_SIZE;
+        PayloadStream stream = {payload, 0, 0, crc, true, false};
+        MFRC522::StatusCode status = cardSession->readStream(offset, payload, slot.length, onPayloadRead, &stream);
+        crc = stream.crc;
+        if (status != MFRC522::STATUS_OK) { Serial.print(F("Read Error: Slot payload: ")); Serial.println(mfrc522.GetStatusCodeName(status)); return -3; }
+        if (crc == slot.crc) { live = slot; return index; }
+        Serial.print(F("Slot ")); Serial.print((char)('A' + index)); Serial.println(F(": CRC mismatch, write was cut short"));
+    }
+    return -2;
+}
+
+// Payload of slot index, then its header block, which commits it. Only payload bytes first..end-1 may differ from what
+// the slot holds; the rest is already there. unitsWritten counts the blocks/pages written.
+static MFRC522::StatusCode writeSlot(byte index, const RecordSlot &slot, const byte payload[], byte payloadBlocks, uint16_t &unitsWritten,
+                                     uint16_t first = 0, uint16_t end = 0xFFFF) {
+    MFRC522::StatusCode status = MFRC522::STATUS_OK;
+    end = min(end, slot.length);
+    if (first < end) status = cardSession->updateRange(slotOffset(index, payloadBlocks) + BLOCK_SIZE + first, payload + first, end - first, &unitsWritten);
+    if (status != MFRC522::STATUS_OK) return status;
+    byte block[BLOCK_SIZE];
+    encodeSlotHeader(slot, index, payload, block);
+    status = cardSession->writeRange(slotOffset(index, payloadBlocks), block, BLOCK_SIZE);
+    if (status == MFRC522::STATUS_OK) unitsWritten += BLOCK_SIZE / cardSession->writeUnit();
+    return status;
+}
+
+// Plaintext length of a payload read (and decrypted) by onPayloadRead().
+static int payloadLength(byte dataType, uint16_t storedLength, const byte dataBuffer[], uint16_t* dataLength) {
+    if (dataType == DATA_TYPE_PASSWORD_ENC) {
+        // The buffer is null-terminated by the padding applied before encryption
+        *dataLength = strnlen((const char*)dataBuffer, storedLength); // Update output length to plaintext length
+        // Optional: Zero out the rest of the buffer after the null terminator for security
+        // memset(dataBuffer + *dataLength, 0, bufferCapacity - *dataLength);
+        Serial.print("Decrypted Length: "); Serial.println(*dataLength);
+    } else {
+        // For plaintext, the output length is the stored length
+        *dataLength = storedLength;
+    }
+
+    // Return the number of *meaningful* bytes (plaintext length)
+    return *dataLength;
+}
+
+/**
+ * @brief Reads header and payload from the user data area.
+ * Handles decryption if the data type indicates encrypted data.
+ *
+ * @param dataType Pointer to store the read data type code (output).
+ * @param dataLength Pointer to store the final payload length (plaintext length) (output).
+ * @param dataBuffer Buffer to store the final payload data (plaintext) (output).
+ * @param bufferCapacity The maximum size of dataBuffer.
+ * @return The number of plaintext payload bytes successfully read, or negative error code.
+ */
+int readUserDataFromNfc(byte* dataType, uint16_t* dataLength, byte dataBuffer[], int bufferCapacity) {
+    byte firstBlockBuffer[BLOCK_SIZE];
+    *dataType = DATA_TYPE_NONE;
+    *dataLength = 0; // This will store the length read from header (plain or cipher) initially
+    uint16_t storedLength = 0; // Use a separate variable for header length
+
+    // Read the first block containing the header
+    MFRC522::StatusCode status = cardSession->readRange(0, firstBlockBuffer, BLOCK_SIZE);
+    if (status != MFRC522::STATUS_OK) {
+        Serial.print(F("Read Error: Header: ")); Serial.println(mfrc522.GetStatusCodeName(status));
+        return -3;
+    }
+
+    // Parse header. HEADER_FLAG_HWM marks the current header, cards written before the high-water mark have the legacy one.
+    const byte headerSize = (firstBlockBuffer[0] & HEADER_FLAG_HWM) ? HEADER_SIZE : LEGACY_HEADER_SIZE;
+    *dataType = firstBlockBuffer[0] & ~HEADER_FLAG_HWM;
+    storedLength = (uint16_t)(firstBlockBuffer[2] << 8) | firstBlockBuffer[1]; // Length of stored data
+
+    // Validate header data
+    if (headerSize + storedLength > TOTAL_USER_AREA_SIZE || headerSize + storedLength > cardSession->capacity()) { Serial.print(F("Read Error: Invalid header length")); return -2; }
+    // For encrypted data, stored length must be multiple of 16 (unless 0)
+    if (*dataType == DATA_TYPE_PASSWORD_ENC && storedLength > 0 && (storedLength % 16 != 0)) { Serial.print(F("Read Error: Enc len not mult 16")); return -2; }
+    // Check if buffer can hold the *stored* data (might be ciphertext)
+    if ((int)storedLength > bufferCapacity) { Serial.print(F("Read Error: Buffer too small")); return -1; }
+
+    if (storedLength == 0) {
+        *dataLength = 0; // Ensure output length is 0
+        return 0; // Valid header, zero length payload
+    }
+
+    // --- Read the payload (encrypted or plaintext) into dataBuffer ---
+    int bytesSuccessfullyRead = 0;
+    int payloadBytesReadFromFirstBlock = min((int)(BLOCK_SIZE - headerSize), (int)storedLength);
+    if (payloadBytesReadFromFirstBlock > 0) {
+         memcpy(dataBuffer, firstBlockBuffer + headerSize, payloadBytesReadFromFirstBlock);
+         bytesSuccessfullyRead += payloadBytesReadFromFirstBlock;
+    }
+
+    // The rest of the payload follows the first block. A MIFARE Classic session keeps sector 0 open from the header read,
+    // on NTAG it is one FAST_READ per 60 bytes. Encrypted data is decrypted 16 bytes at a time as it comes in.
+    PayloadStream stream = {dataBuffer, (uint16_t)bytesSuccessfullyRead, 0, 0, false, *dataType == DATA_TYPE_PASSWORD_ENC};
+    if (bytesSuccessfullyRead < (int)storedLength) {
+        status = cardSession->readStream(BLOCK_SIZE, dataBuffer + bytesSuccessfullyRead, storedLength - bytesSuccessfullyRead, onPayloadRead, &stream);
+        if (status != MFRC522::STATUS_OK) { Serial.print(F("Read Error: Payload: ")); Serial.println(mfrc522.GetStatusCodeName(status)); return -3; }
+        bytesSuccessfullyRead = storedLength;
+    } else {
+        onPayloadRead(0, &stream);
+    }
+    printSessionStats();
+
+    return payloadLength(*dataType, storedLength, dataBuffer, dataLength);
+}
+
+
+// Bytes at the start of the user area the write before may have left data in, from the header it wrote. The legacy
+// header did not record a high-water mark, but its writer zeroed everything after the payload. Anything else is unknown.
+static int usedBytes(const byte header[], int userAreaSize) {
+    if (header[0] & HEADER_FLAG_HWM) return header[3] * BLOCK_SIZE;
+    const uint16_t storedLength = (uint16_t)(header[2] << 8) | header[1];
+    if (header[0] > DATA_TYPE_PASSWORD_ENC || LEGACY_HEADER_SIZE + storedLength > userAreaSize) return userAreaSize;
+    return (LEGACY_HEADER_SIZE + storedLength + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+}
+
+/**
+ * @brief Writes header and payload, encrypting if necessary.
+ * Takes PLAINTEXT payload as input.
+ *
+ * Only blocks that change are written, see usedBytes() for how far the old data is cleared.
+ *
+ * @param dataType The data type code (e.g., DATA_TYPE_PASSWORD_ENC).
+ * @param plainPayloadBuffer Buffer containing the PLAINTEXT data to write.
+ * @param plainPayloadLength The number of bytes in plainPayloadBuffer to write.
+ * @return true if all writes were successful, false otherwise.
+ */
+bool writeUserDataToNfc(byte dataType, byte plainPayloadBuffer[], uint16_t plainPayloadLength) {
+    byte dataToWrite[TOTAL_USER_AREA_SIZE]; // Temp buffer for header + (padded/encrypted) data
+    uint16_t finalStoredLength = 0; // Length of data to be stored on card (plain or cipher)
+
+    // --- Prepare data (Encrypt and Pad if needed) ---
+    if (dataType == DATA_TYPE_PASSWORD_ENC) {
+        Serial.println("Encrypting data...");
+        // Calculate padded length (must be multiple of 16)
+        // Include space for null terminator before padding calculation
+        uint16_t lengthWithNull = plainPayloadLength + 1;
+        uint16_t paddedLength = lengthWithNull;
+        if (paddedLength % 16 != 0) {
+            paddedLength = ((paddedLength / 16) + 1) * 16;
+        }
+
+        // Check if padded data exceeds storage capacity
+        if (paddedLength > MAX_PAYLOAD_SIZE) {
+            Serial.println("Write Error: Payload too large after padding.");
+            return false;
+        }
+
+        // Create padded buffer dynamically or use a sufficiently large global/static one if memory is tight
+        // Using dynamic allocation here for clarity, ensure enough heap space or use static buffer
+        byte paddedData[paddedLength]; // VLA - use with caution or make static/global
+        if (!paddedData) { Serial.println("Write Error: Mem alloc fail"); return false; } // Check allocation
+
+        memcpy(paddedData, plainPayloadBuffer, plainPayloadLength);
+        // Add null terminator and pad with nulls (important for decryption length recovery)
+        memset(paddedData + plainPayloadLength, 0, paddedLength - plainPayloadLength);
+
+        Serial.print("Plain Length: "); Serial.println(plainPayloadLength);
+        Serial.print("Padded Length: "); Serial.println(paddedLength);
+
+        // Encrypt the padded data IN PLACE
+        uint16_t numBlocks = paddedLength / 16;
+        for (uint16_t i = 0; i < numBlocks; i++) {
+             aes128_enc_single(aes_key, paddedData + i * 16);
+        }
+
+        // Prepare the final buffer to write (Header + Encrypted Padded Data)
+        finalStoredLength = paddedLength; // Header stores the encrypted length
+        dataToWrite[0] = dataType | HEADER_FLAG_HWM;
+        dataToWrite[1] = (byte)(finalStoredLength & 0xFF);
+        dataToWrite[2] = (byte)((finalStoredLength >> 8) & 0xFF);
+        memcpy(dataToWrite + HEADER_SIZE, paddedData, finalStoredLength);
+
+    } else {
+        // Handle plaintext or other types (no encryption/padding needed)
+        finalStoredLength = plainPayloadLength; // Header stores plaintext length
+        if (finalStoredLength > MAX_PAYLOAD_SIZE) {
+             Serial.println("Write Error: Payload too large.");
+             return false;
+        }
+        dataToWrite[0] = dataType | HEADER_FLAG_HWM;
+        dataToWrite[1] = (byte)(finalStoredLength & 0xFF);
+        dataToWrite[2] = (byte)((finalStoredLength >> 8) & 0xFF);
+        memcpy(dataToWrite + HEADER_SIZE, plainPayloadBuffer, finalStoredLength);
+    }
+
+    // --- Write the prepared data (dataToWrite) to NFC ---
+    int totalBytesToWrite = HEADER_SIZE + finalStoredLength; // Total bytes including header
+    int blocksNeeded = (totalBytesToWrite + BLOCK_SIZE - 1) / BLOCK_SIZE; // Blocks for header+data
+
+    Serial.print("Total bytes to write to card (incl. header): "); Serial.println(totalBytesToWrite);
+    Serial.print("Blocks needed for data: "); Serial.println(blocksNeeded);
+
+    // The user data area is the smaller of the layout and the card: NTAG213/215 hold less than the 752 bytes of a 1K.
+    const int userAreaSize = min(TOTAL_USER_AREA_SIZE, (int)cardSession->capacity());
+    if (totalBytesToWrite > userAreaSize) {
+        Serial.println("Write Error: Payload too large for this card.");
+        return false;
+    }
+
+    // The header on the card tells how far the last write may have left data (its high-water mark).
+    byte oldHeader[BLOCK_SIZE];
+    MFRC522::StatusCode status = cardSession->readRange(0, oldHeader, BLOCK_SIZE);
+    if (status != MFRC522::STATUS_OK) {
+        Serial.print(F("Write Error: Header: ")); Serial.println(mfrc522.GetStatusCodeName(status));
+        return false;
+    }
+    const int newEnd = min(blocksNeeded * BLOCK_SIZE, userAreaSize);
+    const int end = max(newEnd, min(usedBytes(oldHeader, userAreaSize), userAreaSize));
+    dataToWrite[3] = (byte)blocksNeeded;
+    Serial.print("Zeroing up to old high-water mark, block "); Serial.println((end + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+    // Header + data, then zeros up to the old high-water mark; past it the card is already zero. Only the blocks
+    // (pages on NTAG) that differ from the card are written, so the time follows the size of the change.
+    // The first block goes last, so a write that is cut short leaves the old header in place.
+    memset(dataToWrite + totalBytesToWrite, 0, end - totalBytesToWrite);
+    uint16_t unitsWritten = 0;
+    if (end > BLOCK_SIZE) {
+        status = cardSession->updateRange(BLOCK_SIZE, dataToWrite + BLOCK_SIZE, end - BLOCK_SIZE, &unitsWritten);
+    }
+    if (status == MFRC522::STATUS_OK && memcmp(oldHeader, dataToWrite, BLOCK_SIZE) != 0) {
+        status = cardSession->writeRange(0, dataToWrite, BLOCK_SIZE);
+        unitsWritten += BLOCK_SIZE / cardSession->writeUnit();
+    }
+    if (status != MFRC522::STATUS_OK) {
+        Serial.print(F("Write Error: ")); Serial.println(mfrc522.GetStatusCodeName(status));
+        return false;
+    }
+    Serial.print("Changed blocks/pages written: "); Serial.println(unitsWritten);
+    printSessionStats();
+
+    return true;
+}
+
+// =========================================================================
+// Credential Vault
+// =========================================================================
+// Block 0 of the user area is the header: [DATA_TYPE_VAULT | HEADER_FLAG_HWM][0][0][high-water mark: the whole user
+// area][VAULT_VERSION][directory entries], written only by formatVault(). The directory follows in two copies, A and
+// B, kept like the two slots of a record: a slot header block, then VAULT_ENTRY_SIZE bytes per entry. The entries
+// come after both copies, on whole blocks: the label in the first block, then the password NUL-padded to a multiple
+// of 16. Only the directory is read to open a vault; reading one entry touches its own blocks. An update writes the
+// entry to free blocks, then the whole directory to the copy that is not current; the header block of that copy
+// commits it. A write cut short before it leaves the vault as it was.
+
+static int vaultUserBlocks() { return cardSession->capacity() / BLOCK_SIZE; }
+static byte vaultDirectoryBlocks(byte capacity) { return (capacity * VAULT_ENTRY_SIZE + BLOCK_SIZE - 1) / BLOCK_SIZE; }
+static byte vaultBlocks(const VaultEntry &entry) { return (entry.length + BLOCK_SIZE - 1) / BLOCK_SIZE; }
+// First block after both directory copies.
+static byte vaultDataStart(byte capacity) { return slotOffset(SLOT_COUNT, vaultDirectoryBlocks(capacity)) / BLOCK_SIZE; }
+
+// FNV-1a, folded to 16 bits.
+static uint16_t vaultLabelHash(const char *label) {
+    uint32_t hash = 2166136261UL;
+    while (*label) { hash ^= (byte)*label++; hash *= 16777619UL; }
+    return (uint16_t)(hash >> 16) ^ (uint16_t)hash;
+}
+
+static void decodeVaultEntry(const byte raw[], VaultEntry &entry) {
+    entry.slotId = raw[0];
+    entry.flags = raw[1];
+    entry.labelHash = (uint16_t)(raw[3] << 8) | raw[2];
+    entry.firstBlock = raw[4];
+    entry.length = (uint16_t)(raw[6] << 8) | raw[5];
+}
+
+static void encodeVaultEntry(const VaultEntry &entry, byte raw[]) {
+    raw[0] = entry.slotId;
+    raw[1] = entry.flags;
+    raw[2] = (byte)(entry.labelHash & 0xFF);
+    raw[3] = (byte)(entry.labelHash >> 8);
+    raw[4] = entry.firstBlock;
+    raw[5] = (byte)(entry.length & 0xFF);
+    raw[6] = (byte)(entry.length >> 8);
+    raw[7] = 0;
+}
+
+// Directory position of the index-th used entry, -1 if there is none.
+static int vaultPosition(byte index) {
+    for (byte position = 0; position < vaultCapacity; position++) {
+        if (vaultDirectory[position].slotId != 0 && index-- == 0) return position;
+    }
+    return -1;
+}
+
+/**
+ * @brief Writes the directory, with entry at position and the other entries as they are, to the copy that is not
+ * current; its header block commits it. That copy is the directory of the commit before, so only the blocks of
+ * position and vaultStale are written. vaultSequence and vaultCopy follow once it is written, vaultDirectory does not change.
+ */
+static bool writeVaultDirectory(byte position, const VaultEntry &entry) {
+    byte raw[VAULT_MAX_ENTRIES * VAULT_ENTRY_SIZE];
+    for (byte i = 0; i < vaultCapacity; i++) encodeVaultEntry(i == position ? entry : vaultDirectory[i], raw + i * VAULT_ENTRY_SIZE);
+    RecordSlot slot;
+    slot.sequence = vaultSequence + 1;
+    slot.type = DATA_TYPE_VAULT;
+    slot.length = vaultCapacity * VAULT_ENTRY_SIZE;
+    const byte copy = 1 - vaultCopy;
+    uint16_t first = 0, end = slot.length;
+    if (vaultStale < vaultCapacity) {
+        first = min(position, vaultStale) * VAULT_ENTRY_SIZE / BLOCK_SIZE * BLOCK_SIZE;
+        end = (max(position, vaultStale) * VAULT_ENTRY_SIZE / BLOCK_SIZE + 1) * BLOCK_SIZE;
+    }
+    uint16_t unitsWritten = 0;
+    MFRC522::StatusCode status = writeSlot(copy, slot, raw, vaultDirectoryBlocks(vaultCapacity), unitsWritten, first, end);
+    if (status != MFRC522::STATUS_OK) {
+        vaultStale = 0xFF; // The other copy may hold part of this write
+        Serial.print(F("Vault Error: Directory: ")); Serial.println(mfrc522.GetStatusCodeName(status));
+        return false;
+    }
+    vaultSequence = slot.sequence;
+    vaultCopy = copy;
+    vaultStale = position;
+    return true;
+}
+
+// A slot id no entry uses, from vaultNextSlotId on and wrapping from 255 to 1. 0 if all are taken.
+static byte freeVaultSlotId() {
+    byte id = vaultNextSlotId ? vaultNextSlotId : 1;
+    for (int tries = 0; tries < 0xFF; tries++, id = (id == 0xFF) ? 1 : id + 1) {
+        bool used = false;
+        for (byte position = 0; position < vaultCapacity && !used; position++) used = vaultDirectory[position].slotId == id;
+        if (!used) return id;
+    }
+    return 0;
+}
+
+// First run of free blocks after the directory, clear of every listed entry. 0 if the vault is full.
+static byte allocateVaultBlocks(byte blocks) {
+    const int end = vaultUserBlocks();
+    int candidate = vaultDataStart(vaultCapacity);
+    for (byte position = 0; position < vaultCapacity && candidate + blocks <= end; position++) {
+        const VaultEntry &entry = vaultDirectory[position];
+        if (entry.slotId == 0) continue;
+        if (entry.firstBlock < candidate + blocks && candidate < entry.firstBlock + vaultBlocks(entry)) {
+            candidate = entry.firstBlock + vaultBlocks(entry);
+            position = 0xFF; // Start over (wraps to 0): an earlier entry may overlap the new candidate
+        }
+    }
+    return (candidate + blocks <= end) ? (byte)candidate : 0;
+}
+
+/**
+ * @brief Reads the vault header and the current directory copy of the current card; the entries themselves are not read.
+ * @return Number of entries, -2 if the header or both directory copies are invalid, -3 on a read error, -4 if the
+ * card holds no vault.
+ */
+int openVault() {
+    vaultCapacity = 0;
+    byte block[BLOCK_SIZE];
+    MFRC522::StatusCode status = cardSession->readRange(0, block, BLOCK_SIZE);
+    if (status != MFRC522::STATUS_OK) { Serial.print(F("Vault Error: Header: ")); Serial.println(mfrc522.GetStatusCodeName(status)); return -3; }
+    if ((block[0] & ~HEADER_FLAG_HWM) != DATA_TYPE_VAULT) return -4;
+    const byte capacity = block[5];
+    const int userBlocks = vaultUserBlocks();
+    if (block[4] != VAULT_VERSION || capacity == 0 || capacity > VAULT_MAX_ENTRIES || vaultDataStart(capacity) > userBlocks) {
+        Serial.println(F("Vault Error: Invalid header"));
+        return -2;
+    }
+
+    byte headers[SLOT_COUNT][BLOCK_SIZE];
+    byte raw[VAULT_MAX_ENTRIES * VAULT_ENTRY_SIZE];
+    RecordSlot live = {0, 0, 0, 0};
+    const int copy = findLiveSlot(vaultDirectoryBlocks(capacity), headers, live, raw, capacity * VAULT_ENTRY_SIZE);
+    if (copy == -3) return -3;
+    if (copy < 0 || live.type != DATA_TYPE_VAULT || live.length != capacity * VAULT_ENTRY_SIZE) { Serial.println(F("Vault Error: Invalid directory")); return -2; }
+
+    byte count = 0;
+    byte lastSlotId = 0;
+    for (byte position = 0; position < capacity; position++) {
+        VaultEntry &entry = vaultDirectory[position];
+        decodeVaultEntry(raw + position * VAULT_ENTRY_SIZE, entry);
+        if (entry.slotId == 0) continue;
+        if (entry.firstBlock < vaultDataStart(capacity) || entry.firstBlock + vaultBlocks(entry) > userBlocks || entry.length <= VAULT_LABEL_SIZE
+            || entry.length % BLOCK_SIZE != 0) { Serial.println(F("Vault Error: Invalid directory entry")); return -2; }
+        lastSlotId = max(lastSlotId, entry.slotId);
+        count++;
+    }
+    vaultCapacity = capacity;
+    vaultCount = count;
+    vaultNextSlotId = (lastSlotId == 0xFF) ? 1 : lastSlotId + 1;
+    vaultSequence = live.sequence;
+    vaultCopy = copy;
+    vaultStale = 0xFF;
+    Serial.print(F("Vault: ")); Serial.print(count); Serial.print(F("/")); Serial.print(capacity); Serial.print(F(" entries, directory "));
+    Serial.println((char)('A' + copy));
+    return count;
+}
+
+/**
+ * @brief Writes an empty vault to the current card: the header and an empty directory, about one entry per four blocks.
+ * Block 0 first becomes an empty record, so the old header no longer points at anything while directory copy B is
+ * invalidated and copy A written empty; the vault header goes last. A format cut short leaves an empty card. Old
+ * data past the directory is left to be overwritten by new entries; the high-water mark covers the whole user area.
+ */
+bool formatVault() {
+    vaultCapacity = 0;
+    const int userBlocks = vaultUserBlocks();
+    const byte capacity = min((int)VAULT_MAX_ENTRIES, userBlocks / 4) & ~1;
+    if (capacity == 0 || vaultDataStart(capacity) >= userBlocks) { Serial.println(F("Vault Error: Card too small")); return false; }
+    const byte directoryBlocks = vaultDirectoryBlocks(capacity);
+
+    byte block[BLOCK_SIZE] = {0};
+    block[0] = DATA_TYPE_NONE | HEADER_FLAG_HWM;
+    block[3] = userBlocks;
+    MFRC522::StatusCode status = cardSession->updateRange(0, block, BLOCK_SIZE);
+    if (status != MFRC522::STATUS_OK) { Serial.print(F("Vault Error: Header: ")); Serial.println(mfrc522.GetStatusCodeName(status)); return false; }
+    // Copy B of an earlier vault could be newer than the empty copy A.
+    memset(block, 0, BLOCK_SIZE);
+    status = cardSession->updateRange(slotOffset(1, directoryBlocks), block, BLOCK_SIZE);
+    if (status != MFRC522::STATUS_OK) { Serial.print(F("Vault Error: Directory: ")); Serial.println(mfrc522.GetStatusCodeName(status)); return false; }
+    memset(vaultDirectory, 0, sizeof(vaultDirectory));
+    vaultCapacity = capacity;
+    vaultSequence = 0;
+    vaultCopy = 1; // The empty directory goes to copy A
+    vaultStale = 0xFF;
+    if (!writeVaultDirectory(0, vaultDirectory[0])) { vaultCapacity = 0; return false; }
+
+    block[0] = DATA_TYPE_VAULT | HEADER_FLAG_HWM;
+    block[3] = userBlocks;
+    block[4] = VAULT_VERSION;
+    block[5] = capacity;
+    status = cardSession->updateRange(0, block, BLOCK_SIZE);
+    if (status != MFRC522::STATUS_OK) { Serial.print(F("Vault Error: Header: ")); Serial.println(mfrc522.GetStatusCodeName(status)); vaultCapacity = 0; return false; }
+    vaultCount = 0;
+    vaultNextSlotId = 1;
+    Serial.print(F("Vault formatted: ")); Serial.print(capacity); Serial.println(F(" entries"));
+    return true;
+}
+
+byte vaultSize() { return vaultCapacity ? vaultCount : 0; }
+
+/**
+ * @brief Label of an entry: one block read.
+ */
+bool readVaultLabel(byte index, char label[VAULT_LABEL_SIZE]) {
+    const int position = vaultPosition(index);
+    if (position < 0) return false;
+    const VaultEntry &entry = vaultDirectory[position];
+    MFRC522::StatusCode status = cardSession->readRange(entry.firstBlock * BLOCK_SIZE, (byte *)label, VAULT_LABEL_SIZE);
+    if (status != MFRC522::STATUS_OK) { Serial.print(F("Vault Error: Label: ")); Serial.println(mfrc522.GetStatusCodeName(status)); return false; }
+    if (entry.flags & VAULT_FLAG_ENCRYPTED) aes128_dec_single(aes_key, label);
+    label[VAULT_LABEL_SIZE - 1] = '\0';
+    return true;
+}
+
+/**
+ * @brief Label and password of an entry, decrypted. Reads only the blocks of that entry.
+ * @return Password length, -1 if there is no such entry, password is too small or the entry too long, -3 on a read error.
+ */
+int readVaultEntry(byte index, char label[VAULT_LABEL_SIZE], byte password[], int capacity) {
+    const int position = vaultPosition(index);
+    if (position < 0) return -1;
+    const VaultEntry &entry = vaultDirectory[position];
+    const uint16_t secretLength = entry.length - VAULT_LABEL_SIZE;
+    if ((int)secretLength > capacity) { Serial.println(F("Vault Error: Buffer too small")); return -1; }
+    // Label and password in one read, each block decrypted while the next one is read.
+    byte data[VAULT_LABEL_SIZE + VAULT_MAX_SECRET];
+    if (entry.length > sizeof(data)) { Serial.println(F("Vault Error: Entry too long")); return -1; }
+    PayloadStream stream = {data, 0, 0, 0, false, (entry.flags & VAULT_FLAG_ENCRYPTED) != 0};
+    MFRC522::StatusCode status = cardSession->readStream(entry.firstBlock * BLOCK_SIZE, data, entry.length, onPayloadRead, &stream);
+    if (status != MFRC522::STATUS_OK) { Serial.print(F("Vault Error: Entry: ")); Serial.println(mfrc522.GetStatusCodeName(status)); return -3; }
+    printSessionStats();
+    memcpy(label, data, VAULT_LABEL_SIZE);
+    label[VAULT_LABEL_SIZE - 1] = '\0';
+    memcpy(password, data + VAULT_LABEL_SIZE, secretLength);
+    return strnlen((char *)password, secretLength);
+}
+
+/**
+ * @brief Finds an entry by label. Only entries with the same label hash have their label read.
+ */
+int findVaultEntry(const char *label) {
+    char wanted[VAULT_LABEL_SIZE] = {0};
+    strncpy(wanted, label, VAULT_LABEL_SIZE - 1);
+    const uint16_t hash = vaultLabelHash(wanted);
+    char candidate[VAULT_LABEL_SIZE];
+    for (byte index = 0; index < vaultSize(); index++) {
+        if (vaultDirectory[vaultPosition(index)].labelHash != hash) continue;
+        if (readVaultLabel(index, candidate) && strcmp(candidate, wanted) == 0) return index;
+    }
+    return -1;
+}
+
+/**
+ * @brief Stores label and password (PLAINTEXT, encrypted here) as entry index, or as a new entry for index -1.
+ * A card without an open vault is formatted first. The entry is written to the first free run, away from its old
+ * blocks, then the directory copy that is not current; the header block of that copy is the single write that
+ * switches to it. Entries are never updated in place: on a card without a free run for the new copy nothing is
+ * written and the old entry stays as it was. Blocks that already hold the same bytes are skipped.
+ */
+bool writeVaultEntry(int index, const char *label, const byte password[], uint16_t length) {
+    if (vaultCapacity == 0 && (index >= 0 || !formatVault())) return false;
+    const uint16_t paddedLength = (length / 16 + 1) * 16; // At least one NUL
+    if (paddedLength > VAULT_MAX_SECRET) { Serial.println(F("Vault Error: Password too long")); return false; }
+    int position = (index >= 0) ? vaultPosition(index) : -1;
+    if (index < 0) {
+        for (byte i = 0; i < vaultCapacity && position < 0; i++) if (vaultDirectory[i].slotId == 0) position = i;
+        if (position < 0) { Serial.println(F("Vault Error: Directory full")); return false; }
+    } else if (position < 0) {
+        return false;
+    }
+
+    byte data[VAULT_LABEL_SIZE + VAULT_MAX_SECRET];
+    const uint16_t dataLength = VAULT_LABEL_SIZE + paddedLength;
+    memset(data, 0, dataLength);
+    strncpy((char *)data, label, VAULT_LABEL_SIZE - 1);
+    memcpy(data + VAULT_LABEL_SIZE, password, length);
+    const uint16_t labelHash = vaultLabelHash((const char *)data); // Of the stored label, it may have been cut
+    for (uint16_t i = 0; i < dataLength; i += 16) aes128_enc_single(aes_key, data + i);
+
+    VaultEntry entry = vaultDirectory[position];
+    const byte blocks = dataLength / BLOCK_SIZE;
+    const bool added = entry.slotId == 0;
+    // Free blocks clear of the old copy, which stays listed until the directory copy is committed.
+    entry.firstBlock = allocateVaultBlocks(blocks);
+    if (entry.firstBlock == 0) { Serial.println(F("Vault Error: Vault full")); return false; }
+    if (added) {
+        entry.slotId = freeVaultSlotId();
+        if (entry.slotId == 0) { Serial.println(F("Vault Error: No free slot id")); return false; }
+    }
+    entry.flags = VAULT_FLAG_ENCRYPTED;
+    entry.labelHash = labelHash;
+    entry.length = dataLength;
+
+    uint16_t unitsWritten = 0;
+    MFRC522::StatusCode status = cardSession->updateRange(entry.firstBlock * BLOCK_SIZE, data, dataLength, &unitsWritten);
+    if (status != MFRC522::STATUS_OK) { Serial.print(F("Vault Error: Entry: ")); Serial.println(mfrc522.GetStatusCodeName(status)); return false; }
+    // The directory in RAM follows the card: it changes only once the directory copy is committed.
+    if (!writeVaultDirectory(position, entry)) return false;
+    vaultDirectory[position] = entry;
+    if (added) {
+        vaultCount++;
+        vaultNextSlotId = (entry.slotId == 0xFF) ? 1 : entry.slotId + 1;
+    }
+    Serial.print(F("Vault: entry ")); Serial.print(entry.slotId); Serial.print(F(", ")); Serial.print(unitsWritten); Serial.println(F(" blocks/pages of it written"));
+    printSessionStats();
+    return true;
+}
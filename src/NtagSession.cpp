@@ -0,0 +1,175 @@
+// NTAG213/215/216 access on top of MFRC522.
+#include "NtagSession.h"
+
+NtagSession::NtagSession(MFRC522 &reader, const byte *password)
+    : _reader(reader), _password(password), _userPages(0), _authenticated(false) {
+    memset(_pack, 0, sizeof(_pack));
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+/**
+ * @brief Identifies the tag with GET_VERSION. Tags without the command (MIFARE Ultralight, Ultralight C) answer
+ * with a NAK or not at all and go back to IDLE; select them again before using another session on them.
+ */
+MFRC522::StatusCode NtagSession::begin() {
+    _userPages = 0;
+    _authenticated = false;
+    memset(&_stats, 0, sizeof(_stats));
+    resetRetryStats();
+    byte version[10];
+    byte size = sizeof(version);
+    MFRC522::StatusCode status = _reader.MIFARE_Ultralight_GetVersion(version, &size);
+    if (status != MFRC522::STATUS_OK) {
+        return status;
+    }
+    if (version[2] == 0x04) {   // Product type NTAG
+        _userPages = userPagesFor(version[6]);
+    }
+    return _userPages ? MFRC522::STATUS_OK : MFRC522::STATUS_ERROR;
+}
+
+void NtagSession::end() {
+    _reader.PICC_HaltA();
+    _authenticated = false;
+}
+
+// User memory of NTAG213/215/216, NTAG213_215_216 datasheet table 4. It starts at page 4 and is followed by the configuration pages.
+byte NtagSession::userPagesFor(byte storageSize) {
+    switch (storageSize) {
+        case 0x0F: return 36;   // NTAG213, 144 bytes
+        case 0x11: return 126;  // NTAG215, 504 bytes
+        case 0x13: return 222;  // NTAG216, 888 bytes
+        default:   return 0;
+    }
+}
+
+/**
+ * @brief PWD_AUTH with the session password, once per session. A wrong password is answered with a NAK and the
+ * tag goes back to IDLE, like any other failed command.
+ */
+MFRC522::StatusCode NtagSession::authenticate() {
+    if (_password == nullptr || _authenticated) {
+        return MFRC522::STATUS_OK;
+    }
+    _stats.authentications++;
+    byte password[4];
+    memcpy(password, _password, sizeof(password));
+    MFRC522::StatusCode status = _reader.PCD_NTAG216_AUTH(password, _pack);
+    _authenticated = (status == MFRC522::STATUS_OK);
+    return status;
+}
+
+// FAST_READ of pages (at most MFRC522::FAST_READ_MAX_PAGES) into buffer, which must hold pages * 4 + 2 bytes.
+// A failed frame is sent again after recover() selected the tag again, with a new PWD_AUTH.
+MFRC522::StatusCode NtagSession::readPages(byte firstPage, byte pages, byte buffer[]) {
+    for (byte attempt = 0; ; attempt++) {
+        MFRC522::StatusCode status = authenticate();
+        if (status == MFRC522::STATUS_OK) {
+            byte size = pages * PAGE_SIZE + 2;
+            status = _reader.MIFARE_Ultralight_FastRead(firstPage, firstPage + pages - 1, buffer, &size);
+            if (status == MFRC522::STATUS_OK) {
+                _stats.fastReads++;
+                return MFRC522::STATUS_OK;
+            }
+        }
+        _authenticated = false;
+        if (!recover(_reader, status, attempt)) {
+            return status;
+        }
+    }
+}
+
+MFRC522::StatusCode NtagSession::writePage(byte page, byte data[PAGE_SIZE]) {
+    for (byte attempt = 0; ; attempt++) {
+        MFRC522::StatusCode status = authenticate();
+        if (status == MFRC522::STATUS_OK) {
+            status = _reader.MIFARE_Ultralight_Write(page, data, PAGE_SIZE);
+            if (status == MFRC522::STATUS_OK) {
+                _stats.pageWrites++;
+                _stats.bytesWritten += PAGE_SIZE;
+                return MFRC522::STATUS_OK;
+            }
+        }
+        _authenticated = false;
+        if (!recover(_reader, status, attempt)) {
+            return status;
+        }
+    }
+}
+
+/**
+ * @brief Reads length bytes starting at offset of the user memory, FAST_READ_MAX_PAGES pages per frame.
+ */
+MFRC522::StatusCode NtagSession::readRange(uint16_t offset, byte buffer[], uint16_t length) {
+    BusyTimer timer(_stats.busyMicros);
+    if ((uint32_t)offset + length > capacity()) {
+        return MFRC522::STATUS_INVALID;
+    }
+    MFRC522::StatusCode status = authenticate();
+    if (status != MFRC522::STATUS_OK) {
+        return status;
+    }
+    byte frame[MFRC522::FAST_READ_MAX_PAGES * PAGE_SIZE + 2];
+    while (length > 0) {
+        const byte skip = offset % PAGE_SIZE;
+        const byte pages = min((uint16_t)MFRC522::FAST_READ_MAX_PAGES, (uint16_t)((skip + length + PAGE_SIZE - 1) / PAGE_SIZE));
+        const uint16_t chunk = min((uint16_t)(pages * PAGE_SIZE - skip), length);
+        status = readPages(FIRST_USER_PAGE + offset / PAGE_SIZE, pages, frame);
+        if (status != MFRC522::STATUS_OK) {
+            return status;
+        }
+        memcpy(buffer, frame + skip, chunk);
+        _stats.bytesRead += chunk;
+        buffer += chunk;
+        offset += chunk;
+        length -= chunk;
+    }
+    return MFRC522::STATUS_OK;
+}
+
+/**
+ * @brief Writes length bytes starting at offset of the user memory, one WRITE per page.
+ * Pages only partly covered by the range are read first, so the bytes around it are kept.
+ */
+MFRC522::StatusCode NtagSession::writeRange(uint16_t offset, const byte buffer[], uint16_t length) {
+    BusyTimer timer(_stats.busyMicros);
+    if ((uint32_t)offset + length > capacity()) {
+        return MFRC522::STATUS_INVALID;
+    }
+    MFRC522::StatusCode status = authenticate();
+    if (status != MFRC522::STATUS_OK) {
+        return status;
+    }
+    byte pageBuffer[PAGE_SIZE + 2];
+    while (length > 0) {
+        const byte page = FIRST_USER_PAGE + offset / PAGE_SIZE;
+        const byte skip = offset % PAGE_SIZE;
+        const byte chunk = min((uint16_t)(PAGE_SIZE - skip), length);
+        if (chunk < PAGE_SIZE) {
+            status = readPages(page, 1, pageBuffer);
+            if (status != MFRC522::STATUS_OK) {
+                return status;
+            }
+            _stats.bytesRead += PAGE_SIZE;
+        }
+        memcpy(pageBuffer + skip, buffer, chunk);
+        status = writePage(page, pageBuffer);
+        if (status != MFRC522::STATUS_OK) {
+            return status;
+        }
+        buffer += chunk;
+        offset += chunk;
+        length -= chunk;
+    }
+    return MFRC522::STATUS_OK;
+}
+
+/**
+ * @brief Data bytes moved per second of session time, 0 before the first transfer.
+ */
+uint32_t NtagSession::bytesPerSecond() const {
+    if (_stats.busyMicros == 0) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)(_stats.bytesRead + _stats.bytesWritten) * 1000000UL) / _stats.busyMicros);
+}